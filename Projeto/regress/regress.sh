@@ -0,0 +1,108 @@
+#!/bin/sh
+# Golden image and performance regression harness.
+#
+# Renders every scene of scenes.txt offscreen at its fixed simulation time,
+# compares the frame with the scene's reference image (see imgcompare), and
+# compares its load and frame times with baseline.txt.
+#
+# usage: regress.sh [bin_dir] [--update-baseline]
+#   bin_dir            where engine, generator and imgcompare are (default ../bin)
+#   --update-baseline  store the measured timings as the new baseline
+# environment:
+#   REGRESS_FRAMES     frames rendered to time each scene (default 120)
+#   REGRESS_SLOWDOWN   ratio to the baseline above which a timing regressed (default 1.25)
+#   REGRESS_RENDERER   fixed or shader (default fixed)
+# Exits with 1 when any scene differs from its reference or regressed.
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(dirname "$here")
+bin=$(cd "${1:-$root/bin}" && pwd) || exit 2
+update=0
+[ "${2:-}" = "--update-baseline" ] && update=1
+
+FRAMES=${REGRESS_FRAMES:-120}
+SLOWDOWN=${REGRESS_SLOWDOWN:-1.25}
+RENDERER=${REGRESS_RENDERER:-fixed}
+SIZE=800x800 # client area of the reference screenshots
+SLACK_MS=0.5 # timings this close to the baseline never regress, whatever the ratio
+
+out=$here/out
+mkdir -p "$out"
+baseline=$here/baseline.txt
+measured=$out/baseline.txt
+sed -n '/^#/p' "$baseline" > "$measured"
+
+# whether $1 > $2 * SLOWDOWN + SLACK_MS
+regressed ()
+{
+  awk -v value="$1" -v base="$2" -v ratio="$SLOWDOWN" -v slack="$SLACK_MS" \
+      'BEGIN { exit !(value > base * ratio + slack) }'
+}
+
+# runs the engine on the current scene, from its directory
+engine ()
+{
+  (cd "$root/$dir" && "$bin/engine" -r "$RENDERER" -s "$SIZE" -T "$time" $options "$@" "$xml") < /dev/null
+}
+
+failures=0
+printf '%-10s %-40s %10s %10s  %s\n' scene image load_ms frame_ms timing
+while read -r dir xml reference time options setup; do
+  case "$dir" in
+    '' | '#'*) continue ;;
+  esac
+  scene=${xml%.xml}
+  [ "$options" = - ] && options=
+  [ "$setup" = - ] && setup=true
+
+  (cd "$root/$dir" && PATH="$bin:$PATH" && eval "$setup") < /dev/null > "$out/$scene.log" 2>&1
+
+  image=-
+  if [ "$reference" != - ]; then
+    rm -f "$out/${scene}_0000.png"
+    engine -n 1 -o "$out/${scene}_" > /dev/null 2>> "$out/$scene.log"
+    if image=$("$bin/imgcompare" -d "$out/${scene}_diff.png" "$root/$dir/$reference" "$out/${scene}_0000.png"); then
+      image="ok, $image"
+    else
+      image="DIFFERENT, $image"
+      failures=$((failures + 1))
+    fi
+  fi
+
+  # cpu_ms of every frame on stdout, the load time on stderr
+  engine -n "$FRAMES" > "$out/$scene.csv" 2> "$out/$scene.timing.log"
+  cat "$out/$scene.timing.log" >> "$out/$scene.log"
+  rm -f "$root/$dir"/*.3d
+  load_ms=$(sed -n 's/.*scene loaded in \([0-9.e+-]*\) ms.*/\1/p' "$out/$scene.timing.log")
+  frame_ms=$(tail -n +2 "$out/$scene.csv" | cut -d, -f2 | sort -n |
+             awk '{ v[NR] = $1 } END { if (NR) print (NR % 2 ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2) }')
+  if [ -z "$load_ms" ] || [ -z "$frame_ms" ]; then
+    printf '%-10s %-40s %10s %10s  %s\n' "$scene" "$image" - - "FAILED, see $out/$scene.log"
+    failures=$((failures + 1))
+    continue
+  fi
+  echo "$scene $load_ms $frame_ms" >> "$measured"
+
+  timing="no baseline"
+  base=$(awk -v scene="$scene" '$1 == scene { print $2, $3 }' "$baseline")
+  if [ -n "$base" ]; then
+    base_load=${base% *}
+    base_frame=${base#* }
+    timing=ok
+    if regressed "$load_ms" "$base_load"; then
+      timing="SLOWER load (baseline $base_load ms)"
+      failures=$((failures + 1))
+    fi
+    if regressed "$frame_ms" "$base_frame"; then
+      timing="SLOWER frames (baseline $base_frame ms)"
+      failures=$((failures + 1))
+    fi
+  fi
+  printf '%-10s %-40s %10.3f %10.3f  %s\n' "$scene" "$image" "$load_ms" "$frame_ms" "$timing"
+done < "$here/scenes.txt"
+
+if [ "$update" = 1 ]; then
+  cp "$measured" "$baseline"
+  echo "baseline updated: $baseline"
+fi
+[ "$failures" = 0 ] || { echo "$failures regression(s), frames and diffs in $out"; exit 1; }
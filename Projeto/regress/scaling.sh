@@ -0,0 +1,49 @@
+#!/bin/sh
+# Scaling curves of the engine over synthetic scenes (see scenegen).
+#
+# Writes a scene for every size, renders it offscreen and prints, as CSV, its
+# number of groups with its load time and median frame time, ready to plot.
+#
+# usage: scaling.sh [bin_dir]
+#   bin_dir            where engine and scenegen are (default ../bin)
+# environment:
+#   SCALING_SIZES      depth x fanout of every scene (default "3x10 4x10 5x10 6x10", 10³ to 10⁶ groups)
+#   SCALING_OPTIONS    other scenegen options, e.g. "-a 1 -m 64 -t 8 -l 32"
+#   SCALING_FRAMES     frames rendered to time each scene (default 60)
+#   SCALING_RENDERER   fixed or shader (default shader)
+# The table is also saved to out/scaling.csv.
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(dirname "$here")
+bin=$(cd "${1:-$root/bin}" && pwd) || exit 2
+
+SIZES=${SCALING_SIZES:-3x10 4x10 5x10 6x10}
+FRAMES=${SCALING_FRAMES:-60}
+RENDERER=${SCALING_RENDERER:-shader}
+
+out=$here/out/scaling
+mkdir -p "$out"
+csv=$here/out/scaling.csv
+
+echo "depth,fanout,groups,load_ms,frame_ms" | tee "$csv"
+for size in $SIZES; do
+  depth=${size%x*}
+  fanout=${size#*x}
+  rm -f "$out"/*
+  # shellcheck disable=SC2086
+  groups=$("$bin/scenegen" -d "$depth" -f "$fanout" $SCALING_OPTIONS "$out/scene.xml" 2> /dev/null) || {
+    echo "scenegen failed for $size" >&2
+    exit 1
+  }
+  # cpu_ms of every frame on stdout, the load time on stderr
+  (cd "$out" && "$bin/engine" -r "$RENDERER" -n "$FRAMES" scene.xml) < /dev/null > "$out/frames.csv" 2> "$out/engine.log"
+  load_ms=$(sed -n 's/.*scene loaded in \([0-9.e+-]*\) ms.*/\1/p' "$out/engine.log")
+  frame_ms=$(tail -n +2 "$out/frames.csv" | cut -d, -f2 | sort -n |
+             awk '{ v[NR] = $1 } END { if (NR) print (NR % 2 ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2) }')
+  if [ -z "$load_ms" ] || [ -z "$frame_ms" ]; then
+    echo "engine failed for $size, see $out/engine.log" >&2
+    exit 1
+  fi
+  echo "$depth,$fanout,$groups,$load_ms,$frame_ms" | tee -a "$csv"
+done
+rm -f "$out"/*.3d "$out"/*.ppm
@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "arena.h"
+
+/*! @addtogroup arena
+ * @{
+ * Transient data of a frame, such as draw lists, visibility lists, job graphs and
+ * scratch strings, is bump allocated from an arena instead of the heap, and freed
+ * by resetting the arena when the frame is done with.
+ *
+ * The arena is a single block. A frame needing more than it holds gets the rest
+ * from the heap, and the next reset grows the block to what that frame needed, so
+ * after the first frames of a scene nothing is allocated at all and a reset is just
+ * the bump pointer going back to the start.
+ */
+
+//! the first block, before any frame told how much is needed
+const size_t ARENA_INITIAL_CAPACITY = 64 << 10;
+
+static size_t arena_align (const size_t offset, const size_t alignment)
+{
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+//! @param[in] alignment a power of two, at most alignof (std::max_align_t).
+void *arena_alloc (struct frame_arena &arena, const size_t bytes, const size_t alignment)
+{
+  if (!arena.block)
+    {
+      arena.capacity = std::max (ARENA_INITIAL_CAPACITY, arena.peak);
+      arena.block = std::make_unique<unsigned char[]> (arena.capacity);
+    }
+  const size_t offset = arena_align (arena.used, alignment);
+  if (offset + bytes <= arena.capacity)
+    {
+      arena.used = offset + bytes;
+      arena.peak = std::max (arena.peak, arena.used + arena.overflow_bytes);
+      return arena.block.get () + offset;
+    }
+
+  // operator new[] aligns for any fundamental type
+  arena.overflow.push_back (std::make_unique<unsigned char[]> (std::max<size_t> (bytes, 1)));
+  arena.overflow_bytes += bytes + alignment;
+  arena.peak = std::max (arena.peak, arena.used + arena.overflow_bytes);
+  return arena.overflow.back ().get ();
+}
+
+//! Frees everything allocated since the last reset, growing the block when it was too small.
+void arena_reset (struct frame_arena &arena)
+{
+  if (!arena.overflow.empty ())
+    {
+      arena.overflow.clear ();
+      arena.overflow_bytes = 0;
+      arena.capacity = arena.peak + arena.peak / 4;
+      arena.block = std::make_unique<unsigned char[]> (arena.capacity);
+    }
+  arena.used = 0;
+}
+
+//!@} end of group arena
@@ -0,0 +1,38 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//! Bump allocator for the transient data of a frame, all freed at once by arena_reset.
+struct frame_arena {
+  std::unique_ptr<unsigned char[]> block; // serves every allocation once grown to a frame's needs
+  size_t capacity = 0;
+  size_t used = 0;
+  std::vector<std::unique_ptr<unsigned char[]>> overflow; // what did not fit in the block, until the next reset
+  size_t overflow_bytes = 0;
+  size_t peak = 0; // bytes a frame needed, at most
+};
+
+void *arena_alloc (struct frame_arena &arena, size_t bytes, size_t alignment);
+void arena_reset (struct frame_arena &arena);
+
+//! Uninitialized array, valid until the arena is reset; its objects are never destroyed.
+template<typename T>
+T *arena_array (struct frame_arena &arena, const size_t count)
+{
+  static_assert (std::is_trivially_destructible_v<T>, "objects in an arena are never destroyed");
+  return static_cast<T *> (arena_alloc (arena, count * sizeof (T), alignof (T)));
+}
+
+//! Object constructed in the arena, valid until it is reset; it is never destroyed.
+template<typename T, typename... Args>
+T *arena_new (struct frame_arena &arena, Args &&... args)
+{
+  static_assert (std::is_trivially_destructible_v<T>, "objects in an arena are never destroyed");
+  return new (arena_alloc (arena, sizeof (T), alignof (T))) T (std::forward<Args> (args)...);
+}
+#endif //_ARENA_H_
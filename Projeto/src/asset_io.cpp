@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef USE_IO_URING
+#include <liburing.h>
+#endif
+
+#include "asset_io.h"
+#include "profiler.h"
+
+using std::string, std::vector;
+using std::cerr, std::endl;
+
+/*! @addtogroup assetIO
+ * @{
+ * Reads the models and textures of a scene ahead of the build that uploads them.
+ *
+ * Once the world is parsed every file it refers to is asked for at once, so the
+ * reads overlap each other and the parsing of the rest instead of being issued one
+ * at a time, in the order the build reaches them, each waiting out the latency of
+ * the disk. With io_uring every read is in flight together, up to the depth of the
+ * ring; else a few threads each read a file at a time. Files are read whole, the
+ * kernel being told they are read sequentially and soon, so it reads them ahead in
+ * large requests.
+ *
+ * The build waits for the files it reaches instead of reading them, and reads those
+ * that failed itself, as it would have without this, for its own errors. Files are
+ * kept until the scene is built, as models may share them.
+ *
+ * Files the skip predicate rejects by their first bytes, as chunked models are, read
+ * a chunk at a time instead, are left after those to their consumer too: telling
+ * them apart is a read of the reading threads, not of the build.
+ */
+
+//! reads in flight in the ring at most, each with a file open
+const unsigned int IO_RING_DEPTH = 64;
+//! bytes of a read submitted to the ring at most, larger files being read in several
+const size_t IO_RING_READ = 1 << 30;
+//! bytes read first, alone, for the skip predicate to look at
+const size_t ASSET_IO_HEAD = 4096;
+
+//! Opens the file and allocates its buffer, telling the kernel it is read whole, and soon. False with the error set on failure.
+static bool asset_io_open (struct asset_read &read)
+{
+  read.fd = open (read.path.c_str (), O_RDONLY | O_CLOEXEC);
+  struct stat file_stat;
+  if (read.fd < 0 || fstat (read.fd, &file_stat))
+    {
+      read.error = errno;
+      return false;
+    }
+  read.size = (size_t) file_stat.st_size;
+  // left uninitialized, as it is read over
+  read.data.reset (new char[read.size]);
+  posix_fadvise (read.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  posix_fadvise (read.fd, 0, 0, POSIX_FADV_WILLNEED);
+  return true;
+}
+
+//! Done reading, for better or worse; freed when no longer wanted. The lock is held.
+static void asset_io_finish (struct asset_io &io, struct asset_read &read)
+{
+  if (read.fd >= 0)
+    close (read.fd);
+  read.fd = -1;
+  read.state = ASSET_DONE;
+  if (read.dropped)
+    {
+      io.reads.erase (io.reads.find (read.path));
+      return;
+    }
+  if (!read.error && !read.skipped)
+    {
+      ++io.files;
+      io.bytes += read.size;
+    }
+  io.done.notify_all ();
+}
+
+//! Bytes of the file to have read before the next check: its first alone, until they are checked.
+static size_t asset_io_end (const struct asset_io &io, const struct asset_read &read)
+{
+  return io.skip && !read.checked ? std::min (read.size, ASSET_IO_HEAD) : read.size;
+}
+
+//! Checks the first bytes against the skip predicate once they are read, freeing the file if it is skipped.
+static void asset_io_check (const struct asset_io &io, struct asset_read &read)
+{
+  if (!io.skip || read.checked || read.read < asset_io_end (io, read))
+    return;
+  read.checked = true;
+  if (!io.skip (read.path, read.data.get (), read.read))
+    return;
+  read.skipped = true;
+  read.data.reset ();
+}
+
+//! Reads with the calling thread, from a thread of the pool.
+static void asset_io_read_file (const struct asset_io &io, struct asset_read &read)
+{
+  if (!asset_io_open (read))
+    return;
+  while (read.read < read.size && !read.skipped)
+    {
+      const size_t end = asset_io_end (io, read);
+      const ssize_t n = pread (read.fd, read.data.get () + read.read, end - read.read, (off_t) read.read);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        {
+          // truncated while being read
+          read.error = n < 0 ? errno : EIO;
+          return;
+        }
+      read.read += (size_t) n;
+      asset_io_check (io, read);
+    }
+}
+
+static void asset_io_thread (struct asset_io &io)
+{
+  profiler_thread ("io");
+  std::unique_lock<std::mutex> lock (io.mutex);
+  for (;;)
+    {
+      io.wake.wait (lock, [&io] { return io.quit || !io.queue.empty (); });
+      if (io.quit)
+        return;
+      struct asset_read &read = *io.queue.front ();
+      io.queue.pop_front ();
+      read.state = ASSET_READING;
+      lock.unlock ();
+      asset_io_read_file (io, read);
+      lock.lock ();
+      asset_io_finish (io, read);
+    }
+}
+
+#ifdef USE_IO_URING
+//! Submits the rest of the file, or of its first bytes until they are checked, to the ring. The lock is held.
+static void asset_io_ring_read (struct asset_io &io, struct asset_read &read)
+{
+  struct io_uring_sqe *const sqe = io_uring_get_sqe (io.ring);
+  io_uring_prep_read (sqe, read.fd, read.data.get () + read.read,
+                      (unsigned int) std::min (asset_io_end (io, read) - read.read, IO_RING_READ), read.read);
+  io_uring_sqe_set_data (sqe, &read);
+  ++io.in_flight;
+}
+
+//! Opens queued files and submits their reads while the ring has room. The lock is held.
+static void asset_io_ring_submit (struct asset_io &io)
+{
+  bool submitted = false;
+  while (io.in_flight < IO_RING_DEPTH && !io.queue.empty ())
+    {
+      struct asset_read &read = *io.queue.front ();
+      io.queue.pop_front ();
+      read.state = ASSET_READING;
+      if (!asset_io_open (read) || !read.size)
+        {
+          asset_io_finish (io, read);
+          continue;
+        }
+      asset_io_ring_read (io, read);
+      submitted = true;
+    }
+  if (submitted)
+    io_uring_submit (io.ring);
+}
+
+//! Takes the completions of the ring, resubmitting short reads, until the ring is stopped with a read of nothing.
+static void asset_io_ring_thread (struct asset_io &io)
+{
+  profiler_thread ("io");
+  for (;;)
+    {
+      struct io_uring_cqe *cqe;
+      if (io_uring_wait_cqe (io.ring, &cqe) < 0)
+        continue;
+      struct asset_read *const read = (struct asset_read *) io_uring_cqe_get_data (cqe);
+      const int result = cqe->res;
+      io_uring_cqe_seen (io.ring, cqe);
+      if (!read)
+        return;
+
+      const std::lock_guard<std::mutex> lock (io.mutex);
+      --io.in_flight;
+      if (result > 0)
+        read->read += (size_t) result;
+      else
+        read->error = result < 0 ? -result : EIO;
+      if (!read->error)
+        asset_io_check (io, *read);
+      if (!read->error && !read->skipped && read->read < read->size)
+        {
+          asset_io_ring_read (io, *read);
+          io_uring_submit (io.ring);
+        }
+      else
+        {
+          asset_io_finish (io, *read);
+          asset_io_ring_submit (io);
+        }
+    }
+}
+#endif
+
+/*!
+ * Starts reading what is asked for from then on.
+ * @param[in] threads to read with when io_uring is not available.
+ */
+void asset_io_start (struct asset_io &io, const unsigned int threads)
+{
+#ifdef USE_IO_URING
+  io.ring = new struct io_uring;
+  if (!io_uring_queue_init (IO_RING_DEPTH, io.ring, 0))
+    {
+      io.threads.emplace_back (asset_io_ring_thread, std::ref (io));
+      return;
+    }
+  cerr << "[assets] io_uring not available, reading with threads" << endl;
+  delete io.ring;
+  io.ring = nullptr;
+#endif
+  for (unsigned int t = 0; t < threads; ++t)
+    io.threads.emplace_back (asset_io_thread, std::ref (io));
+}
+
+//! Starts reading the files, in the order given, but for those read or being read already.
+void asset_io_read_ahead (struct asset_io &io, const vector<string> &paths)
+{
+  const std::lock_guard<std::mutex> lock (io.mutex);
+  for (const string &path: paths)
+    {
+      auto &read = io.reads[path];
+      if (read)
+        continue;
+      read = std::make_unique<struct asset_read> ();
+      read->path = path;
+      io.queue.push_back (read.get ());
+    }
+#ifdef USE_IO_URING
+  if (io.ring)
+    {
+      asset_io_ring_submit (io);
+      return;
+    }
+#endif
+  io.wake.notify_all ();
+}
+
+/*!
+ * Waits for a file read ahead.
+ * @param[out] data whole file, kept until asset_io_drop.
+ * @return whether it was, and could be, read: the caller reads it itself if not.
+ */
+bool asset_io_wait (struct asset_io &io, const string &path, const char *&data, size_t &size)
+{
+  std::unique_lock<std::mutex> lock (io.mutex);
+  const auto found = io.reads.find (path);
+  if (found == io.reads.end () || found->second->dropped)
+    return false;
+  struct asset_read &read = *found->second;
+  if (read.state != ASSET_DONE)
+    {
+      const double begin = profiler_now ();
+      io.done.wait (lock, [&read] { return read.state == ASSET_DONE; });
+      io.waited += profiler_now () - begin;
+    }
+  if (read.error || read.skipped)
+    return false;
+  data = read.data.get ();
+  size = read.size;
+  return true;
+}
+
+//! Frees the files read, and those being read once they are, telling how long their consumers waited for them.
+void asset_io_drop (struct asset_io &io)
+{
+  const std::lock_guard<std::mutex> lock (io.mutex);
+  if (io.files)
+    cerr << "[assets] Read ahead " << io.files << " files, " << (double) io.bytes / (1 << 20) << " MiB, waited "
+         << io.waited / 1000 << " ms" << endl;
+  for (struct asset_read *const read: io.queue)
+    read->state = ASSET_DONE;
+  io.queue.clear ();
+  for (auto read = io.reads.begin (); read != io.reads.end ();)
+    if (read->second->state == ASSET_READING)
+      {
+        read->second->dropped = true;
+        ++read;
+      }
+    else
+      read = io.reads.erase (read);
+  io.files = 0;
+  io.bytes = 0;
+  io.waited = 0;
+}
+
+//! Stops reading, leaving what is being read unfinished.
+void asset_io_stop (struct asset_io &io)
+{
+  {
+    const std::lock_guard<std::mutex> lock (io.mutex);
+    io.quit = true;
+#ifdef USE_IO_URING
+    if (io.ring)
+      {
+        // a read of nothing stops the thread taking the completions
+        struct io_uring_sqe *const sqe = io_uring_get_sqe (io.ring);
+        io_uring_prep_nop (sqe);
+        io_uring_sqe_set_data (sqe, nullptr);
+        io_uring_submit (io.ring);
+      }
+#endif
+  }
+  io.wake.notify_all ();
+  for (auto &thread: io.threads)
+    if (thread.get_id () == std::this_thread::get_id ())
+      thread.detach ();
+    else
+      thread.join ();
+  io.threads.clear ();
+#ifdef USE_IO_URING
+  if (io.ring)
+    {
+      io_uring_queue_exit (io.ring);
+      delete io.ring;
+      io.ring = nullptr;
+    }
+#endif
+}
+
+//! @} end of group assetIO
@@ -0,0 +1,59 @@
+#ifndef _ASSET_IO_H_
+#define _ASSET_IO_H_
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct io_uring;
+
+enum asset_read_state {
+  ASSET_QUEUED,
+  ASSET_READING,
+  ASSET_DONE
+};
+
+//! A file read ahead, whole.
+struct asset_read {
+  std::string path;
+  std::unique_ptr<char[]> data;
+  size_t size = 0;
+  size_t read = 0;   // bytes read so far
+  int fd = -1;
+  int error = 0;     // errno of what failed, the file then being read by its consumer as it would without this
+  enum asset_read_state state = ASSET_QUEUED;
+  bool dropped = false; // freed once read, no longer wanted
+  bool checked = false; // its first bytes against the skip predicate
+  bool skipped = false; // by it, its consumer then reading it as it would without this
+};
+
+//! Reads files ahead of their consumers, with io_uring when built with it and the kernel allows, else with threads.
+struct asset_io {
+  std::mutex mutex;
+  std::condition_variable wake; // for the threads, files were queued
+  std::condition_variable done; // for the consumers, a file was read
+  std::unordered_map<std::string, std::unique_ptr<struct asset_read>> reads;
+  std::deque<struct asset_read *> queue; // not being read yet, in the order asked for
+  // whether a file is not to be read whole, told by its first bytes; set before asset_io_start
+  bool (*skip) (const std::string &path, const char *head, size_t size) = nullptr;
+  std::vector<std::thread> threads;
+  struct io_uring *ring = nullptr;
+  unsigned int in_flight = 0; // reads submitted to the ring
+  bool quit = false;
+  // since the last asset_io_drop
+  unsigned int files = 0;
+  uint64_t bytes = 0;
+  double waited = 0; // by consumers, in microseconds
+};
+
+void asset_io_start (struct asset_io &io, unsigned int threads);
+void asset_io_read_ahead (struct asset_io &io, const std::vector<std::string> &paths);
+bool asset_io_wait (struct asset_io &io, const std::string &path, const char *&data, size_t &size);
+void asset_io_drop (struct asset_io &io);
+void asset_io_stop (struct asset_io &io);
+#endif //_ASSET_IO_H_
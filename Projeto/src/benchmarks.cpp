@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+
+#include "curves.h"
+#include "jobs.h"
+#include "models.h"
+#include "parsing.h"
+#include "scene_synth.h"
+
+using glm::vec3, glm::vec2;
+using std::vector, std::array, std::string, std::cerr;
+namespace fs = std::filesystem;
+
+/*! @addtogroup benchmarks
+ * @{
+ * Microbenchmarks of the hot paths of the generator, the curves and the parser,
+ * each at several sizes, reporting vertices (or patches, or nodes) and bytes per second.
+ *
+ * The bench target runs them all and writes the results to benchmarks_⟨commit⟩.json,
+ * which Google Benchmark's tools/compare.py compares between two commits.
+ */
+
+//! Scratch directory for the files the benchmarks read and write.
+static fs::path bench_path (const string &name)
+{
+  static const fs::path directory = []
+  {
+    const fs::path d = fs::temp_directory_path () / "cg_benchmarks";
+    fs::create_directories (d);
+    return d;
+  } ();
+  return directory / name;
+}
+
+//! Silences cerr in its scope, as model_write and the parser log every call.
+struct cerr_silencer {
+  std::streambuf *const saved = cerr.rdbuf (nullptr);
+  ~cerr_silencer ()
+  {
+    cerr.rdbuf (saved);
+    cerr.clear ();
+  }
+};
+
+static void set_vertices_processed (benchmark::State &state, const size_t vertices)
+{
+  state.counters["vertices"] = benchmark::Counter ((double) vertices, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+//! Bytes of a .3d file of that many vertices: their count, then positions, normals and texture coordinates.
+static size_t model_bytes (const size_t vertices)
+{
+  return sizeof (int) + vertices * (sizeof (vec3) + sizeof (vec3) + sizeof (vec2));
+}
+
+/*! @addtogroup curves_benchmarks
+ * @{*/
+
+static void BM_get_curve_point_at (benchmark::State &state)
+{
+  const auto points = (unsigned int) state.range (0);
+  const array<vec3, 4> control_points = {vec3 (0, 0, 4), vec3 (4, 0, 0), vec3 (0, 0, -4), vec3 (-4, 10, 0)};
+  vec3 position, derivative;
+  for (auto _: state)
+    for (unsigned int i = 0; i < points; ++i)
+      {
+        get_curve_point_at ((float) i / (float) points, Mcr, control_points, position, derivative);
+        benchmark::DoNotOptimize (position);
+        benchmark::DoNotOptimize (derivative);
+      }
+  set_vertices_processed (state, points);
+}
+BENCHMARK (BM_get_curve_point_at)->RangeMultiplier (16)->Range (16, 1 << 16);
+
+//! A wavy 4×4 grid of control points.
+static array<vec3, 16> bezier_grid ()
+{
+  array<vec3, 16> control_points;
+  for (int i = 0; i < 16; ++i)
+    control_points[i] = vec3 ((float) (i % 4), (float) ((i * 7) % 5) / 4, (float) (i / 4));
+  return control_points;
+}
+
+static void BM_get_bezier_point_at (benchmark::State &state)
+{
+  const auto tesselation = (unsigned int) state.range (0);
+  const array<vec3, 16> control_points = bezier_grid ();
+  vec3 position, normal;
+  for (auto _: state)
+    for (unsigned int v = 0; v < tesselation; ++v)
+      for (unsigned int u = 0; u < tesselation; ++u)
+        {
+          get_bezier_point_at ((float) u / (float) tesselation, (float) v / (float) tesselation, control_points,
+                               position, normal);
+          benchmark::DoNotOptimize (position);
+          benchmark::DoNotOptimize (normal);
+        }
+  set_vertices_processed (state, tesselation * tesselation);
+}
+BENCHMARK (BM_get_bezier_point_at)->RangeMultiplier (4)->Range (4, 256);
+
+//! The teapot of phase 3, 32 patches.
+static void BM_get_bezier_surface (benchmark::State &state)
+{
+  const auto tesselation = (int) state.range (0);
+  const vector<array<vec3, 16>> patches = read_Bezier (TEAPOT_PATCH);
+  vector<vec3> vertices, normals;
+  vector<vec2> texture;
+  for (auto _: state)
+    {
+      vertices.clear ();
+      normals.clear ();
+      texture.clear ();
+      get_bezier_surface (patches, tesselation, vertices, normals, texture);
+      benchmark::DoNotOptimize (vertices.data ());
+    }
+  set_vertices_processed (state, vertices.size ());
+}
+BENCHMARK (BM_get_bezier_surface)->RangeMultiplier (4)->Range (4, 64);
+
+//! @} end of group curves_benchmarks
+
+/*! @addtogroup model_benchmarks
+ * @{*/
+
+static void BM_model_sphere_vertices (benchmark::State &state)
+{
+  const auto slices = (unsigned int) state.range (0);
+  vector<vec3> vertices, normals;
+  vector<vec2> texture;
+  for (auto _: state)
+    {
+      vertices.clear ();
+      normals.clear ();
+      texture.clear ();
+      model_sphere_vertices (1, slices, slices, vertices, normals, texture);
+      benchmark::DoNotOptimize (vertices.data ());
+    }
+  set_vertices_processed (state, vertices.size ());
+}
+BENCHMARK (BM_model_sphere_vertices)->RangeMultiplier (4)->Range (16, 1024);
+
+static void BM_model_cube_vertices (benchmark::State &state)
+{
+  const auto divisions = (unsigned int) state.range (0);
+  vector<vec3> vertices, normals;
+  vector<vec2> texture;
+  for (auto _: state)
+    {
+      vertices.clear ();
+      normals.clear ();
+      texture.clear ();
+      model_cube_vertices (2, divisions, vertices, normals, texture);
+      benchmark::DoNotOptimize (vertices.data ());
+    }
+  set_vertices_processed (state, vertices.size ());
+}
+BENCHMARK (BM_model_cube_vertices)->RangeMultiplier (4)->Range (4, 256);
+
+static void BM_model_cone_vertices (benchmark::State &state)
+{
+  const auto slices = (unsigned int) state.range (0);
+  vector<vec3> vertices, normals;
+  vector<vec2> texture;
+  for (auto _: state)
+    {
+      vertices.clear ();
+      normals.clear ();
+      texture.clear ();
+      model_cone_vertices (1.0f, 2.0f, slices, slices, vertices, normals, texture);
+      benchmark::DoNotOptimize (vertices.data ());
+    }
+  set_vertices_processed (state, vertices.size ());
+}
+BENCHMARK (BM_model_cone_vertices)->RangeMultiplier (4)->Range (16, 1024);
+
+//! @} end of group model_benchmarks
+
+/*! @addtogroup file_benchmarks
+ * @{*/
+
+//! Writes a patch file of that many patches, in the format of teapot.patch, returning its path.
+static string patch_file (const unsigned int patches)
+{
+  const string path = bench_path ("bench_" + std::to_string (patches) + ".patch");
+  FILE *fp = fopen (path.c_str (), "w");
+  const unsigned int points = 16 * patches;
+  fprintf (fp, "%u\n", patches);
+  for (unsigned int p = 0; p < patches; ++p)
+    for (unsigned int i = 0; i < 16; ++i)
+      fprintf (fp, i < 15 ? "%u, " : "%u\n", 16 * p + i);
+  fprintf (fp, "%u\n", points);
+  for (unsigned int i = 0; i < points; ++i)
+    fprintf (fp, "%f, %f, %f\n", (float) (i % 4), (float) ((i * 7) % 5) / 4, (float) (i / 4));
+  fclose (fp);
+  return path;
+}
+
+static void BM_read_Bezier (benchmark::State &state)
+{
+  const auto patches = (unsigned int) state.range (0);
+  const string path = patch_file (patches);
+  for (auto _: state)
+    benchmark::DoNotOptimize (read_Bezier (path.c_str ()));
+  state.counters["patches"] = benchmark::Counter (patches, benchmark::Counter::kIsIterationInvariantRate);
+  state.SetBytesProcessed ((int64_t) state.iterations () * (int64_t) fs::file_size (path));
+}
+BENCHMARK (BM_read_Bezier)->RangeMultiplier (8)->Range (8, 4096);
+
+//! Writes a sphere of about that many vertices, returning its path.
+static string sphere_file (const unsigned int vertices)
+{
+  const auto slices = (unsigned int) std::max (1.0, sqrt (vertices / 6.0));
+  const string path = bench_path ("sphere_" + std::to_string (vertices) + ".3d");
+  cerr_silencer silencer;
+  model_sphere_write (path.c_str (), 1, slices, slices);
+  return path;
+}
+
+static void BM_model_write (benchmark::State &state)
+{
+  const auto slices = (unsigned int) std::max (1.0, sqrt ((double) state.range (0) / 6));
+  vector<vec3> vertices, normals;
+  vector<vec2> texture;
+  model_sphere_vertices (1, slices, slices, vertices, normals, texture);
+  const string path = bench_path ("write.3d");
+  cerr_silencer silencer;
+  for (auto _: state)
+    model_write (path.c_str (), vertices, normals, texture);
+  set_vertices_processed (state, vertices.size ());
+  state.SetBytesProcessed ((int64_t) (state.iterations () * model_bytes (vertices.size ())));
+}
+BENCHMARK (BM_model_write)->RangeMultiplier (16)->Range (1 << 10, 1 << 22);
+
+//! The file reading part of allocModel, the rest being uploads to the GPU.
+static void BM_model_read (benchmark::State &state)
+{
+  const string path = sphere_file ((unsigned int) state.range (0));
+  vector<vec3> vertices, normals;
+  vector<vec2> texture;
+  for (auto _: state)
+    {
+      model_read (path.c_str (), vertices, normals, texture);
+      benchmark::DoNotOptimize (vertices.data ());
+    }
+  set_vertices_processed (state, vertices.size ());
+  state.SetBytesProcessed ((int64_t) state.iterations () * (int64_t) fs::file_size (path));
+}
+BENCHMARK (BM_model_read)->RangeMultiplier (16)->Range (1 << 10, 1 << 22);
+
+//! As BM_model_read, of the sphere compressed, its bytes being the floats decoded, to compare with.
+static void BM_model_read_compressed (benchmark::State &state)
+{
+  const auto slices = (unsigned int) std::max (1.0, sqrt ((double) state.range (0) / 6));
+  const string path = bench_path ("sphere_compressed_" + std::to_string (state.range (0)) + ".3d");
+  {
+    cerr_silencer silencer;
+    globalModelEncoding.compressed = true;
+    model_sphere_write (path.c_str (), 1, slices, slices);
+    globalModelEncoding.compressed = false;
+  }
+  vector<vec3> vertices, normals;
+  vector<vec2> texture;
+  for (auto _: state)
+    {
+      model_read (path.c_str (), vertices, normals, texture);
+      benchmark::DoNotOptimize (vertices.data ());
+    }
+  set_vertices_processed (state, vertices.size ());
+  state.SetBytesProcessed ((int64_t) (state.iterations () * model_bytes (vertices.size ())));
+}
+BENCHMARK (BM_model_read_compressed)->RangeMultiplier (16)->Range (1 << 10, 1 << 22);
+
+//! As BM_model_read, of the sphere chunked, read a chunk at a time as the engine streams it.
+static void BM_model_chunks_read (benchmark::State &state)
+{
+  const auto slices = (unsigned int) std::max (1.0, sqrt ((double) state.range (0) / 6));
+  const string path = bench_path ("sphere_chunked_" + std::to_string (state.range (0)) + ".3d");
+  {
+    cerr_silencer silencer;
+    globalModelEncoding.chunked = true;
+    model_sphere_write (path.c_str (), 1, slices, slices);
+    globalModelEncoding.chunked = false;
+  }
+  vector<struct model_vertex> chunk;
+  size_t vertices = 0;
+  for (auto _: state)
+    {
+      struct model_chunks chunks;
+      model_chunks_open (path.c_str (), chunks);
+      while (model_chunks_read (chunks, chunk))
+        benchmark::DoNotOptimize (chunk.data ());
+      model_chunks_close (chunks);
+      vertices = chunks.nVertices;
+    }
+  set_vertices_processed (state, vertices);
+  state.SetBytesProcessed ((int64_t) state.iterations () * (int64_t) fs::file_size (path));
+}
+BENCHMARK (BM_model_chunks_read)->RangeMultiplier (16)->Range (1 << 10, 1 << 22);
+
+//! The checksum of the payload of models, which every read pays for, of as many bytes as floats of the vertices.
+static void BM_xxh64 (benchmark::State &state)
+{
+  vector<char> payload (model_bytes ((size_t) state.range (0)));
+  for (size_t b = 0; b < payload.size (); ++b)
+    payload[b] = (char) (b * 2654435761u >> 24);
+  for (auto _: state)
+    benchmark::DoNotOptimize (xxh64 (payload.data (), payload.size ()));
+  set_vertices_processed (state, (size_t) state.range (0));
+  state.SetBytesProcessed ((int64_t) (state.iterations () * payload.size ()));
+}
+BENCHMARK (BM_xxh64)->RangeMultiplier (16)->Range (1 << 10, 1 << 22);
+
+/*!
+ * Synthetic scenes of fanout 10 and growing depth, so of 10^depth groups or so, as regress/scaling.sh renders,
+ * up to a million groups. The time is fit against the number of groups, which it should grow linearly with.
+ */
+static void BM_operations_load_xml (benchmark::State &state)
+{
+  struct scene_synth_options options;
+  options.depth = (unsigned int) state.range (0);
+  options.textures = 4;
+  options.lights = 8;
+  const string scene = "scene_" + std::to_string (options.depth) + ".xml";
+  vector<float> operations;
+  cerr_silencer silencer;
+  // the scene refers to its models relative to its directory
+  const fs::path working_directory = fs::current_path ();
+  fs::current_path (bench_path (""));
+  const uint64_t groups = scene_synth_write (".", scene, options);
+  for (auto _: state)
+    {
+      operations.clear ();
+      operations_load_xml (scene, operations);
+      benchmark::DoNotOptimize (operations.data ());
+    }
+  state.counters["nodes"] = benchmark::Counter ((double) groups, benchmark::Counter::kIsIterationInvariantRate);
+  state.SetComplexityN ((int64_t) groups);
+  state.SetBytesProcessed ((int64_t) state.iterations () * (int64_t) fs::file_size (scene));
+  fs::current_path (working_directory);
+}
+BENCHMARK (BM_operations_load_xml)->DenseRange (1, 6)->Complexity (benchmark::oN)->Unit (benchmark::kMillisecond);
+
+//! The same scenes read with the workers the engine would start, those large enough being read in parallel.
+static void BM_operations_load_xml_parallel (benchmark::State &state)
+{
+  struct scene_synth_options options;
+  options.depth = (unsigned int) state.range (0);
+  options.textures = 4;
+  options.lights = 8;
+  const string scene = "scene_" + std::to_string (options.depth) + ".xml";
+  vector<float> operations;
+  struct job_system jobs;
+  job_system_start (jobs, job_system_default_workers ());
+  cerr_silencer silencer;
+  const fs::path working_directory = fs::current_path ();
+  fs::current_path (bench_path (""));
+  const uint64_t groups = scene_synth_write (".", scene, options);
+  for (auto _: state)
+    {
+      operations.clear ();
+      operations_load_xml (scene, operations, &jobs);
+      benchmark::DoNotOptimize (operations.data ());
+    }
+  state.counters["nodes"] = benchmark::Counter ((double) groups, benchmark::Counter::kIsIterationInvariantRate);
+  state.SetBytesProcessed ((int64_t) state.iterations () * (int64_t) fs::file_size (scene));
+  fs::current_path (working_directory);
+  job_system_stop (jobs);
+}
+BENCHMARK (BM_operations_load_xml_parallel)->DenseRange (4, 6)->Unit (benchmark::kMillisecond)->UseRealTime ();
+
+//! @} end of group file_benchmarks
+
+//!@} end of group benchmarks
+
+BENCHMARK_MAIN ();
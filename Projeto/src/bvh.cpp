@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "bvh.h"
+
+using glm::vec3;
+using std::vector;
+
+/*! @addtogroup bvh
+ * @{
+ * The hierarchy is built once, top-down, splitting the items at the median
+ * of their centers along the longest axis, which keeps it balanced so every
+ * query visits O(log n) nodes for a localized result. Afterwards only the
+ * items that move are refitted (bvh_move), walking up from their leaf until a
+ * parent box does not change, so static items cost nothing per frame.
+ */
+
+static inline vec3 aabb_center (const struct aabb &box)
+{
+  return (box.min + box.max) * 0.5f;
+}
+
+static int bvh_build_range (struct bvh &tree,
+                            const vector<struct aabb> &boxes,
+                            vector<unsigned int> &items,
+                            const size_t begin,
+                            const size_t end,
+                            const int parent)
+{
+  const int index = (int) tree.nodes.size ();
+  tree.nodes.emplace_back ();
+  tree.nodes[index].parent = parent;
+
+  if (end - begin == 1)
+    {
+      const unsigned int item = items[begin];
+      tree.nodes[index].item = item;
+      tree.nodes[index].box = boxes[item];
+      tree.leaves[item] = index;
+      return index;
+    }
+
+  const vec3 first_center = aabb_center (boxes[items[begin]]);
+  struct aabb centers = {first_center, first_center};
+  for (size_t i = begin + 1; i < end; ++i)
+    {
+      const vec3 center = aabb_center (boxes[items[i]]);
+      centers = aabb_merge (centers, {center, center});
+    }
+  const vec3 extent = centers.max - centers.min;
+  const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+  const size_t middle = begin + (end - begin) / 2;
+  std::nth_element (items.begin () + (long) begin, items.begin () + (long) middle, items.begin () + (long) end,
+                    [&boxes, axis] (const unsigned int a, const unsigned int b)
+                    {
+                      return aabb_center (boxes[a])[axis] < aabb_center (boxes[b])[axis];
+                    });
+
+  const int left = bvh_build_range (tree, boxes, items, begin, middle, index);
+  const int right = bvh_build_range (tree, boxes, items, middle, end, index);
+  tree.nodes[index].left = left;
+  tree.nodes[index].right = right;
+  tree.nodes[index].box = aabb_merge (tree.nodes[left].box, tree.nodes[right].box);
+  return index;
+}
+
+//! @param[in] boxes the box of each item, items being identified by their index.
+void bvh_build (struct bvh &tree, const vector<struct aabb> &boxes)
+{
+  tree.nodes.clear ();
+  tree.leaves.assign (boxes.size (), -1);
+  if (boxes.empty ())
+    return;
+
+  tree.nodes.reserve (2 * boxes.size () - 1);
+  vector<unsigned int> items (boxes.size ());
+  for (unsigned int i = 0; i < items.size (); ++i)
+    items[i] = i;
+  bvh_build_range (tree, boxes, items, 0, items.size (), -1);
+}
+
+//! Updates the box of an item and refits its ancestors.
+void bvh_move (struct bvh &tree, const unsigned int item, const struct aabb &box)
+{
+  int node = tree.leaves[item];
+  tree.nodes[node].box = box;
+  for (node = tree.nodes[node].parent; node >= 0; node = tree.nodes[node].parent)
+    {
+      struct bvh_node &parent = tree.nodes[node];
+      const struct aabb refitted = aabb_merge (tree.nodes[parent.left].box, tree.nodes[parent.right].box);
+      if (refitted.min == parent.box.min && refitted.max == parent.box.max)
+        break; // nothing above changes either
+      parent.box = refitted;
+    }
+}
+
+/*!
+ * @param[out] visible for each item, whether its box intersects the frustum.
+ *             Subtrees entirely inside the frustum are accepted without further tests.
+ */
+void bvh_cull (const struct bvh &tree, const frustum_t &frustum, bool *const visible)
+{
+  std::fill (visible, visible + tree.leaves.size (), false);
+  if (tree.nodes.empty ())
+    return;
+
+  struct entry {
+    int node;
+    bool inside;
+  };
+  // depth first, so the stack holds at most a node per level besides the one popped
+  struct entry stack[BVH_MAX_DEPTH + 1];
+  unsigned int size = 0;
+  stack[size++] = {0, false};
+  while (size)
+    {
+      struct entry e = stack[--size];
+      const struct bvh_node &node = tree.nodes[e.node];
+      if (!e.inside)
+        {
+          const int classification = frustum_classify_aabb (frustum, node.box);
+          if (classification == OUTSIDE)
+            continue;
+          e.inside = classification == INSIDE;
+        }
+      if (node.left < 0)
+        visible[node.item] = true;
+      else
+        {
+          stack[size++] = {node.left, e.inside};
+          stack[size++] = {node.right, e.inside};
+        }
+    }
+}
+
+/*!
+ * Slab test, axis by axis. Axes the ray is parallel to are told apart rather than
+ * divided by, as 0 * inf is NaN for a ray starting on a face of the box.
+ */
+static bool ray_intersects_aabb (const vec3 &origin, const vec3 &direction, const vec3 &inverse_direction,
+                                 const struct aabb &box, const float max_distance, float &distance)
+{
+  float t_enter = 0;
+  float t_exit = max_distance;
+  for (int a = 0; a < 3; ++a)
+    {
+      if (direction[a] == 0)
+        {
+          // within the slab all along, or never
+          if (origin[a] < box.min[a] || origin[a] > box.max[a])
+            return false;
+          continue;
+        }
+      const float t1 = (box.min[a] - origin[a]) * inverse_direction[a];
+      const float t2 = (box.max[a] - origin[a]) * inverse_direction[a];
+      t_enter = fmaxf (t_enter, fminf (t1, t2));
+      t_exit = fminf (t_exit, fmaxf (t1, t2));
+    }
+  if (t_exit < t_enter)
+    return false;
+  distance = t_enter;
+  return true;
+}
+
+/*!
+ * Finds the item whose box is hit first by a ray.
+ * @param[out] item the item hit.
+ * @param[out] distance distance along the direction to the hit (0 when the origin is inside the box).
+ * @return whether any item was hit.
+ */
+bool bvh_raycast (const struct bvh &tree, const vec3 &origin, const vec3 &direction,
+                  unsigned int &item, float &distance)
+{
+  if (tree.nodes.empty ())
+    return false;
+
+  const vec3 inverse_direction = 1.0f / direction;
+  float best = INFINITY;
+  bool hit = false;
+  vector<int> stack = {0};
+  while (!stack.empty ())
+    {
+      const struct bvh_node &node = tree.nodes[stack.back ()];
+      stack.pop_back ();
+      float t;
+      if (!ray_intersects_aabb (origin, direction, inverse_direction, node.box, best, t))
+        continue;
+      if (node.left < 0)
+        {
+          best = t;
+          item = node.item;
+          hit = true;
+        }
+      else
+        {
+          stack.push_back (node.left);
+          stack.push_back (node.right);
+        }
+    }
+  distance = best;
+  return hit;
+}
+
+//!@} end of group bvh
@@ -0,0 +1,29 @@
+#ifndef _BVH_H_
+#define _BVH_H_
+#include <vector>
+#include <glm/glm.hpp>
+#include "culling.h"
+
+//! levels below the root at most: median splits keep the tree balanced, log2 of the items deep
+const unsigned int BVH_MAX_DEPTH = 64;
+
+struct bvh_node {
+  struct aabb box;
+  int parent = -1;
+  int left = -1;  // a node without children is a leaf
+  int right = -1;
+  unsigned int item = 0; // leaf only: index of the bounded item
+};
+
+//! Bounding volume hierarchy over a set of items, each one given by its axis aligned box.
+struct bvh {
+  std::vector<struct bvh_node> nodes; // nodes[0] is the root
+  std::vector<int> leaves;            // item -> its leaf node
+};
+
+void bvh_build (struct bvh &tree, const std::vector<struct aabb> &boxes);
+void bvh_move (struct bvh &tree, unsigned int item, const struct aabb &box);
+void bvh_cull (const struct bvh &tree, const frustum_t &frustum, bool *visible);
+bool bvh_raycast (const struct bvh &tree, const glm::vec3 &origin, const glm::vec3 &direction,
+                  unsigned int &item, float &distance);
+#endif //_BVH_H_
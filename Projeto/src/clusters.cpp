@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "clusters.h"
+
+using glm::mat4, glm::vec4, glm::vec3;
+using std::vector;
+
+/*! @addtogroup clusters
+ * @{
+ * Clustered light assignment, done on the CPU every frame.
+ *
+ * The frustum is divided in CLUSTERS_X × CLUSTERS_Y screen tiles and
+ * CLUSTERS_Z depth slices, slice k spanning the view depths
+ * near·(far/near)^(k/CLUSTERS_Z) to near·(far/near)^((k+1)/CLUSTERS_Z) so that
+ * clusters stay roughly cubic. A light is assigned to every cluster its
+ * sphere of influence overlaps; the fragment shader then finds its cluster
+ * from the window position and depth, and only shades with those lights.
+ *
+ * Within a slice the sphere is tested against a row of tiles 4 at a time with
+ * SSE2, which is why CLUSTERS_X is a multiple of 4.
+ */
+
+static_assert (CLUSTERS_X % 4 == 0, "rows of clusters are tested 4 at a time");
+
+static const unsigned int CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+static inline unsigned int cluster_index (const unsigned int x, const unsigned int y, const unsigned int z)
+{
+  return (z * CLUSTERS_Y + y) * CLUSTERS_X + x;
+}
+
+static inline float slice_depth (const struct cluster_grid &grid, const unsigned int k)
+{
+  return grid.near * powf (grid.far / grid.near, (float) k / CLUSTERS_Z);
+}
+
+static inline unsigned int depth_slice (const struct cluster_grid &grid, const float depth)
+{
+  const float k = logf (depth / grid.near) / logf (grid.far / grid.near) * CLUSTERS_Z;
+  return (unsigned int) std::clamp (k, 0.0f, (float) (CLUSTERS_Z - 1));
+}
+
+/*!
+ * Computes the view space box of every cluster, to be done when the projection changes.
+ * @param[in] near,far depths the slices are distributed between.
+ */
+void clusters_build (struct cluster_grid &grid, const mat4 &projection, const float near, const float far)
+{
+  grid.near = near;
+  grid.far = far;
+  for (auto *v: {&grid.min_x, &grid.min_y, &grid.min_z, &grid.max_x, &grid.max_y, &grid.max_z})
+    v->resize (CLUSTER_COUNT);
+
+  // point on the near plane at each tile corner, the corner's ray going from the origin through it
+  const mat4 inverse = glm::inverse (projection);
+  vector<vec3> corners ((CLUSTERS_X + 1) * (CLUSTERS_Y + 1));
+  for (unsigned int y = 0; y <= CLUSTERS_Y; ++y)
+    for (unsigned int x = 0; x <= CLUSTERS_X; ++x)
+      {
+        const vec4 p = inverse * vec4 (2.0f * x / CLUSTERS_X - 1, 2.0f * y / CLUSTERS_Y - 1, -1, 1);
+        corners[y * (CLUSTERS_X + 1) + x] = vec3 (p) / -p.z; // at depth 1
+      }
+
+  for (unsigned int z = 0; z < CLUSTERS_Z; ++z)
+    {
+      const float depths[2] = {slice_depth (grid, z), slice_depth (grid, z + 1)};
+      for (unsigned int y = 0; y < CLUSTERS_Y; ++y)
+        for (unsigned int x = 0; x < CLUSTERS_X; ++x)
+          {
+            vec3 min (INFINITY), max (-INFINITY);
+            for (const float depth: depths)
+              for (unsigned int corner = 0; corner < 4; ++corner)
+                {
+                  const vec3 p = corners[(y + corner / 2) * (CLUSTERS_X + 1) + x + corner % 2] * depth;
+                  min = glm::min (min, p);
+                  max = glm::max (max, p);
+                }
+            const unsigned int c = cluster_index (x, y, z);
+            grid.min_x[c] = min.x;
+            grid.min_y[c] = min.y;
+            grid.min_z[c] = min.z;
+            grid.max_x[c] = max.x;
+            grid.max_y[c] = max.y;
+            grid.max_z[c] = max.z;
+          }
+    }
+}
+
+/*!
+ * Marks which of the 4 clusters starting at c the sphere overlaps, as the low 4 bits of the result.
+ * The squared distance from the center to each box is compared with the squared radius.
+ */
+static inline unsigned int clusters_overlap4 (const struct cluster_grid &grid, const unsigned int c,
+                                              const struct cluster_light &light)
+{
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps ();
+  const __m128 cx = _mm_set1_ps (light.center.x);
+  const __m128 cy = _mm_set1_ps (light.center.y);
+  const __m128 cz = _mm_set1_ps (light.center.z);
+  const __m128 dx = _mm_add_ps (_mm_max_ps (_mm_sub_ps (_mm_loadu_ps (&grid.min_x[c]), cx), zero),
+                                _mm_max_ps (_mm_sub_ps (cx, _mm_loadu_ps (&grid.max_x[c])), zero));
+  const __m128 dy = _mm_add_ps (_mm_max_ps (_mm_sub_ps (_mm_loadu_ps (&grid.min_y[c]), cy), zero),
+                                _mm_max_ps (_mm_sub_ps (cy, _mm_loadu_ps (&grid.max_y[c])), zero));
+  const __m128 dz = _mm_add_ps (_mm_max_ps (_mm_sub_ps (_mm_loadu_ps (&grid.min_z[c]), cz), zero),
+                                _mm_max_ps (_mm_sub_ps (cz, _mm_loadu_ps (&grid.max_z[c])), zero));
+  const __m128 distance2 = _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz));
+  return (unsigned int) _mm_movemask_ps (_mm_cmple_ps (distance2, _mm_set1_ps (light.radius * light.radius)));
+#else
+  unsigned int mask = 0;
+  for (unsigned int i = 0; i < 4; ++i)
+    {
+      const float dx = fmaxf (grid.min_x[c + i] - light.center.x, 0) + fmaxf (light.center.x - grid.max_x[c + i], 0);
+      const float dy = fmaxf (grid.min_y[c + i] - light.center.y, 0) + fmaxf (light.center.y - grid.max_y[c + i], 0);
+      const float dz = fmaxf (grid.min_z[c + i] - light.center.z, 0) + fmaxf (light.center.z - grid.max_z[c + i], 0);
+      if (dx * dx + dy * dy + dz * dz <= light.radius * light.radius)
+        mask |= 1u << i;
+    }
+  return mask;
+#endif
+}
+
+/*!
+ * Assigns the lights to the clusters they overlap, filling grid.ranges and grid.indices.
+ * @param[in] lights in view space.
+ * @param[in] light_offset added to every light index, for when the lights are placed after others.
+ */
+void clusters_assign (struct cluster_grid &grid, const vector<struct cluster_light> &lights,
+                      const uint32_t light_offset)
+{
+  static vector<uint32_t> counts;
+  static vector<std::pair<uint32_t, uint32_t>> hits; // cluster, light
+  counts.assign (CLUSTER_COUNT, 0);
+  hits.clear ();
+
+  for (uint32_t l = 0; l < lights.size (); ++l)
+    {
+      const struct cluster_light &light = lights[l];
+      // the camera looks down -z
+      const float nearest = -light.center.z - light.radius;
+      const float farthest = -light.center.z + light.radius;
+      if (farthest < grid.near || nearest > grid.far)
+        continue;
+      const unsigned int z0 = depth_slice (grid, fmaxf (nearest, grid.near));
+      const unsigned int z1 = depth_slice (grid, fminf (farthest, grid.far));
+      for (unsigned int z = z0; z <= z1; ++z)
+        for (unsigned int y = 0; y < CLUSTERS_Y; ++y)
+          for (unsigned int x = 0; x < CLUSTERS_X; x += 4)
+            {
+              const unsigned int c = cluster_index (x, y, z);
+              unsigned int mask = clusters_overlap4 (grid, c, light);
+              for (; mask; mask &= mask - 1)
+                {
+                  const unsigned int hit = c + (unsigned int) std::countr_zero (mask);
+                  if (counts[hit] == CLUSTER_MAX_LIGHTS)
+                    continue;
+                  ++counts[hit];
+                  hits.emplace_back (hit, l);
+                }
+            }
+    }
+
+  // counting sort of the hits by cluster, lights staying in order within each one
+  grid.ranges.resize (2 * CLUSTER_COUNT);
+  uint32_t offset = 0;
+  for (unsigned int c = 0; c < CLUSTER_COUNT; ++c)
+    {
+      grid.ranges[2 * c] = offset;
+      grid.ranges[2 * c + 1] = counts[c];
+      offset += counts[c];
+      counts[c] = grid.ranges[2 * c]; // now where the next light of the cluster goes
+    }
+  grid.indices.resize (offset);
+  for (const auto &[cluster, light]: hits)
+    grid.indices[counts[cluster]++] = light_offset + light;
+}
+
+//!@} end of group clusters
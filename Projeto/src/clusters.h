@@ -0,0 +1,33 @@
+#ifndef _CLUSTERS_H_
+#define _CLUSTERS_H_
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+const unsigned int CLUSTERS_X = 16;
+const unsigned int CLUSTERS_Y = 9;
+const unsigned int CLUSTERS_Z = 24;
+const unsigned int CLUSTER_MAX_LIGHTS = 128; // lights past this many in one cluster are dropped
+
+//! Sphere of influence of a light, in view space.
+struct cluster_light {
+  glm::vec3 center;
+  float radius;
+};
+
+//! Froxel grid: the view frustum split into screen tiles and exponential depth slices.
+struct cluster_grid {
+  float near = 1;
+  float far = 1000;
+  // view space box of each cluster, x varying fastest, then y, then z
+  std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+
+  // filled by clusters_assign
+  std::vector<uint32_t> ranges;  // per cluster, offset into indices then count
+  std::vector<uint32_t> indices; // light indices, grouped by cluster
+};
+
+void clusters_build (struct cluster_grid &grid, const glm::mat4 &projection, float near, float far);
+void clusters_assign (struct cluster_grid &grid, const std::vector<struct cluster_light> &lights,
+                      uint32_t light_offset = 0);
+#endif //_CLUSTERS_H_
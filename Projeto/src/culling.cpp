@@ -0,0 +1,88 @@
+#include <glm/glm.hpp>
+#include "culling.h"
+
+using glm::mat4, glm::vec4, glm::vec3;
+
+/*! @addtogroup culling
+ * @{*/
+
+/*!
+ * @param[in] vertices array of 3 * nVertices floats, as stored in a .3d file.
+ * @param[in] nVertices number of vertices.
+ * @return the axis aligned box of the vertices.
+ */
+struct aabb aabb_from_vertices (const float *const vertices, const size_t nVertices)
+{
+  struct aabb box;
+  if (nVertices == 0)
+    return box;
+
+  box.min = box.max = vec3 (vertices[0], vertices[1], vertices[2]);
+  for (size_t v = 1; v < nVertices; ++v)
+    {
+      const vec3 p (vertices[3 * v], vertices[3 * v + 1], vertices[3 * v + 2]);
+      box.min = glm::min (box.min, p);
+      box.max = glm::max (box.max, p);
+    }
+  return box;
+}
+
+//! Axis aligned box enclosing the transformed box (Arvo's method).
+struct aabb aabb_transform (const struct aabb &box, const mat4 &M)
+{
+  const vec3 center = (box.min + box.max) * 0.5f;
+  const vec3 extent = (box.max - box.min) * 0.5f;
+  const vec3 new_center = vec3 (M * vec4 (center, 1));
+  const vec3 new_extent = glm::abs (vec3 (M[0])) * extent.x
+                          + glm::abs (vec3 (M[1])) * extent.y
+                          + glm::abs (vec3 (M[2])) * extent.z;
+  return {new_center - new_extent, new_center + new_extent};
+}
+
+struct aabb aabb_merge (const struct aabb &a, const struct aabb &b)
+{
+  return {glm::min (a.min, b.min), glm::max (a.max, b.max)};
+}
+
+/*!
+ * Extracts the clipping planes from a projection * view matrix (Gribb & Hartmann).
+ * Boxes tested against the result must be in the space the matrix maps from.
+ */
+frustum_t frustum_from_matrix (const mat4 &projection_view)
+{
+  const mat4 &M = projection_view;
+  vec4 row[4];
+  for (int r = 0; r < 4; ++r)
+    row[r] = vec4 (M[0][r], M[1][r], M[2][r], M[3][r]);
+
+  frustum_t frustum = {
+      row[3] + row[0], row[3] - row[0], // left, right
+      row[3] + row[1], row[3] - row[1], // bottom, top
+      row[3] + row[2], row[3] - row[2]  // near, far
+  };
+  for (auto &plane: frustum)
+    plane /= glm::length (vec3 (plane));
+  return frustum;
+}
+
+/*!
+ * @return OUTSIDE, INSIDE when the box is entirely inside every plane, INTERSECTING otherwise.
+ */
+int frustum_classify_aabb (const frustum_t &frustum, const struct aabb &box)
+{
+  const vec3 center = (box.min + box.max) * 0.5f;
+  const vec3 extent = (box.max - box.min) * 0.5f;
+  int result = INSIDE;
+  for (const auto &plane: frustum)
+    {
+      const float distance = glm::dot (vec3 (plane), center) + plane.w;
+      const float radius = glm::dot (glm::abs (vec3 (plane)), extent);
+      if (distance < -radius)
+        return OUTSIDE;
+      if (distance < radius)
+        result = INTERSECTING;
+    }
+  return result;
+}
+
+//!@} end of group culling
@@ -0,0 +1,26 @@
+#ifndef _CULLING_H_
+#define _CULLING_H_
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+struct aabb {
+  glm::vec3 min{0, 0, 0};
+  glm::vec3 max{0, 0, 0};
+};
+
+//! Six planes (left, right, bottom, top, near, far) as (normal, distance), normals pointing inwards.
+typedef std::array<glm::vec4, 6> frustum_t;
+
+enum {
+  OUTSIDE = 0,
+  INTERSECTING,
+  INSIDE
+};
+
+struct aabb aabb_from_vertices (const float *vertices, size_t nVertices);
+struct aabb aabb_transform (const struct aabb &box, const glm::mat4 &M);
+struct aabb aabb_merge (const struct aabb &a, const struct aabb &b);
+frustum_t frustum_from_matrix (const glm::mat4 &projection_view);
+int frustum_classify_aabb (const frustum_t &frustum, const struct aabb &box);
+#endif //_CULLING_H_
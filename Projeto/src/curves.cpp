@@ -1,5 +1,6 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <GL/freeglut_std.h>
 #include "curves.h"
 
@@ -98,19 +99,25 @@ align_global_pos_mat (const float global_time,
   rot = {{X_i, 0}, {Y_i, 0}, {Z_i, 0}, zero_one};
 }
 
-void renderCurve (const mat4 M, const vector<vec3> &control_points, const unsigned int tesselation)
+//! @param[out] points tesselation + 1 points along the whole curve, as a line strip.
+void curve_tesselate (const mat4 &M, const vector<vec3> &control_points, const unsigned int tesselation,
+                      vector<vec3> &points)
 {
   const auto step = 1.0 / tesselation;
-  glm::vec3 pos;
   glm::vec3 deriv;
-  glPushMatrix ();
-  glBegin (GL_LINE_STRIP);
+  points.resize (tesselation + 1);
   for (auto t = 0; t <= tesselation; ++t)
-    {
+    get_curve_global_point (t * step, M, control_points, points[t], deriv);
+}
 
-      get_curve_global_point (t * step, M, control_points, pos, deriv);
-      glVertex3f (pos.x, pos.y, pos.z);
-    }
+void renderCurve (const mat4 M, const vector<vec3> &control_points, const unsigned int tesselation)
+{
+  vector<vec3> points;
+  curve_tesselate (M, control_points, tesselation, points);
+  glPushMatrix ();
+  glBegin (GL_LINE_STRIP);
+  for (const auto &pos: points)
+    glVertex3f (pos.x, pos.y, pos.z);
   glEnd ();
 
   //  for (auto p : control_points)
@@ -123,17 +130,20 @@ void renderCurve (const mat4 M, const vector<vec3> &control_points, const unsign
   glPopMatrix ();
 }
 
-void advance_in_curve (const float translation_time,
+/*!
+ * @param[in] gt how far along the whole curve, in [0, 1).
+ * @param[in,out] transform matrix the translation (and alignment) along the curve is applied to.
+ */
+void advance_in_curve (const float gt,
                        const bool align,
                        const mat4 &M,
-                       const vector<vec3> &global_control_points)
+                       const vector<vec3> &global_control_points,
+                       mat4 &transform)
 {
-  // (x%N)/N
-  float gt = fmodf ((float) glutGet (GLUT_ELAPSED_TIME), (float) (translation_time * 1000)) / (translation_time * 1000);
   vec3 pos;
   mat4 rot;
   align_global_pos_mat (gt, M, global_control_points, pos, rot);
-  glTranslatef (pos.x, pos.y, pos.z);
+  transform = glm::translate (transform, pos);
   if (align)
-    glMultMatrixf (value_ptr (rot));
+    transform *= rot;
 }
@@ -5,8 +5,11 @@
 #include <glm/glm.hpp>
 
 extern const glm::mat4 Mcr, Mb;
+void curve_tesselate (const glm::mat4 &M, const std::vector<glm::vec3> &control_points, unsigned int tesselation,
+                      std::vector<glm::vec3> &points);
 void renderCurve (glm::mat4 M, const std::vector<glm::vec3> &control_points, unsigned int tesselation = 100);
-void advance_in_curve (float translation_time, bool align, const glm::mat4 &M, const std::vector<glm::vec3> &global_control_points);
+void advance_in_curve (float gt, bool align, const glm::mat4 &M,
+                       const std::vector<glm::vec3> &global_control_points, glm::mat4 &transform);
 void get_curve_point_at (
     float t,
     const glm::mat4 &M,
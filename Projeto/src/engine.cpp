@@ -7,26 +7,52 @@
 
 #include <GL/glew.h>
 #include <GL/glut.h>
+#include <GL/freeglut_ext.h>
 
 #endif
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <cmath>
 #include <iostream>
 #include <vector>
 #include <tuple>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unistd.h>
 
 #include <IL/il.h>
 #include <glm/glm.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "parsing.h"
 #include "curves.h"
+#include "models.h"
+#include "culling.h"
+#include "bvh.h"
+#include "render_queue.h"
+#include "shader.h"
+#include "sim_clock.h"
+#include "profiler.h"
+#include "stats.h"
+#include "overlay.h"
+#include "file_watch.h"
+#include "frame_scheduler.h"
+#include "frame_pipeline.h"
+#include "jobs.h"
+#include "asset_io.h"
+#ifdef USE_HEADLESS
+#include <chrono>
+#include "headless.h"
+#endif
 
-using std::vector, std::tuple, std::map;
-using glm::mat4, glm::vec4, glm::vec3, glm::cross, glm::value_ptr;
+using std::vector, std::tuple, std::map, std::set;
+using glm::mat4, glm::vec4, glm::vec3, glm::vec2, glm::cross, glm::value_ptr;
 using std::cerr, std::endl, glm::to_string, std::string;
 
 /*rotation*/
@@ -51,6 +77,110 @@ static float globalScaleX = 1;
 static float globalScaleY = 1;
 static float globalScaleZ = 1;
 
+/*rendering*/
+enum {
+  RENDERER_FIXED = 0, // fixed-function pipeline, the fallback
+  RENDERER_SHADER     // core profile with per pixel Blinn-Phong
+};
+static int globalRenderer = RENDERER_FIXED;
+static struct phong_program globalPhong;
+static struct cluster_grid globalClusters; // shader renderer only
+static bool globalHeadless = false; // rendering offscreen without GLUT, see engine_headless_run
+static bool globalWireframe = false; // polygons drawn as their edges, as in the references of phases 1 and 2
+
+//! time every animation reads, ticked once per frame simulated by engine_simulate
+static struct sim_clock globalClock;
+
+//! when the window is redrawn, see engineIdle
+static struct frame_scheduler globalScheduler;
+
+void engineIdle ();
+bool engine_animating ();
+
+//! Has the window redrawn, for input, a camera change or a reloaded scene.
+void engine_request_frame ()
+{
+  frame_scheduler_invalidate (globalScheduler);
+  if (!globalHeadless)
+    glutIdleFunc (engineIdle);
+}
+
+/*!
+ * Clock keys, shared by every camera profile:
+ *     p       pause/resume
+ *     [ ]     time scale ÷2 ×2
+ *     { }     seek 1 second back/forward
+ * @return whether the key was handled.
+ */
+bool clockKeyboard (const unsigned char key)
+{
+  switch (key)
+    {
+      case 'p':
+        globalClock.paused = !globalClock.paused;
+      break;
+      case '[':
+        globalClock.scale /= 2;
+      break;
+      case ']':
+        globalClock.scale *= 2;
+      break;
+      case '{':
+        sim_clock_seek (globalClock, globalClock.time - 1);
+      break;
+      case '}':
+        sim_clock_seek (globalClock, globalClock.time + 1);
+      break;
+      default:
+        return false;
+    }
+  cerr << "[clock] time: " << globalClock.time << " s, scale: " << globalClock.scale
+       << (globalClock.paused ? ", paused" : "") << endl;
+  engine_request_frame ();
+  return true;
+}
+
+//! where the frame profiler trace is written at exit, see engine_trace_at_exit
+static const char *globalTracePath = nullptr;
+
+//! statistics overlay, drawn over the scene by engine_frame_stats when shown
+static struct overlay globalOverlay;
+static bool globalShowOverlay = false;
+static struct frame_history globalFrameHistory;
+//! wall time between frames drawn back to back, which the frame rate is taken from
+static struct frame_history globalIntervalHistory;
+//! real seconds at which the frame being drawn began, see engine_frame_stats
+static double globalFrameBegin = 0;
+//! per-frame counters are appended to it when given with -c
+static FILE *globalStatsFile = nullptr;
+
+/*!
+ * Statistics keys, shared by every camera profile:
+ *     v       show/hide the statistics overlay
+ *     f       write the recorded frames as a Chrome trace (see profiler_export_chrome)
+ * @return whether the key was handled.
+ */
+bool statsKeyboard (const unsigned char key)
+{
+  switch (key)
+    {
+      case 'v':
+        globalShowOverlay = !globalShowOverlay;
+      break;
+      case 'f':
+        profiler_export_chrome (globalTracePath ? globalTracePath : "trace.json");
+      break;
+      default:
+        return false;
+    }
+  engine_request_frame ();
+  return true;
+}
+
+// set by the camera of the active profile and by the reshape callback
+static mat4 globalView{1};
+static mat4 globalProjection{1};
+
 /*! @addtogroup camera
  * @{*/
 
@@ -153,7 +283,6 @@ int globalHeight = 9 * 50;
 bool globalLockCenter = false;
 auto globalPitch = 0.0, globalYaw = 0.0;
 
-void fpsTimer (int);
 void fpsPassiveMotion (int, int);
 void fpsCamera ();
 void fpsKeyboard (unsigned char key, int x, int y);
@@ -175,25 +304,17 @@ struct Motion {
 
 Motion globalMotion = {false, false, false, false};
 
-const auto GLOBAL_FPS = 60;
-
 void fpsInit ()
 {
   glutSetCursor (GLUT_CURSOR_NONE);
-  glutTimerFunc (0, fpsTimer, 0);
   //glDepthFunc (GL_LEQUAL);
 }
 
-/*this funtion is used to keep calling the display function periodically
-  at a rate of FPS times in one second. The constant FPS is defined above and
-  has the value of 60
-*/
-void fpsTimer (int)
+//! Whether the camera keeps moving, a movement key being held.
+bool fpsMoving ()
 {
-  glutPostRedisplay ();
-  if (globalLockCenter)
-    glutWarpPointer (globalWidth / 2, globalHeight / 2);
-  glutTimerFunc (1000 / GLOBAL_FPS, fpsTimer, 0);
+  return globalMotion.Forward || globalMotion.Backward || globalMotion.Left || globalMotion.Right
+         || globalMotion.Up || globalMotion.Down;
 }
 
 void fpsPassiveMotion (int x, int y)
@@ -208,9 +329,15 @@ void fpsPassiveMotion (int x, int y)
   dev_x = (globalWidth / 2) - x;
   dev_y = (globalHeight / 2) - y;
 
+  // the warp back to the center is itself reported as a motion, of none
+  if (!dev_x && !dev_y)
+    return;
+
   /* apply the changes to pitch and yaw*/
   globalYaw += dev_x / 10.0;
   globalPitch += dev_y / 10.0;
+  glutWarpPointer (globalWidth / 2, globalHeight / 2);
+  engine_request_frame ();
 }
 auto globalFpsCamX = 0.0, globalFpsCamZ = 0.0, globalFpsCamY = 0.0;
 float globalFpsSens = 1;
@@ -256,14 +383,16 @@ void fpsCamera ()
   if (globalPitch <= -60)
     globalPitch = -60;
 
-  glRotatef (-globalPitch, 1.0, 0.0, 0.0); // Along X axis
-  glRotatef (-globalYaw, 0.0, 1.0, 0.0);    //Along Y axis
-  glTranslatef (-globalFpsCamX, globalFpsCamY, -globalFpsCamZ);
+  mat4 view = glm::rotate (mat4 (1), glm::radians ((float) -globalPitch), vec3 (1, 0, 0)); // Along X axis
+  view = glm::rotate (view, glm::radians ((float) -globalYaw), vec3 (0, 1, 0));          //Along Y axis
+  globalView = glm::translate (view, vec3 (-globalFpsCamX, globalFpsCamY, -globalFpsCamZ));
 }
 
 void fpsKeyboard (unsigned char key, int x, int y)
 {
   const unsigned char ESC = 27;
+  if (clockKeyboard (key) || statsKeyboard (key))
+    return;
 
   switch (key)
     {
@@ -310,6 +439,7 @@ void fpsKeyboard (unsigned char key, int x, int y)
         globalMotion.Up = true;
       break;
     }
+  engine_request_frame ();
 }
 
 void fpsKeyboardUp (unsigned char key, int x, int y)
@@ -341,6 +471,7 @@ void fpsKeyboardUp (unsigned char key, int x, int y)
         globalMotion.Up = false;
       break;
     }
+  engine_request_frame ();
 }
 
 //! @} end of group fpsCamera
@@ -354,6 +485,7 @@ void explMouse (int button, int state, int x, int y);
 void explMotion (int x, int y);
 void explTimer (int);
 void env_load_defaults ();
+bool operations_pick (int x, int y, vec3 &center);
 
 const profile_t globalProfile_EXPL = {
     .mouseFunc = explMouse,
@@ -446,7 +578,7 @@ cartesian2Spherical (const double x, const double y, const double z,
 void explRedisplay ()
 {
   spherical2Cartesian (globalRadius, globalElevation, globalAzimuth, &globalEyeX, &globalEyeY, &globalEyeZ);
-  glutPostRedisplay ();
+  engine_request_frame ();
 }
 
 void env_load_defaults ()
@@ -519,8 +651,12 @@ void explKeyboard (unsigned char key, int xmouse, int ymouse)
           1 2 3 ⎫       ! @ # ⎫        EyeX     EyeY     EyeZ
           4 5 6 ⎬↓      $ % ^ ⎬↑       CenterX  CenterY  CenterZ
           7 8 9 ⎭       & * ( ⎭        UpX      UpY      UpZ
+      clock: p [ ] { } (see clockKeyboard)
+      statistics: v f (see statsKeyboard)
    */
   const unsigned char ESC = 27;
+  if (clockKeyboard (key) || statsKeyboard (key))
+    return;
   switch (key)
     {
       case ESC:
@@ -754,43 +890,14 @@ void explMouse (int button, int state, int x, int y)
         }
       else if (button == GLUT_RIGHT_BUTTON)
         {
-          if (state == GLUT_DOWN)
+          // look at the model under the cursor
+          vec3 center;
+          if (state == GLUT_DOWN && operations_pick (x, y, center))
             {
-              int window_width = glutGet (GLUT_WINDOW_WIDTH);
-              int window_height = glutGet (GLUT_WINDOW_HEIGHT);
-
-              GLbyte color[4];
-              GLfloat depth;
-              GLuint index;
-
-              //glReadPixels (x, window_height - y - 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, color);
-              glReadPixels (x, window_height - y - 1, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth);
-              //glReadPixels (x, window_height - y - 1, 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_INT, &index);
-
-              double ox, oy, oz;
-
-              double model[16];
-              glGetDoublev (GL_MODELVIEW_MATRIX, model);
-              double proj[16];
-              glGetDoublev (GL_PROJECTION_MATRIX, proj);
-              int view[4];
-              glGetIntegerv (GL_VIEWPORT, view);
-              gluUnProject (x, window_height - y - 1, depth,
-                            model,
-                            proj,
-                            view,
-                            &ox, &oy, &oz);
-              fprintf (stderr, "%d %d\n", x, y);
-              //globalTranslateX = -ox;
-              //globalTranslateZ = -oz;
-              /*cartesian2Spherical (ox, globalEyeY, oz,
-                                   &globalRadius, &globalAzimuth, &globalElevation);*/
-              //              globalTranslateX = ox;
-              //              globalTranslateZ = oz;
-              globalCenterX = ox;
-              globalCenterZ = oz;
-
-              fprintf (stderr, "%f %f %f\n", ox, oy, oz);
+              globalCenterX = center.x;
+              globalCenterY = center.y;
+              globalCenterZ = center.z;
+              fprintf (stderr, "%f %f %f\n", center.x, center.y, center.z);
             }
         }
     }
@@ -832,21 +939,23 @@ void explMotion (int x, int y)
 void explCamera ()
 {
   // set the camera
-  gluLookAt (globalEyeX, globalEyeY, globalEyeZ,
-             globalCenterX, globalCenterY, globalCenterZ,
-             globalUpX, globalUpY, globalUpZ);
-  //draw_axes ();
+  mat4 view = glm::lookAt (vec3 (globalEyeX, globalEyeY, globalEyeZ),
+                           vec3 (globalCenterX, globalCenterY, globalCenterZ),
+                           vec3 (globalUpX, globalUpY, globalUpZ));
 
   // put the geometric transformations here
-  glRotatef (globalAngle, globalRotateX, globalRotateY, globalRotateZ);
-  glTranslatef (globalTranslateX, globalTranslateY, globalTranslateZ);
-  glScalef (globalScaleX, globalScaleY, globalScaleZ);
+  const vec3 axis (globalRotateX, globalRotateY, globalRotateZ);
+  if (globalAngle != 0 && axis != vec3 (0))
+    view = glm::rotate (view, glm::radians (globalAngle), axis);
+  view = glm::translate (view, vec3 (globalTranslateX, globalTranslateY, globalTranslateZ));
+  globalView = glm::scale (view, vec3 (globalScaleX, globalScaleY, globalScaleZ));
 
-  explRedisplay ();
+  // the eye of the next frame, drawing it only if something changes
+  spherical2Cartesian (globalRadius, globalElevation, globalAzimuth, &globalEyeX, &globalEyeY, &globalEyeZ);
 }
 void explTimer (int)
 {
-  glutPostRedisplay ();
+  engine_request_frame ();
 }
 
 //! @} end of group explorerCamera
@@ -862,6 +971,7 @@ void changeProfile ()
 {
   globalProfileHasChanged = true;
   globalProfile = (globalProfile + 1) % NPROFILES;
+  engine_request_frame ();
 }
 
 //! @} end of group camera
@@ -872,93 +982,366 @@ void changeProfile ()
  * @{*/
 
 const auto RGB_MAX = 255.0;
+struct material {
+  // default values specified at (page 5)[Phase 4 – Normals and Texture Coordinates][Practical Assignment CG - 2021/22 pdf]
+  vec4 diffuse{200.0 / RGB_MAX, 200.0 / RGB_MAX, 200.0 / RGB_MAX, 1};
+  vec4 ambient{50.0 / RGB_MAX, 50.0 / RGB_MAX, 50.0 / RGB_MAX, 1};
+  vec4 specular{0, 0, 0, 1};
+  vec4 emissive{0, 0, 0, 1};
+  GLfloat shininess = 0;
+
+  bool operator== (const struct material &) const = default;
+};
+
+//! Of the floats of a material, -0 hashed as 0 since they compare equal.
+struct material_hash {
+  size_t operator() (const struct material &material) const
+  {
+    static_assert (sizeof (struct material) == 17 * sizeof (GLfloat));
+    GLfloat floats[17];
+    memcpy (floats, &material, sizeof (floats));
+    for (GLfloat &f: floats)
+      f = f == 0 ? 0 : f;
+    return (size_t) xxh64 (floats, sizeof (floats));
+  }
+};
+
 struct model {
+  string file; // the .3d file the buffers were loaded from
+  string texture_file;
   GLsizei nVertices{};
   GLuint vbo{};
   GLuint normals{};
-  struct {
-    // default values specified at (page 5)[Phase 4 – Normals and Texture Coordinates][Practical Assignment CG - 2021/22 pdf]
-    vec4 diffuse{200.0 / RGB_MAX, 200.0 / RGB_MAX, 200.0 / RGB_MAX, 1};
-    vec4 ambient{50.0 / RGB_MAX, 50.0 / RGB_MAX, 50.0 / RGB_MAX, 1};
-    vec4 specular{0, 0, 0, 1};
-    vec4 emissive{0, 0, 0, 1};
-    GLfloat shininess = 0;
-  } material{};
+  struct material material{};
+  unsigned int material_id = 0; // models with equal materials share the id
   // 0 default value means it's optional with 0 meaning it's not being used by a particular model.
   GLuint tbo = 0; // texture buffer object
+  uint64_t texture_bytes = 0; // of tbo, mipmaps included
   GLuint tc = 0; // texture coordinates
+  GLuint vao = 0; // shader renderer only, binds the three buffers above to the program's attributes
+  uint64_t buffer_bytes = 0; // of vbo, normals and tc
+  // shader renderer only: the buffers hold quantized attributes, positions being offset + scale * p / 65535
+  bool quantized = false;
+  vec3 position_offset{0};
+  vec3 position_scale{1};
+  // vbo holds the attributes of each vertex together, as a model_vertex, normals and tc being 0
+  bool interleaved = false;
+  bool streaming = false; // chunks of the vbo are still being uploaded, see model_streams_upload
+  struct aabb bounds; // in model space, computed when loading the .3d file
+
+  // updated every frame by operations_update, on the simulation thread
+  mat4 world{1};
+  struct aabb world_box;
+  bool dynamic = false; // has an animated transform, so its world_box changes every frame
+  bool visible = true;
 };
 
 static std::vector<struct model> globalModels;
 static std::vector<float> globalOperations;
+static std::vector<struct light> globalLights;
 
-struct model allocModel (const char *const model3dFilePath)
+//! over the world boxes of globalModels, items being model indices
+static struct bvh globalBVH;
+
+//! What the next operations_update builds from the operations, on the GL thread as it uploads them.
+struct scene_build {
+  bool camera = true; // the default camera, on the first pass only
+  bool scene = true;  // models, curves and lights, on the first pass and after a reload
+};
+static struct scene_build globalSceneBuild;
+//! builds of the scene so far
+static uint64_t globalSceneGeneration = 0;
+//! has animated transforms, so it changes with the clock
+static bool globalSceneAnimated = false;
+//! control points of the curves, in traversal order, built with the scene
+static vector<vector<vec3>> globalCurves;
+
+//! simulates frames ahead of the GL thread drawing them, see engine_simulate
+static struct frame_pipeline globalPipeline;
+static bool globalPipelined = true;
+//! the packet of the next frame is being simulated already
+static bool globalSimulatedAhead = false;
+static uint64_t globalFrame = 0;
+//! runs the phases of each frame's simulation across the cores
+static struct job_system globalJobs;
+static unsigned int globalJobWorkers = job_system_default_workers ();
+
+//! GL state last set by renderModel, so that redundant changes are skipped.
+struct render_state {
+  GLuint texture = ~0u;
+  int material = -1;
+  bool texture_coordinates = true; // whether their client array is enabled
+};
+
+struct render_stats {
+  unsigned int draw_calls = 0;
+  unsigned int triangles = 0;
+  unsigned int buffer_binds = 0;
+  unsigned int texture_binds = 0;
+  unsigned int material_changes = 0;
+};
+
+//! counters of the last submitted frame
+struct render_stats globalRenderStats;
+
+//! bytes uploaded to the GPU, freed when a reload drops models
+struct gpu_memory {
+  uint64_t texture_bytes = 0;
+  uint64_t buffer_bytes = 0;
+};
+struct gpu_memory globalGpuMemory;
+
+//! of the frame last drawn, which the clock may be ahead of
+uint64_t globalDrawnFrame = 0;
+unsigned int globalDrawnModels = 0;
+unsigned int globalCulledModels = 0;
+
+//! models and textures of the scene being built, read ahead of it
+static struct asset_io globalAssetIO;
+//! threads reading them when io_uring is not available, waiting on the disk rather than the cores
+const unsigned int ASSET_IO_THREADS = 4;
+
+//! A buffer object of the data.
+static GLuint model_buffer (const void *const data, const size_t bytes)
+{
+  GLuint buffer;
+  glGenBuffers (1, &buffer);
+  glBindBuffer (GL_ARRAY_BUFFER, buffer);
+  glBufferData (GL_ARRAY_BUFFER, (GLsizeiptr) bytes, data, GL_STATIC_DRAW);
+  return buffer;
+}
+
+/*! @addtogroup modelStreaming
+ * @{
+ * Chunked models are drawn as they are read: their buffer is allocated whole, its
+ * bounds being known from its header, and their chunks uploaded into it
+ * a few each frame, the model drawing the triangles uploaded so far. A single chunk
+ * is held in memory at a time, whatever the size of the model. Offscreen, where
+ * every frame is to be of the whole scene, they are uploaded at once.
+ */
+
+//! A chunked model whose chunks are being uploaded.
+struct model_stream {
+  GLuint vbo = 0; // of the model, which it is found by
+  size_t model = SIZE_MAX; // in globalModels, once found
+  struct model_chunks chunks;
+  GLsizei uploaded = 0; // vertices, the first of the buffer
+};
+static vector<struct model_stream> globalModelStreams;
+//! milliseconds of a frame spent uploading chunks at most, a chunk being uploaded at least
+const double MODEL_STREAM_MS = 4;
+
+//! Uploads the next chunk of the stream into its buffer. @return whether there was one left.
+static bool model_stream_upload (struct model_stream &stream)
 {
-  FILE *fp = fopen (model3dFilePath, "r");
-  if (!fp)
+  // the one chunk held in memory, of any stream
+  static vector<struct model_vertex> chunk;
+  if (!model_chunks_read (stream.chunks, chunk))
+    return false;
+  glBindBuffer (GL_ARRAY_BUFFER, stream.vbo);
+  glBufferSubData (GL_ARRAY_BUFFER, (GLintptr) (stream.uploaded * sizeof (struct model_vertex)),
+                   (GLsizeiptr) (chunk.size () * sizeof (struct model_vertex)), chunk.data ());
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
+  stream.uploaded += (GLsizei) chunk.size ();
+  return true;
+}
+
+//! Uploads chunks for as long as a frame allows, the models drawing what was uploaded.
+void model_streams_upload ()
+{
+  if (globalModelStreams.empty ())
+    return;
+  profiler_scope scope ("streaming");
+  const double begin = profiler_now ();
+  bool uploaded = false;
+  for (auto stream = globalModelStreams.begin (); stream != globalModelStreams.end ();)
     {
-      cerr << "failed to open model: " << model3dFilePath << endl;
-      exit (EXIT_FAILURE);
+      if (uploaded && profiler_now () - begin > MODEL_STREAM_MS * 1000)
+        return;
+      if (stream->model == SIZE_MAX)
+        for (size_t m = 0; m < globalModels.size () && stream->model == SIZE_MAX; ++m)
+          if (globalModels[m].vbo == stream->vbo)
+            stream->model = m;
+      // a model at a time, so models are whole one after the other
+      const bool more = model_stream_upload (*stream);
+      uploaded = true;
+      if (stream->model != SIZE_MAX)
+        {
+          globalModels[stream->model].nVertices = stream->uploaded;
+          globalModels[stream->model].streaming = more;
+        }
+      if (more)
+        continue;
+      model_chunks_close (stream->chunks);
+      stream = globalModelStreams.erase (stream);
     }
+}
 
-  cerr << "[allocModel] model file = " << model3dFilePath << endl;
-  // read number of vertices
-  GLsizei nVertices;
-  fread (&nVertices, sizeof (nVertices), 1, fp);
-  cerr << "[allocModel] nVertices = " << nVertices << endl;
+//! Drops the streams, their models being freed with the scene they are of.
+void model_streams_drop ()
+{
+  for (auto &stream: globalModelStreams)
+    model_chunks_close (stream.chunks);
+  globalModelStreams.clear ();
+}
 
-  // read vertices
-  auto *arrayOfVertices = (float *) malloc (3 * nVertices * sizeof (float));
-  const size_t nVerticesRead = fread (arrayOfVertices, 3 * sizeof (float), nVertices, fp);
-  if (nVerticesRead != nVertices)
+//! Allocates the buffer of a chunked model, whose chunks are uploaded by model_streams_upload.
+static struct model allocModelChunked (const char *const path, struct model_chunks &chunks)
+{
+  cerr << "[allocModel] nVertices = " << chunks.nVertices << ", in " << chunks.chunks.size () << " chunks" << endl;
+  struct model model;
+  model.file = path;
+  model.interleaved = true;
+  // known before any vertex is read
+  model.bounds = {chunks.bounds.min, chunks.bounds.max};
+  model.buffer_bytes = chunks.nVertices * sizeof (struct model_vertex);
+  model.vbo = model_buffer (nullptr, model.buffer_bytes);
+  globalGpuMemory.buffer_bytes += model.buffer_bytes;
+
+  if (globalRenderer == RENDERER_SHADER)
     {
-      cerr << nVerticesRead << " = nVerticesRead != nVertices = " << nVertices << endl;
-      exit (EXIT_FAILURE);
+      const GLsizei stride = sizeof (struct model_vertex);
+      glGenVertexArrays (1, &model.vao);
+      glBindVertexArray (model.vao);
+      glVertexAttribPointer (ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, stride,
+                             (const void *) offsetof (struct model_vertex, position));
+      glEnableVertexAttribArray (ATTRIBUTE_POSITION);
+      glVertexAttribPointer (ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, stride,
+                             (const void *) offsetof (struct model_vertex, normal));
+      glEnableVertexAttribArray (ATTRIBUTE_NORMAL);
+      glVertexAttribPointer (ATTRIBUTE_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride,
+                             (const void *) offsetof (struct model_vertex, texture));
+      glEnableVertexAttribArray (ATTRIBUTE_TEXCOORD);
+      glBindVertexArray (0);
     }
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
 
-  // read normals
-  auto *arrayOfNormals = (float *) malloc (3 * nVertices * sizeof (float));
-  const size_t nNormalsRead = fread (arrayOfNormals, 3 * sizeof (float), nVertices, fp);
-  if (nNormalsRead != nVertices)
+  struct model_stream stream;
+  stream.vbo = model.vbo;
+  stream.chunks = chunks;
+  if (globalHeadless)
     {
-      cerr << nNormalsRead << " = nNormalsRead != nVertices = " << nVertices << endl;
-      exit (EXIT_FAILURE);
+      while (model_stream_upload (stream))
+        ;
+      model_chunks_close (stream.chunks);
+      model.nVertices = stream.uploaded;
+      return model;
     }
+  model.streaming = true;
+  globalModelStreams.push_back (stream);
+  return model;
+}
+
+/*!
+ * Whether the reading threads are to leave a file to the build, told by its first bytes:
+ * chunked models are read a chunk at a time as they are uploaded instead of whole.
+ */
+static bool engine_read_ahead_skip (const string &path, const char *const head, const size_t size)
+{
+  return path.ends_with (".3d") && model_chunked (head, size);
+}
 
-  // read texture coordinates
-  auto *arrayOfTextureCoordinates = (float *) malloc (2 * nVertices * sizeof (float));
-  const size_t nTextureCoordinatesRead = fread (arrayOfTextureCoordinates, 2 * sizeof (float), nVertices, fp);
-  if (nTextureCoordinatesRead != nVertices)
+//! @} end of group modelStreaming
+
+/*!
+ * Loads a .3d file into buffer objects. Quantized models are uploaded as they are
+ * for the shader renderer, which dequantizes them in the vertex stage, and as floats
+ * for the fixed-function pipeline, which cannot. Their bounds are those of their
+ * header, the vertices of legacy models being scanned for them, and models without
+ * texture coordinates get no buffer of them.
+ */
+struct model allocModel (const char *const model3dFilePath)
+{
+  cerr << "[allocModel] model file = " << model3dFilePath << endl;
+  vector<vec3> vertices;
+  vector<vec3> normals;
+  vector<vec2> texture_coordinates;
+  struct model_quantized quantized;
+  struct model_quantized *const keep_quantized = globalRenderer == RENDERER_SHADER ? &quantized : nullptr;
+  const char *data;
+  size_t size;
+  struct model_chunks chunks;
+  struct model_header header;
+  if (asset_io_wait (globalAssetIO, model3dFilePath, data, size))
+    model_read_memory (model3dFilePath, data, size, vertices, normals, texture_coordinates, keep_quantized,
+                       &header);
+  else if (model_chunks_open (model3dFilePath, chunks))
+    return allocModelChunked (model3dFilePath, chunks);
+  else
+    model_read (model3dFilePath, vertices, normals, texture_coordinates, keep_quantized, &header);
+
+  struct model model;
+  model.file = model3dFilePath;
+  model.quantized = !quantized.positions.empty ();
+  if (model.quantized)
     {
-      fprintf (stderr, "%zu = nTextureCoordinatesRead != nVertices = %ul", nTextureCoordinatesRead, nVertices);
-      exit (EXIT_FAILURE);
+      model.position_offset = quantized.offset;
+      // the positions are read normalized, p / 65535, so the scale is that of the bounds
+      model.position_scale = quantized.scale;
+    }
+  model.nVertices = (GLsizei) (model.quantized ? quantized.nVertices : vertices.size ());
+  cerr << "[allocModel] nVertices = " << model.nVertices << endl;
+  if (header.version)
+    model.bounds = {header.min, header.max};
+  else
+    {
+      if (model.quantized)
+        model_dequantize_positions (quantized, vertices);
+      model.bounds = aabb_from_vertices ((const float *) vertices.data (), vertices.size ());
     }
 
-  fclose (fp);
+  // vertices, normals and texture coordinates buffer object arrays
+  if (model.quantized)
+    {
+      const size_t positions = sizeof (quantized.positions[0]) * quantized.positions.size ();
+      const size_t normal_components = quantized.normals.size ();
+      const size_t halfs = sizeof (quantized.texture[0]) * quantized.texture.size ();
+      model.vbo = model_buffer (quantized.positions.data (), positions);
+      model.normals = model_buffer (quantized.normals.data (), normal_components);
+      model.tc = halfs ? model_buffer (quantized.texture.data (), halfs) : 0;
+      model.buffer_bytes = positions + normal_components + halfs;
+    }
+  else
+    {
+      const size_t sizeOfVertexArray = sizeof (vertices[0]) * vertices.size ();
+      const size_t sizeOfNormalsArray = sizeof (normals[0]) * normals.size ();
+      const size_t sizeOfTextureCoordinateArray = sizeof (texture_coordinates[0]) * texture_coordinates.size ();
+      model.vbo = model_buffer (vertices.data (), sizeOfVertexArray);
+      model.normals = model_buffer (normals.data (), sizeOfNormalsArray);
+      model.tc = sizeOfTextureCoordinateArray
+                 ? model_buffer (texture_coordinates.data (), sizeOfTextureCoordinateArray)
+                 : 0;
+      model.buffer_bytes = sizeOfVertexArray + sizeOfNormalsArray + sizeOfTextureCoordinateArray;
+    }
+  globalGpuMemory.buffer_bytes += model.buffer_bytes;
 
-  struct model model;
-  model.nVertices = nVertices;
-
-  // vertices buffer object array
-  const GLsizei sizeOfVertexArray = (GLsizei) sizeof (arrayOfVertices[0]) * 3 * model.nVertices;
-  glGenBuffers (1, &model.vbo);
-  glBindBuffer (GL_ARRAY_BUFFER, model.vbo);
-  glBufferData (GL_ARRAY_BUFFER, sizeOfVertexArray, arrayOfVertices, GL_STATIC_DRAW);
-  free (arrayOfVertices);
-
-  // normals buffer object array
-  const GLsizei sizeOfNormalsArray = (GLsizei) sizeof (arrayOfNormals[0]) * 3 * model.nVertices;
-  glGenBuffers (1, &model.normals);
-  glBindBuffer (GL_ARRAY_BUFFER, model.normals);
-  glBufferData (GL_ARRAY_BUFFER, sizeOfNormalsArray, arrayOfNormals, GL_STATIC_DRAW);
-  free (arrayOfNormals);
-
-  // texture coordinates buffer object array
-  const GLsizei sizeOfTextureCoordinateArray = (GLsizei) sizeof (arrayOfVertices[0]) * 2 * model.nVertices;
-  glGenBuffers (1, &model.tc);
-  glBindBuffer (GL_ARRAY_BUFFER, model.tc);
-  glBufferData (GL_ARRAY_BUFFER, sizeOfTextureCoordinateArray, arrayOfTextureCoordinates, GL_STATIC_DRAW);
-  free (arrayOfTextureCoordinates);
+  if (globalRenderer == RENDERER_SHADER)
+    {
+      glGenVertexArrays (1, &model.vao);
+      glBindVertexArray (model.vao);
+      glBindBuffer (GL_ARRAY_BUFFER, model.vbo);
+      if (model.quantized)
+        glVertexAttribPointer (ATTRIBUTE_POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0, nullptr);
+      else
+        glVertexAttribPointer (ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+      glEnableVertexAttribArray (ATTRIBUTE_POSITION);
+      glBindBuffer (GL_ARRAY_BUFFER, model.normals);
+      if (model.quantized)
+        glVertexAttribPointer (ATTRIBUTE_NORMAL, 2, quantized.normal_bits == 16 ? GL_SHORT : GL_BYTE, GL_TRUE, 0,
+                               nullptr);
+      else
+        glVertexAttribPointer (ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+      glEnableVertexAttribArray (ATTRIBUTE_NORMAL);
+      // left disabled without them, the attribute then reading as zeros
+      if (model.tc)
+        {
+          glBindBuffer (GL_ARRAY_BUFFER, model.tc);
+          glVertexAttribPointer (ATTRIBUTE_TEXCOORD, 2, model.quantized ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, 0,
+                                 nullptr);
+          glEnableVertexAttribArray (ATTRIBUTE_TEXCOORD);
+        }
+      glBindVertexArray (0);
+    }
 
   // unbind array buffer
   glBindBuffer (GL_ARRAY_BUFFER, 0);
@@ -983,7 +1366,11 @@ void associate_a_texture_to_model (struct model &m, const char *const path)
   ilGenImages (1, &image);
   ilBindImage (image);
 
-  const ILboolean has_loaded_successfully = ilLoadImage ((ILstring) path);
+  const char *data;
+  size_t size;
+  const ILboolean has_loaded_successfully = asset_io_wait (globalAssetIO, path, data, size)
+                                            ? ilLoadL (ilTypeFromExt ((ILstring) path), data, (ILuint) size)
+                                            : ilLoadImage ((ILstring) path);
   if (!has_loaded_successfully)
     {
       cerr << "[engine] failed loading texture file '" << path << "'"
@@ -1024,6 +1411,10 @@ void associate_a_texture_to_model (struct model &m, const char *const path)
                 GL_RGBA, GL_UNSIGNED_BYTE, texData);
 
   glGenerateMipmap (GL_TEXTURE_2D);
+  // the mipmaps add a third
+  m.texture_file = path;
+  m.texture_bytes = 4 * (uint64_t) texture_width * texture_height * 4 / 3;
+  globalGpuMemory.texture_bytes += m.texture_bytes;
 
   // unbind texture
   glBindTexture (GL_TEXTURE_2D, 0);
@@ -1031,7 +1422,139 @@ void associate_a_texture_to_model (struct model &m, const char *const path)
   isFirstTimeBeingExecuted = false;
 }
 
-void renderModel (const struct model &model)
+/*! @addtogroup hotReload
+ * @{
+ * A reload keeps the GL objects of the live scene in a pool, by the files they were
+ * loaded from, and rebuilds the scene from the operations taking them back from it:
+ * only models and textures whose files changed, or that the new scene adds, are read
+ * again. What the pool still holds once the scene is rebuilt is no longer used and freed.
+ */
+
+//! GL objects of the previous scene waiting to be reused, the models holding either buffers or a texture.
+struct scene_pool {
+  map<string, vector<struct model>> buffers;  // by .3d file
+  map<string, vector<struct model>> textures; // by texture file
+  unsigned int reused = 0;
+  unsigned int loaded = 0;
+  double begin = 0; // profiler_now () when the reload started
+};
+static struct scene_pool globalScenePool;
+
+void model_free_buffers (struct model &m)
+{
+  if (!m.vbo)
+    return;
+  const GLuint buffers[3] = {m.vbo, m.normals, m.tc};
+  glDeleteBuffers (3, buffers);
+  if (m.vao)
+    glDeleteVertexArrays (1, &m.vao);
+  globalGpuMemory.buffer_bytes -= m.buffer_bytes;
+  m.buffer_bytes = 0;
+  m.vbo = m.normals = m.tc = m.vao = 0;
+}
+
+void model_free_texture (struct model &m)
+{
+  if (!m.tbo)
+    return;
+  glDeleteTextures (1, &m.tbo);
+  globalGpuMemory.texture_bytes -= m.texture_bytes;
+  m.tbo = 0;
+  m.texture_bytes = 0;
+}
+
+/*!
+ * Moves the GL objects of the models into the pool, but for those loaded from a
+ * changed file, which are freed.
+ */
+void scene_pool_fill (struct scene_pool &pool, vector<struct model> &models, const set<string> &changed)
+{
+  for (auto &model: models)
+    {
+      if (model.tbo && !changed.count (model.texture_file))
+        {
+          struct model texture;
+          texture.texture_file = model.texture_file;
+          texture.tbo = model.tbo;
+          texture.texture_bytes = model.texture_bytes;
+          pool.textures[model.texture_file].push_back (texture);
+          model.tbo = 0;
+        }
+      model_free_texture (model);
+      // models still streaming are read again, their streams being dropped with the scene
+      if (model.vbo && !model.streaming && !changed.count (model.file))
+        {
+          model.texture_file.clear ();
+          pool.buffers[model.file].push_back (model);
+        }
+      else
+        model_free_buffers (model);
+    }
+  models.clear ();
+}
+
+//! A model of the .3d file, its buffers taken from the pool when it has them, else loaded.
+struct model scene_pool_model (struct scene_pool &pool, const char *const path)
+{
+  const auto found = pool.buffers.find (path);
+  if (found == pool.buffers.end () || found->second.empty ())
+    {
+      ++pool.loaded;
+      return allocModel (path);
+    }
+  const struct model &pooled = found->second.back ();
+  struct model model;
+  model.file = pooled.file;
+  model.nVertices = pooled.nVertices;
+  model.vbo = pooled.vbo;
+  model.normals = pooled.normals;
+  model.tc = pooled.tc;
+  model.vao = pooled.vao;
+  model.buffer_bytes = pooled.buffer_bytes;
+  model.quantized = pooled.quantized;
+  model.position_offset = pooled.position_offset;
+  model.position_scale = pooled.position_scale;
+  model.interleaved = pooled.interleaved;
+  model.bounds = pooled.bounds;
+  found->second.pop_back ();
+  ++pool.reused;
+  return model;
+}
+
+//! Gives the model the texture, taken from the pool when it has it, else loaded.
+void scene_pool_texture (struct scene_pool &pool, struct model &m, const char *const path)
+{
+  const auto found = pool.textures.find (path);
+  if (found == pool.textures.end () || found->second.empty ())
+    {
+      ++pool.loaded;
+      associate_a_texture_to_model (m, path);
+      return;
+    }
+  const struct model &pooled = found->second.back ();
+  m.texture_file = pooled.texture_file;
+  m.tbo = pooled.tbo;
+  m.texture_bytes = pooled.texture_bytes;
+  found->second.pop_back ();
+  ++pool.reused;
+}
+
+//! Frees what the rebuilt scene did not take back.
+void scene_pool_release (struct scene_pool &pool)
+{
+  for (auto &[file, models]: pool.buffers)
+    for (auto &model: models)
+      model_free_buffers (model);
+  for (auto &[file, textures]: pool.textures)
+    for (auto &texture: textures)
+      model_free_texture (texture);
+  pool = {};
+}
+
+//! @} end of group hotReload
+
+//! Draws a model, changing only the texture and material state that differs from the previous model.
+void renderModel (const struct model &model, struct render_state &state)
 {
   if (!model.nVertices % 3)
     {
@@ -1039,32 +1562,153 @@ void renderModel (const struct model &model)
       exit (1);
     }
 
-  // vertex buffer object (slide 14) [class11]
-  glBindBuffer (GL_ARRAY_BUFFER, model.vbo);
-  glVertexPointer (3, GL_FLOAT, 0, nullptr);
+  // models without texture coordinates have no array of them
+  const bool texture_coordinates = model.interleaved || model.tc;
+  if (state.texture_coordinates != texture_coordinates)
+    {
+      if (texture_coordinates)
+        glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+      else
+        glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+      state.texture_coordinates = texture_coordinates;
+    }
+
+  if (model.interleaved)
+    {
+      // the three arrays from the one buffer
+      const GLsizei stride = sizeof (struct model_vertex);
+      glBindBuffer (GL_ARRAY_BUFFER, model.vbo);
+      glVertexPointer (3, GL_FLOAT, stride, (const void *) offsetof (struct model_vertex, position));
+      glNormalPointer (GL_FLOAT, stride, (const void *) offsetof (struct model_vertex, normal));
+      glTexCoordPointer (2, GL_FLOAT, stride, (const void *) offsetof (struct model_vertex, texture));
+      ++globalRenderStats.buffer_binds;
+    }
+  else
+    {
+      // vertex buffer object (slide 14) [class11]
+      glBindBuffer (GL_ARRAY_BUFFER, model.vbo);
+      glVertexPointer (3, GL_FLOAT, 0, nullptr);
 
-  // normals (slide 14) [class11]
-  glBindBuffer (GL_ARRAY_BUFFER, model.normals);
-  glNormalPointer (GL_FLOAT, 0, nullptr);
+      // normals (slide 14) [class11]
+      glBindBuffer (GL_ARRAY_BUFFER, model.normals);
+      glNormalPointer (GL_FLOAT, 0, nullptr);
 
-  // texture coordinates (slide 14) [class11]
-  glBindBuffer (GL_ARRAY_BUFFER, model.tc);
-  glTexCoordPointer (2, GL_FLOAT, 0, nullptr);
+      // texture coordinates (slide 14) [class11]
+      if (model.tc)
+        {
+          glBindBuffer (GL_ARRAY_BUFFER, model.tc);
+          glTexCoordPointer (2, GL_FLOAT, 0, nullptr);
+        }
+      globalRenderStats.buffer_binds += model.tc ? 3 : 2;
+    }
 
   // texture buffer object (slide 14) [class11]
-  glBindTexture (GL_TEXTURE_2D, model.tbo);
+  if (state.texture != model.tbo)
+    {
+      glBindTexture (GL_TEXTURE_2D, model.tbo);
+      state.texture = model.tbo;
+      ++globalRenderStats.texture_binds;
+    }
 
-  //glPushAttrib (GL_ALL_ATTRIB_BITS);
   // define a material for the object(s) (slide 8) [class9]
-  glMaterialfv (GL_FRONT, GL_DIFFUSE, value_ptr (model.material.diffuse));
-  glMaterialfv (GL_FRONT, GL_AMBIENT, value_ptr (model.material.ambient));
-  glMaterialfv (GL_FRONT, GL_SPECULAR, value_ptr (model.material.specular));
-  glMaterialfv (GL_FRONT, GL_EMISSION, value_ptr (model.material.emissive));
-  glMaterialf (GL_FRONT, GL_SHININESS, model.material.shininess);
+  if (state.material != (int) model.material_id)
+    {
+      glMaterialfv (GL_FRONT, GL_DIFFUSE, value_ptr (model.material.diffuse));
+      glMaterialfv (GL_FRONT, GL_AMBIENT, value_ptr (model.material.ambient));
+      glMaterialfv (GL_FRONT, GL_SPECULAR, value_ptr (model.material.specular));
+      glMaterialfv (GL_FRONT, GL_EMISSION, value_ptr (model.material.emissive));
+      glMaterialf (GL_FRONT, GL_SHININESS, model.material.shininess);
+      state.material = (int) model.material_id;
+      ++globalRenderStats.material_changes;
+    }
 
   // drawing
   glDrawArrays (GL_TRIANGLES, 0, model.nVertices);
-  //glPopAttrib ();
+  ++globalRenderStats.draw_calls;
+  globalRenderStats.triangles += model.nVertices / 3;
+}
+
+//! Draws a model with the Blinn-Phong program, which must be in use, changing only the state that differs.
+void renderModelShaded (const struct model &model, const mat4 &modelview, struct render_state &state)
+{
+  glUniformMatrix4fv (globalPhong.modelview, 1, GL_FALSE, value_ptr (modelview));
+  const glm::mat3 normal_matrix = glm::transpose (glm::inverse (glm::mat3 (modelview)));
+  glUniformMatrix3fv (globalPhong.normal_matrix, 1, GL_FALSE, value_ptr (normal_matrix));
+  glUniform1i (globalPhong.quantized, model.quantized);
+  glUniform3fv (globalPhong.position_offset, 1, value_ptr (model.position_offset));
+  glUniform3fv (globalPhong.position_scale, 1, value_ptr (model.position_scale));
+
+  glBindVertexArray (model.vao);
+  ++globalRenderStats.buffer_binds;
+
+  if (state.texture != model.tbo)
+    {
+      glBindTexture (GL_TEXTURE_2D, model.tbo);
+      glUniform1i (globalPhong.textured, model.tbo != 0);
+      state.texture = model.tbo;
+      ++globalRenderStats.texture_binds;
+    }
+
+  if (state.material != (int) model.material_id)
+    {
+      glUniform4fv (globalPhong.diffuse, 1, value_ptr (model.material.diffuse));
+      glUniform4fv (globalPhong.ambient, 1, value_ptr (model.material.ambient));
+      glUniform4fv (globalPhong.specular, 1, value_ptr (model.material.specular));
+      glUniform4fv (globalPhong.emissive, 1, value_ptr (model.material.emissive));
+      glUniform1f (globalPhong.shininess, model.material.shininess);
+      state.material = (int) model.material_id;
+      ++globalRenderStats.material_changes;
+    }
+
+  glDrawArrays (GL_TRIANGLES, 0, model.nVertices);
+  ++globalRenderStats.draw_calls;
+  globalRenderStats.triangles += model.nVertices / 3;
+}
+
+//! Gives models with equal materials the same material id, in the order they are first seen.
+void operations_assign_material_ids ()
+{
+  std::unordered_map<struct material, unsigned int, material_hash> ids;
+  for (auto &model: globalModels)
+    model.material_id = ids.try_emplace (model.material, (unsigned int) ids.size ()).first->second;
+}
+
+//! Draws the sorted queue of a frame packet, opaque models first and then the transparent ones blended.
+void operations_submit (const struct frame_packet &frame)
+{
+  const vector<struct draw_packet> &queue = frame.queue;
+  const mat4 &view = frame.request.view;
+  struct render_state state;
+  globalRenderStats = {};
+  bool blending = false;
+  for (const auto &packet: queue)
+    {
+      if (!blending && render_key_pass (packet.key) == PASS_TRANSPARENT)
+        {
+          glEnable (GL_BLEND);
+          glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+          glDepthMask (GL_FALSE);
+          blending = true;
+        }
+      const struct model &model = globalModels[packet.model];
+      const mat4 &world = frame.worlds[packet.model];
+      if (globalRenderer == RENDERER_SHADER)
+        renderModelShaded (model, view * world, state);
+      else
+        {
+          glLoadMatrixf (value_ptr (view * world));
+          renderModel (model, state);
+        }
+    }
+  if (blending)
+    {
+      glDisable (GL_BLEND);
+      glDepthMask (GL_TRUE);
+    }
+  if (globalRenderer == RENDERER_SHADER)
+    glBindVertexArray (0);
+  else if (!state.texture_coordinates)
+    glEnableClientState (GL_TEXTURE_COORD_ARRAY);
 
   // unbind array buffer
   glBindBuffer (GL_ARRAY_BUFFER, 0);
@@ -1085,107 +1729,263 @@ void defaultChangeSize (const int w, int h)
   // compute window's aspect ratio
   float ratio = (float) w * 1.0f / (float) h;
 
-  // Set the projection matrix as current
-  glMatrixMode (GL_PROJECTION);
-
-  // Load Identity Matrix
-  glLoadIdentity ();
-
   // Set the viewport to be the entire window
   glViewport (0, 0, w, h);
 
   // Set perspective
-  gluPerspective (globalFOV, ratio, globalNear, globalFar); //fox,near,far
+  globalProjection = glm::perspective (glm::radians (globalFOV), ratio, globalNear, globalFar); //fox,near,far
+  if (globalRenderer == RENDERER_SHADER)
+    clusters_build (globalClusters, globalProjection, globalNear, globalFar);
+
+  if (globalRenderer == RENDERER_FIXED)
+    {
+      // Set the projection matrix as current
+      glMatrixMode (GL_PROJECTION);
+      glLoadMatrixf (value_ptr (globalProjection));
 
-  // return to the model view matrix mode
-  glMatrixMode (GL_MODELVIEW);
+      // return to the model view matrix mode
+      glMatrixMode (GL_MODELVIEW);
+    }
 
   globalWidth = w;
   globalHeight = h;
+  engine_request_frame ();
 }
 //!@} end of group engine
 
-void advance_in_rotation (const float rotation_time, const vec3 &axis_of_rotation)
+//! @param[in] gt how far into a full turn, in [0, 1).
+void advance_in_rotation (const float gt, const vec3 &axis_of_rotation, mat4 &transform)
 {
-  const float gt = fmodf ((float) glutGet (GLUT_ELAPSED_TIME), (float) (rotation_time * 1000)) / (rotation_time * 1000);
   const float angle = 360 * gt;
-  glRotatef (angle, axis_of_rotation.x, axis_of_rotation.y, axis_of_rotation.z);
+  transform = glm::rotate (transform, glm::radians (angle), axis_of_rotation);
 }
 
-//! @ingroup Operations
-void operations_render (vector<float> &operations)
+//! Marks the models outside the view frustum as not visible, counting both in the packet.
+void operations_cull (const frustum_t &frustum, struct frame_packet &packet)
 {
-  unsigned int i = 0;
-  static bool isFirstTimeBeingExecuted = true;
-  static bool hasPushedModels = false;
-  static bool hasLoadedCurves = false;
-
-  static vector<vector<vec3>> curves;
-
-  if (isFirstTimeBeingExecuted)
-    {
-      DEFAULT_GLOBAL_EYE_X = operations[i];
-      DEFAULT_GLOBAL_EYE_Y = operations[i + 1];
-      DEFAULT_GLOBAL_EYE_Z = operations[i + 2];
-    }
-  i += 3;
+  profiler_scope scope ("culling");
+  bool *const visible = arena_array<bool> (packet.arena, globalModels.size ());
+  bvh_cull (globalBVH, frustum, visible);
 
-  if (isFirstTimeBeingExecuted)
+  packet.visible = 0;
+  packet.culled = 0;
+  for (unsigned int m = 0; m < globalModels.size (); ++m)
     {
-      DEFAULT_GLOBAL_CENTER_X = operations[i];
-      DEFAULT_GLOBAL_CENTER_Y = operations[i + 1];
-      DEFAULT_GLOBAL_CENTER_Z = operations[i + 2];
+      globalModels[m].visible = visible[m];
+      if (visible[m])
+        ++packet.visible;
+      else
+        ++packet.culled;
     }
-  i += 3;
+}
 
-  if (isFirstTimeBeingExecuted)
-    {
-      DEFAULT_GLOBAL_UP_X = operations[i];
-      DEFAULT_GLOBAL_UP_Y = operations[i + 1];
-      DEFAULT_GLOBAL_UP_Z = operations[i + 2];
-    }
-  i += 3;
+/*!
+ * Casts a ray from the camera through a window pixel.
+ * @param[out] center world space center of the first model hit.
+ * @return whether a model was hit.
+ */
+bool operations_pick (const int x, const int y, vec3 &center)
+{
+  // the BVH and world boxes are the simulation's
+  frame_pipeline_sync (globalPipeline);
+  const mat4 inverse = glm::inverse (globalProjection * globalView);
+  const float ndc_x = 2.0f * ((float) x + 0.5f) / (float) globalWidth - 1;
+  const float ndc_y = 1 - 2.0f * ((float) y + 0.5f) / (float) globalHeight;
+  vec4 near = inverse * vec4 (ndc_x, ndc_y, -1, 1);
+  vec4 far = inverse * vec4 (ndc_x, ndc_y, 1, 1);
+  near /= near.w;
+  far /= far.w;
+
+  unsigned int picked;
+  float distance;
+  if (!bvh_raycast (globalBVH, vec3 (near), glm::normalize (vec3 (far - near)), picked, distance))
+    return false;
+  const struct aabb &box = globalModels[picked].world_box;
+  center = (box.min + box.max) * 0.5f;
+  cerr << "[engine] picked model " << picked << " at distance " << distance << endl;
+  return true;
+}
 
-  if (isFirstTimeBeingExecuted)
+/*!
+ * Sets the lights of the scene for the current view.
+ * The fixed-function pipeline is limited to GL_LIGHT0 to GL_LIGHT7 and ignores light ranges.
+ * @param[in] built whether the scene changed since the last call, so the lights are set up again.
+ */
+void operations_lights (const mat4 &view, const bool built)
+{
+  if (globalRenderer == RENDERER_SHADER)
     {
-      DEFAULT_GLOBAL_FOV = operations[i];
-      DEFAULT_GLOBAL_NEAR = operations[i + 1];
-      DEFAULT_GLOBAL_FAR = operations[i + 2];
-      cerr << "(FOV: " << DEFAULT_GLOBAL_FOV
-           << ", NEAR: " << DEFAULT_GLOBAL_NEAR
-           << ", FAR: " << DEFAULT_GLOBAL_FAR
-           << ")" << endl;
+      phong_set_lights (globalPhong, globalLights, view, globalClusters, globalWidth, globalHeight);
+      return;
     }
-  i += 3;
-
-  // default mode uses explorer camera
-  cartesian2Spherical (
-      DEFAULT_GLOBAL_EYE_X, DEFAULT_GLOBAL_EYE_Y, DEFAULT_GLOBAL_EYE_Z,
-      &DEFAULT_GLOBAL_RADIUS, &DEFAULT_GLOBAL_AZIMUTH, &DEFAULT_GLOBAL_ELEVATION);
-
-  unsigned int model_num = 0;
-  unsigned char nLights = 0;
 
   static const float amb[4] = {0, 0, 0, 1};
   static const float spec[4] = {1, 1, 1, 1};
   static const float diff[4] = {1, 1, 1, 1};
+  // lights are set up again when the scene is rebuilt
+  const bool isFirstTimeBeingExecuted = built;
+  if (isFirstTimeBeingExecuted && globalLights.size () > 8)
+    {
+      cerr << "[engine] the fixed-function renderer supports up to 8 lights, " << globalLights.size ()
+           << " were given (the shader renderer, -r shader, has no such limit)" << endl;
+      exit (EXIT_FAILURE);
+    }
 
-  for (; i < operations.size (); i++)
+  // positions are transformed by the modelview matrix when set
+  glLoadMatrixf (value_ptr (view));
+  for (unsigned int n = 0; n < globalLights.size (); ++n)
     {
-      assert(nLights < 8);
-      switch ((int) operations[i])
+      const struct light &light = globalLights[n];
+      if (isFirstTimeBeingExecuted)
         {
-          // transformations
+          glEnable (GL_LIGHT0 + n);
+          glLightfv (GL_LIGHT0 + n, GL_AMBIENT, amb);
+          glLightfv (GL_LIGHT0 + n, GL_DIFFUSE, diff);
+          glLightfv (GL_LIGHT0 + n, GL_SPECULAR, spec);
+          if (light.type == LIGHT_SPOT)
+            glLightf (GL_LIGHT0 + n, GL_SPOT_CUTOFF, light.cutoff);
+        }
+      glLightfv (GL_LIGHT0 + n, GL_POSITION, value_ptr (light.position));
+      if (light.type == LIGHT_SPOT)
+        glLightfv (GL_LIGHT0 + n, GL_SPOT_DIRECTION, value_ptr (light.direction));
+    }
+  if (isFirstTimeBeingExecuted)
+    for (unsigned int n = globalLights.size (); n < 8; ++n)
+      glDisable (GL_LIGHT0 + n);
+}
+
+/*!
+ * Draws the curves as unlit line strips with the Blinn-Phong program, which must be in use.
+ * Each curve is tesselated into a buffer the first time it is drawn, and again once the scene is rebuilt.
+ */
+void renderCurvesShaded (const vector<vector<vec3>> &curves, const vector<mat4> &curve_worlds, const mat4 &view,
+                         const bool built)
+{
+  const unsigned int TESSELATION = 100;
+  static vector<GLuint> vaos, vbos;
+  if (built)
+    {
+      glDeleteVertexArrays ((GLsizei) vaos.size (), vaos.data ());
+      glDeleteBuffers ((GLsizei) vbos.size (), vbos.data ());
+      globalGpuMemory.buffer_bytes -= vbos.size () * (TESSELATION + 1) * sizeof (vec3);
+      vaos.clear ();
+      vbos.clear ();
+    }
+  for (size_t c = vaos.size (); c < curves.size (); ++c)
+    {
+      vector<vec3> points;
+      curve_tesselate (Mcr, curves[c], TESSELATION, points);
+      GLuint vao, vbo;
+      glGenVertexArrays (1, &vao);
+      glBindVertexArray (vao);
+      glGenBuffers (1, &vbo);
+      glBindBuffer (GL_ARRAY_BUFFER, vbo);
+      glBufferData (GL_ARRAY_BUFFER, (GLsizeiptr) (points.size () * sizeof (vec3)), points.data (), GL_STATIC_DRAW);
+      globalGpuMemory.buffer_bytes += points.size () * sizeof (vec3);
+      glVertexAttribPointer (ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+      glEnableVertexAttribArray (ATTRIBUTE_POSITION);
+      vaos.push_back (vao);
+      vbos.push_back (vbo);
+    }
+
+  static const vec4 white (1, 1, 1, 1);
+  static const vec3 zero (0, 0, 0), one (1, 1, 1);
+  glUniform1i (globalPhong.quantized, GL_FALSE);
+  glUniform3fv (globalPhong.position_offset, 1, value_ptr (zero));
+  glUniform3fv (globalPhong.position_scale, 1, value_ptr (one));
+  glUniform1i (globalPhong.lighting, GL_FALSE);
+  glUniform1i (globalPhong.textured, GL_FALSE);
+  glUniform4fv (globalPhong.diffuse, 1, value_ptr (white));
+  for (size_t c = 0; c < curves.size (); ++c)
+    {
+      glUniformMatrix4fv (globalPhong.modelview, 1, GL_FALSE, value_ptr (view * curve_worlds[c]));
+      glBindVertexArray (vaos[c]);
+      glDrawArrays (GL_LINE_STRIP, 0, TESSELATION + 1);
+    }
+  glBindVertexArray (0);
+  glBindBuffer (GL_ARRAY_BUFFER, 0);
+  glUniform1i (globalPhong.lighting, GL_TRUE);
+}
+
+//! position, look at, up and projection, before the lights and groups
+const unsigned int OPERATIONS_CAMERA_FLOATS = 12;
+
+//! A group of the operations, with what its traversal starts from.
+struct operations_subtree {
+  unsigned int begin = 0;       // its BEGIN_GROUP
+  unsigned int end = 0;         // past its END_GROUP
+  unsigned int model_begin = 0; // models and curves before it
+  unsigned int model_end = 0;
+  unsigned int curve_begin = 0;
+  unsigned int curve_end = 0;
+  unsigned int depth = 0;       // 0 for the outermost groups
+  // updated every frame, when the traversal of the other groups reaches it
+  mat4 parent_world{1};
+  bool parent_animated = false;
+};
+
+//! every group of the scene, in the order they begin, found as it is built
+static vector<struct operations_subtree> globalGroups;
+//! groups traversed in parallel every frame, the others' traversal skipping them
+static vector<struct operations_subtree> globalSubtrees;
+//! models with an animated transform, refitted in the BVH every frame
+static vector<unsigned int> globalDynamicModels;
+
+//! One traversal of a range of the operations, from a given transform.
+struct operations_traversal {
+  const struct frame_request *request = nullptr;
+  struct frame_packet *packet = nullptr;
+  unsigned int model_num = 0; // models and curves before the range
+  unsigned int curve_num = 0;
+  mat4 world{1};              // transform the range starts from
+  bool animated = false;      // whether it is animated
+  double animation_time = 0;  // animations are interleaved with the traversal, their time is added up
+};
+
+/*!
+ * Applies the operations in [i, end) to the models and curves they reach, building
+ * them first when the scene is being built.
+ * @param[in] skip_subtrees whether to leave globalSubtrees out, only recording the transform each one starts from.
+ * @ingroup Operations
+ */
+void operations_traverse (struct operations_traversal &traversal, unsigned int i, const unsigned int end,
+                          const bool skip_subtrees)
+{
+  const vector<float> &operations = globalOperations;
+  const struct frame_request &request = *traversal.request;
+  const bool isFirstTimeBeingExecuted = globalSceneBuild.camera;
+  // models, curves and lights are built on the first pass and again after a reload
+  const bool hasPushedModels = !globalSceneBuild.scene;
+  const bool hasLoadedCurves = !globalSceneBuild.scene;
+  vector<vector<vec3>> &curves = globalCurves;
+  vector<mat4> &curve_worlds = traversal.packet->curve_worlds;
+  unsigned int &model_num = traversal.model_num;
+  unsigned int &curve_num = traversal.curve_num;
+  double &animation_time = traversal.animation_time;
+
+  // world transform of each open group, the top one being the current transform
+  static thread_local vector<mat4> transforms;
+  transforms.assign (1, traversal.world);
+  // whether each open group, or one of its ancestors, has an animated transform
+  static thread_local vector<bool> animated;
+  animated.assign (1, traversal.animated);
+  // groups of the scene being built, still open
+  static vector<unsigned int> open;
+
+  // next subtree to skip
+  unsigned int subtree = 0;
+  for (; i < end; i++)
+    {
+      switch ((int) operations[i])
+        {
+          // transformations
           case ROTATE:
             {
               const float rotation_angle = operations[i + 1];
               const vec3 axis_of_rotation (operations[i + 2],
                                            operations[i + 3],
                                            operations[i + 4]);
-              glRotatef (operations[i + 1],
-                         operations[i + 2],
-                         operations[i + 3],
-                         operations[i + 4]);
+              transforms.back () = glm::rotate (transforms.back (), glm::radians (rotation_angle), axis_of_rotation);
               if (isFirstTimeBeingExecuted)
                 cerr << "ROTATE (" << "rotation_angle:" << rotation_angle
                      << ", axis of rotatation: " << to_string (axis_of_rotation) << ")" << endl;
@@ -1200,7 +2000,11 @@ void operations_render (vector<float> &operations)
                   operations[i + 3],
                   operations[i + 4]
               };
-              advance_in_rotation (rotation_time, axis_of_rotation);
+              const double animation_begin = profiler_now ();
+              advance_in_rotation ((float) sim_clock_phase (request.clock, rotation_time), axis_of_rotation,
+                                   transforms.back ());
+              animation_time += profiler_now () - animation_begin;
+              animated.back () = true;
               i += 4; //time, axis_of_rotation
               if (isFirstTimeBeingExecuted)
                 cerr << "EXTENDED_ROTATE (rotation_time: " << rotation_time
@@ -1212,9 +2016,7 @@ void operations_render (vector<float> &operations)
               const vec3 translation (operations[i + 1],
                                       operations[i + 2],
                                       operations[i + 3]);
-              glTranslatef (translation[0],
-                            translation[1],
-                            translation[2]);
+              transforms.back () = glm::translate (transforms.back (), translation);
               if (isFirstTimeBeingExecuted)
                 cerr << "TRANSLATE (" << to_string (translation) << ")" << endl;
               i += 3;
@@ -1225,21 +2027,25 @@ void operations_render (vector<float> &operations)
               const int number_of_points = (int) operations[i + 3];
               if (!hasLoadedCurves)
                 {
-                  vector<vec3> new_curve (number_of_points);
+                  vector<vec3> &new_curve = curves.emplace_back (number_of_points);
                   for (int j = 0; j < number_of_points; ++j)
                     {
                       const int idx = 3 * j;
-                      new_curve.at (j)[0] = operations[i + 4 + idx];
-                      new_curve.at (j)[1] = operations[i + 4 + idx + 1];
-                      new_curve.at (j)[2] = operations[i + 4 + idx + 2];
+                      new_curve[j][0] = operations[i + 4 + idx];
+                      new_curve[j][1] = operations[i + 4 + idx + 1];
+                      new_curve[j][2] = operations[i + 4 + idx + 2];
                     }
-                  curves.push_back (new_curve);
+                  curve_worlds.emplace_back (1);
                 }
-              auto curve = curves.back ();
-              renderCurve (Mcr, curve);
+              curve_worlds[curve_num] = transforms.back ();
               const float translation_time = operations[i + 1];
               const bool align = (bool) operations[i + 2];
-              advance_in_curve (translation_time, align, Mcr, curves.back ());
+              const double animation_begin = profiler_now ();
+              advance_in_curve ((float) sim_clock_phase (request.clock, translation_time), align, Mcr, curves[curve_num],
+                                transforms.back ());
+              animation_time += profiler_now () - animation_begin;
+              animated.back () = true;
+              ++curve_num;
               if (isFirstTimeBeingExecuted)
                 cerr << "EXTENDED_TRANSLATE ("
                      << "translation_time: " << translation_time
@@ -1254,9 +2060,7 @@ void operations_render (vector<float> &operations)
               const vec3 scale (operations[i + 1],
                                 operations[i + 2],
                                 operations[i + 3]);
-              glScalef (scale[0],
-                        scale[1],
-                        scale[2]);
+              transforms.back () = glm::scale (transforms.back (), scale);
               if (isFirstTimeBeingExecuted)
                 cerr << "SCALE (" << to_string (scale) << ")" << endl;
               i += 3;
@@ -1265,18 +2069,46 @@ void operations_render (vector<float> &operations)
           // grouping
           case BEGIN_GROUP:
             {
+              if (skip_subtrees && subtree < globalSubtrees.size () && globalSubtrees[subtree].begin == i)
+                {
+                  // traversed on its own, from the transform it is left with here
+                  struct operations_subtree &skipped = globalSubtrees[subtree++];
+                  skipped.parent_world = transforms.back ();
+                  skipped.parent_animated = animated.back ();
+                  model_num = skipped.model_end;
+                  curve_num = skipped.curve_end;
+                  i = skipped.end - 1;
+                  continue;
+                }
               if (isFirstTimeBeingExecuted)
                 cerr << "BEGIN_GROUP" << endl;
-              //glPushAttrib (GL_ALL_ATTRIB_BITS);
-              glPushMatrix ();
+              if (!hasPushedModels)
+                {
+                  open.push_back ((unsigned int) globalGroups.size ());
+                  globalGroups.push_back ({i, 0, model_num, 0, curve_num, 0, (unsigned int) transforms.size () - 1});
+                }
+              transforms.push_back (transforms.back ());
+              animated.push_back (animated.back ());
             }
           continue;
           case END_GROUP:
             {
               if (isFirstTimeBeingExecuted)
                 cerr << "END_GROUP" << endl;
-              glPopMatrix ();
-              //glPopAttrib ();
+              // one with no group open, which only malformed operations have, closes nothing, so the
+              // models after it are still drawn with the transform of the root
+              if (transforms.size () == 1)
+                continue;
+              if (!hasPushedModels && !open.empty ())
+                {
+                  struct operations_subtree &group = globalGroups[open.back ()];
+                  open.pop_back ();
+                  group.end = i + 1;
+                  group.model_end = model_num;
+                  group.curve_end = curve_num;
+                }
+              transforms.pop_back ();
+              animated.pop_back ();
             }
           continue;
           // texture
@@ -1285,12 +2117,12 @@ void operations_render (vector<float> &operations)
               const int stringSize = (int) operations[i + 1];
               if (!hasPushedModels)
                 {
-                  char textureFilePath[stringSize + 1];
+                  char *const textureFilePath = arena_array<char> (traversal.packet->arena, stringSize + 1);
                   int j;
                   for (j = 0; j < stringSize; ++j)
                     textureFilePath[j] = (char) operations[i + 2 + j];
                   textureFilePath[j] = '\0';
-                  associate_a_texture_to_model (globalModels.back (), textureFilePath);
+                  scene_pool_texture (globalScenePool, globalModels.back (), textureFilePath);
                   if (isFirstTimeBeingExecuted)
                     cerr << "TEXTURE (" << textureFilePath << ")" << endl;
                 }
@@ -1366,13 +2198,13 @@ void operations_render (vector<float> &operations)
               int stringSize = (int) operations[i + 1];
               if (!hasPushedModels)
                 {
-                  char modelName[stringSize + 1];
+                  char *const modelName = arena_array<char> (traversal.packet->arena, stringSize + 1);
                   int j;
                   for (j = 0; j < stringSize; ++j)
                     modelName[j] = (char) operations[i + 2 + j];
                   modelName[j] = '\0';
 
-                  globalModels.push_back (allocModel (modelName));
+                  globalModels.push_back (scene_pool_model (globalScenePool, modelName));
                   if (isFirstTimeBeingExecuted)
                     cerr << "BEGIN_MODEL (" << modelName << ")" << endl;
                 }
@@ -1384,87 +2216,361 @@ void operations_render (vector<float> &operations)
             {
               if (isFirstTimeBeingExecuted)
                 cerr << "END_MODEL" << endl;
-              renderModel (globalModels[model_num - 1]);
+              struct model &model = globalModels[model_num - 1];
+              model.world = transforms.back ();
+              if (!hasPushedModels)
+                {
+                  model.dynamic = animated.back ();
+                  model.world_box = aabb_transform (model.bounds, model.world);
+                }
+              // the BVH is refitted once every subtree is done, as ancestors are shared
+              else if (model.dynamic)
+                model.world_box = aabb_transform (model.bounds, model.world);
             }
           continue;
           // light sources
           case POINT:
             {
-              const vec4 pos = {operations[i + 1],
-                                operations[i + 2],
-                                operations[i + 3],
-                                1.0};
-              if (isFirstTimeBeingExecuted)
+              if (!hasPushedModels)
                 {
-                  glEnable (GL_LIGHT0 + nLights);
-                  glLightfv (GL_LIGHT0 + nLights, GL_AMBIENT, amb);
-                  glLightfv (GL_LIGHT0 + nLights, GL_DIFFUSE, diff);
-                  glLightfv (GL_LIGHT0 + nLights, GL_SPECULAR, spec);
-                  cerr << "POINT (" << to_string (pos) << ")" << endl;
+                  struct light light;
+                  light.type = LIGHT_POINT;
+                  light.position = {operations[i + 1], operations[i + 2], operations[i + 3], 1.0};
+                  light.range = operations[i + 4];
+                  globalLights.push_back (light);
+                  cerr << "POINT (" << to_string (light.position) << ", range: " << light.range << ")" << endl;
                 }
-              glLightfv (GL_LIGHT0 + nLights, GL_POSITION, value_ptr (pos));
-              ++nLights;
-              i += 3;
+              i += 4;
             }
           continue;
           case DIRECTIONAL:
             {
-              const vec4 dir = {operations[i + 1],
-                                operations[i + 2],
-                                operations[i + 3],
-                                0.0};
-              if (isFirstTimeBeingExecuted)
+              if (!hasPushedModels)
                 {
-                  glEnable (GL_LIGHT0 + nLights);
-                  glLightfv (GL_LIGHT0 + nLights, GL_AMBIENT, amb);
-                  glLightfv (GL_LIGHT0 + nLights, GL_DIFFUSE, diff);
-                  glLightfv (GL_LIGHT0 + nLights, GL_SPECULAR, spec);
-                  cerr << "DIRECTIONAL (" << to_string (dir) << ")" << endl;
+                  struct light light;
+                  light.type = LIGHT_DIRECTIONAL;
+                  light.position = {operations[i + 1], operations[i + 2], operations[i + 3], 0.0};
+                  globalLights.push_back (light);
+                  cerr << "DIRECTIONAL (" << to_string (light.position) << ")" << endl;
                 }
-
-              glLightfv (GL_LIGHT0 + nLights, GL_POSITION, value_ptr (dir));
-              ++nLights;
               i += 3;
             }
           continue;
           case SPOTLIGHT:
             {
-              const vec4 pos = {operations[i + 1],
-                                operations[i + 2],
-                                operations[i + 3],
-                                1.0};
-              const vec4 dir = {operations[i + 4],
-                                operations[i + 5],
-                                operations[i + 6],
-                                1.0};
-              const float cutoff = operations[i + 7];
-              if (isFirstTimeBeingExecuted)
+              if (!hasPushedModels)
                 {
-                  glEnable (GL_LIGHT0 + nLights);
-
-                  glLightfv (GL_LIGHT0 + nLights, GL_AMBIENT, amb);
-                  glLightfv (GL_LIGHT0 + nLights, GL_DIFFUSE, diff);
-                  glLightfv (GL_LIGHT0 + nLights, GL_SPECULAR, spec);
-                  glLightf (GL_LIGHT0 + nLights, GL_SPOT_CUTOFF, cutoff);
-
+                  struct light light;
+                  light.type = LIGHT_SPOT;
+                  light.position = {operations[i + 1], operations[i + 2], operations[i + 3], 1.0};
+                  light.direction = {operations[i + 4], operations[i + 5], operations[i + 6]};
+                  light.cutoff = operations[i + 7];
+                  light.range = operations[i + 8];
+                  globalLights.push_back (light);
                   cerr << "SPOTLIGHT:"
-                          "\n\t(pos: " << to_string (pos) << ")"
-                                                             "\n\t(dir: " << to_string (dir) << ")"
-                                                                                                "\n\t(cutoff: "
-                       << cutoff
-                       << ")" << endl;
+                          "\n\t(pos: " << to_string (light.position) << ")"
+                          "\n\t(dir: " << to_string (light.direction) << ")"
+                          "\n\t(cutoff: " << light.cutoff << ")"
+                          "\n\t(range: " << light.range << ")" << endl;
                 }
-              glLightfv (GL_LIGHT0 + nLights, GL_POSITION, value_ptr (pos));
-              glLightfv (GL_LIGHT0 + nLights, GL_SPOT_DIRECTION, value_ptr (dir));
-              ++nLights;
-              i += 7;
+              i += 8;
               continue;
             }
         }
     }
-  hasPushedModels = true;
-  hasLoadedCurves = true;
-  isFirstTimeBeingExecuted = false;
+
+}
+
+/*!
+ * Chooses the groups to traverse in parallel: the outermost ones that are numerous
+ * enough to be shared out among the threads, else those of the most numerous level.
+ * Without workers everything is traversed at once.
+ */
+void operations_split_subtrees (const unsigned int threads)
+{
+  const unsigned int SUBTREES_PER_THREAD = 8;
+  globalSubtrees.clear ();
+  if (threads < 2 || globalGroups.empty ())
+    return;
+
+  vector<unsigned int> per_depth;
+  for (const auto &group: globalGroups)
+    {
+      if (group.depth >= per_depth.size ())
+        per_depth.resize (group.depth + 1, 0);
+      ++per_depth[group.depth];
+    }
+  unsigned int depth = 0;
+  while (depth < per_depth.size () && per_depth[depth] < SUBTREES_PER_THREAD * threads)
+    ++depth;
+  if (depth == per_depth.size ())
+    depth = (unsigned int) (std::max_element (per_depth.begin (), per_depth.end ()) - per_depth.begin ());
+  for (const auto &group: globalGroups)
+    if (group.depth == depth)
+      globalSubtrees.push_back (group);
+}
+
+//! What the jobs of a frame's update share, the arrays in the packet's arena.
+struct operations_frame {
+  const struct frame_request *request;
+  struct frame_packet *packet;
+  std::atomic<double> animation_time{0};
+  struct draw_packet *keyed; // by model, of the visible ones, compacted into the queue once all are keyed
+};
+
+//! Traverses the operations but for the subtrees, recording the transform each one starts from.
+void operations_job_traverse (void *const data, unsigned int, unsigned int)
+{
+  auto &frame = *(struct operations_frame *) data;
+  struct operations_traversal traversal;
+  traversal.request = frame.request;
+  traversal.packet = frame.packet;
+  operations_traverse (traversal, OPERATIONS_CAMERA_FLOATS, (unsigned int) globalOperations.size (), true);
+  frame.animation_time += traversal.animation_time;
+}
+
+void operations_job_traverse_subtrees (void *const data, const unsigned int begin, const unsigned int end)
+{
+  auto &frame = *(struct operations_frame *) data;
+  for (unsigned int s = begin; s < end; ++s)
+    {
+      const struct operations_subtree &subtree = globalSubtrees[s];
+      struct operations_traversal traversal;
+      traversal.request = frame.request;
+      traversal.packet = frame.packet;
+      traversal.model_num = subtree.model_begin;
+      traversal.curve_num = subtree.curve_begin;
+      traversal.world = subtree.parent_world;
+      traversal.animated = subtree.parent_animated;
+      operations_traverse (traversal, subtree.begin, subtree.end, false);
+      frame.animation_time += traversal.animation_time;
+    }
+}
+
+void operations_job_refit (void *, unsigned int, unsigned int)
+{
+  for (const unsigned int m: globalDynamicModels)
+    bvh_move (globalBVH, m, globalModels[m].world_box);
+}
+
+void operations_job_cull (void *const data, unsigned int, unsigned int)
+{
+  auto &frame = *(struct operations_frame *) data;
+  operations_cull (frustum_from_matrix (frame.request->projection * frame.request->view), *frame.packet);
+}
+
+void operations_job_key (void *const data, const unsigned int begin, const unsigned int end)
+{
+  auto &frame = *(struct operations_frame *) data;
+  const struct frame_request &request = *frame.request;
+  const mat4 &view = request.view;
+  const unsigned int program = globalRenderer == RENDERER_SHADER ? globalPhong.program : 0;
+  for (unsigned int m = begin; m < end; ++m)
+    {
+      const struct model &model = globalModels[m];
+      if (!model.visible)
+        continue;
+      frame.packet->worlds[m] = model.world;
+      const vec3 center = (model.world_box.min + model.world_box.max) * 0.5f;
+      const float depth = -(view * vec4 (center, 1)).z;
+      const unsigned int pass = model.material.diffuse.w < 1 ? PASS_TRANSPARENT : PASS_OPAQUE;
+      frame.keyed[m] = {render_key (pass, program, model.tbo, model.material_id,
+                                    (depth - request.near) / (request.far - request.near)), m};
+    }
+}
+
+void operations_job_queue (void *const data, unsigned int, unsigned int)
+{
+  auto &frame = *(struct operations_frame *) data;
+  vector<struct draw_packet> &queue = frame.packet->queue;
+  queue.clear ();
+  for (unsigned int m = 0; m < globalModels.size (); ++m)
+    if (globalModels[m].visible)
+      queue.push_back (frame.keyed[m]);
+  render_queue_sort (queue);
+}
+
+/*!
+ * Simulates a frame: animates the operations at the clock of the request, refits the
+ * BVH, culls against its camera and sorts the visible models into the packet's queue.
+ * Runs on the simulation thread, but for frames that build the scene, which upload it
+ * and so stay on the GL thread. Issues no GL calls otherwise.
+ *
+ * The phases are a graph of jobs: the traversal of the groups outside globalSubtrees,
+ * then that of the subtrees in parallel, the BVH refit, culling, the sort keys of
+ * the visible models in parallel and their sort. A scene being built is traversed
+ * at once beforehand, as it uploads to GL.
+ * @ingroup Operations
+ */
+void operations_update (const struct frame_request &request, struct frame_packet &packet)
+{
+  const vector<float> &operations = globalOperations;
+  unsigned int i = 0;
+  const bool isFirstTimeBeingExecuted = globalSceneBuild.camera;
+  // models, curves and lights are built on the first pass and again after a reload
+  const bool hasPushedModels = !globalSceneBuild.scene;
+
+  vector<vector<vec3>> &curves = globalCurves;
+  // transform in place when each curve is reached, the curve is drawn with it
+  vector<mat4> &curve_worlds = packet.curve_worlds;
+  curve_worlds.resize (curves.size ());
+  if (!hasPushedModels)
+    {
+      curves.clear ();
+      curve_worlds.clear ();
+      globalLights.clear ();
+      globalGroups.clear ();
+      globalSubtrees.clear ();
+    }
+
+  if (isFirstTimeBeingExecuted)
+    {
+      DEFAULT_GLOBAL_EYE_X = operations[i];
+      DEFAULT_GLOBAL_EYE_Y = operations[i + 1];
+      DEFAULT_GLOBAL_EYE_Z = operations[i + 2];
+    }
+  i += 3;
+
+  if (isFirstTimeBeingExecuted)
+    {
+      DEFAULT_GLOBAL_CENTER_X = operations[i];
+      DEFAULT_GLOBAL_CENTER_Y = operations[i + 1];
+      DEFAULT_GLOBAL_CENTER_Z = operations[i + 2];
+    }
+  i += 3;
+
+  if (isFirstTimeBeingExecuted)
+    {
+      DEFAULT_GLOBAL_UP_X = operations[i];
+      DEFAULT_GLOBAL_UP_Y = operations[i + 1];
+      DEFAULT_GLOBAL_UP_Z = operations[i + 2];
+    }
+  i += 3;
+
+  if (isFirstTimeBeingExecuted)
+    {
+      DEFAULT_GLOBAL_FOV = operations[i];
+      DEFAULT_GLOBAL_NEAR = operations[i + 1];
+      DEFAULT_GLOBAL_FAR = operations[i + 2];
+      cerr << "(FOV: " << DEFAULT_GLOBAL_FOV
+           << ", NEAR: " << DEFAULT_GLOBAL_NEAR
+           << ", FAR: " << DEFAULT_GLOBAL_FAR
+           << ")" << endl;
+    }
+  i += 3;
+
+  if (isFirstTimeBeingExecuted)
+    // default mode uses explorer camera
+    cartesian2Spherical (
+        DEFAULT_GLOBAL_EYE_X, DEFAULT_GLOBAL_EYE_Y, DEFAULT_GLOBAL_EYE_Z,
+        &DEFAULT_GLOBAL_RADIUS, &DEFAULT_GLOBAL_AZIMUTH, &DEFAULT_GLOBAL_ELEVATION);
+
+  struct operations_frame frame;
+  frame.request = &request;
+  frame.packet = &packet;
+  if (!hasPushedModels)
+    {
+      profiler_scope scope ("build");
+      struct operations_traversal traversal;
+      traversal.request = &request;
+      traversal.packet = &packet;
+      operations_traverse (traversal, i, (unsigned int) operations.size (), false);
+      frame.animation_time = traversal.animation_time;
+
+      vector<struct aabb> boxes;
+      boxes.reserve (globalModels.size ());
+      globalDynamicModels.clear ();
+      for (unsigned int m = 0; m < globalModels.size (); ++m)
+        {
+          boxes.push_back (globalModels[m].world_box);
+          if (globalModels[m].dynamic)
+            globalDynamicModels.push_back (m);
+        }
+      bvh_build (globalBVH, boxes);
+      operations_assign_material_ids ();
+      operations_split_subtrees ((unsigned int) globalJobs.queues.size ());
+      globalSceneAnimated = !curves.empty () || !globalDynamicModels.empty ();
+      if (!isFirstTimeBeingExecuted)
+        cerr << "[reload] " << globalModels.size () << " models, " << globalScenePool.reused
+             << " objects reused and " << globalScenePool.loaded << " loaded in "
+             << (profiler_now () - globalScenePool.begin) / 1000 << " ms" << endl;
+      scene_pool_release (globalScenePool);
+      asset_io_drop (globalAssetIO);
+    }
+  packet.worlds.resize (globalModels.size ());
+  frame.keyed = arena_array<struct draw_packet> (packet.arena, globalModels.size ());
+
+  const double jobs_begin = profiler_now ();
+  struct job_graph graph;
+  graph.arena = &packet.arena;
+  // the scene just built was traversed already
+  const unsigned int traversals = hasPushedModels ? 1 : 0;
+  struct job_task *const traverse = job_graph_add (graph, "traversal", operations_job_traverse, &frame, traversals);
+  struct job_task *const subtrees = job_graph_add (graph, "traversal", operations_job_traverse_subtrees, &frame,
+                                                   traversals * (unsigned int) globalSubtrees.size ());
+  struct job_task *const refit = job_graph_add (graph, "refit", operations_job_refit, &frame, traversals);
+  struct job_task *const cull = job_graph_add (graph, "culling", operations_job_cull, &frame, 1);
+  struct job_task *const key = job_graph_add (graph, "keys", operations_job_key, &frame,
+                                              (unsigned int) globalModels.size (), 256);
+  struct job_task *const queue = job_graph_add (graph, "queue", operations_job_queue, &frame, 1);
+  job_graph_depend (subtrees, traverse);
+  job_graph_depend (refit, subtrees);
+  job_graph_depend (cull, refit);
+  job_graph_depend (key, cull);
+  job_graph_depend (queue, key);
+  job_graph_run (globalJobs, graph);
+  profiler_add ("animation", jobs_begin, frame.animation_time);
+
+  if (!hasPushedModels)
+    ++globalSceneGeneration;
+  packet.scene = globalSceneGeneration;
+  globalSceneBuild = {false, false};
+}
+
+/*!
+ * Draws a simulated frame, as seen from the camera it was simulated with.
+ * Reads nothing the simulation writes but the packet, so the next frame may be simulated meanwhile.
+ * @ingroup Operations
+ */
+void operations_draw (const struct frame_packet &packet)
+{
+  const mat4 &view = packet.request.view;
+  // lights and curve buffers are set up again for each scene built
+  static uint64_t drawn_scene = 0;
+  const bool built = packet.scene != drawn_scene;
+  drawn_scene = packet.scene;
+
+  if (globalRenderer == RENDERER_SHADER)
+    {
+      glUseProgram (globalPhong.program);
+      glUniformMatrix4fv (globalPhong.projection, 1, GL_FALSE, value_ptr (packet.request.projection));
+    }
+  operations_lights (view, built);
+
+  {
+    profiler_scope scope ("curves", true);
+    if (globalRenderer == RENDERER_SHADER)
+      renderCurvesShaded (globalCurves, packet.curve_worlds, view, built);
+    else
+      for (unsigned int c = 0; c < globalCurves.size (); ++c)
+        {
+          glLoadMatrixf (value_ptr (view * packet.curve_worlds[c]));
+          renderCurve (Mcr, globalCurves[c]);
+        }
+  }
+
+  {
+    profiler_scope scope ("draws", true);
+    operations_submit (packet);
+  }
+  if (globalRenderer == RENDERER_SHADER)
+    glUseProgram (0);
+  else
+    glLoadMatrixf (value_ptr (view));
+
+  globalDrawnFrame = packet.request.clock.frame;
+  globalDrawnModels = packet.visible;
+  globalCulledModels = packet.culled;
 }
 
 void draw_axes ()
@@ -1512,19 +2618,263 @@ void renderGreenPlane ()
   glColor3f (1, 1, 1);
 }
 
-int timebase = 0, frame = 0;
-void renderScene ()
+/*! @addtogroup framePipeline
+ * @{*/
+
+//! What the simulation of the next frame starts from: the clock and the camera as they are now.
+struct frame_request engine_frame_request ()
+{
+  struct frame_request request;
+  request.frame = ++globalFrame;
+  request.clock = globalClock;
+  request.view = globalView;
+  request.projection = globalProjection;
+  request.near = globalNear;
+  request.far = globalFar;
+  return request;
+}
+
+/*!
+ * Gets the packet of the frame to draw.
+ *
+ * While frames follow each other, animations running or the camera moving, the packet
+ * was simulated on the simulation thread as the previous frame was drawn, and the
+ * next one is posted before this one is drawn: the clock and camera drawn are a frame
+ * old, but simulation and submission overlap. Other frames are simulated inline, on
+ * demand, so input shows up at once: frames drawn after a wait, with -S, and the ones
+ * building the scene, as its buffers and textures are uploaded then.
+ */
+const struct frame_packet &engine_simulate ()
+{
+  const bool ahead = globalSimulatedAhead && globalScheduler.continuous
+                     && !globalSceneBuild.scene && !globalSceneBuild.camera;
+  if (!ahead)
+    {
+      sim_clock_tick (globalClock, sim_clock_real_seconds ());
+      frame_pipeline_run (globalPipeline, engine_frame_request ());
+    }
+  const struct frame_packet &packet = frame_pipeline_acquire (globalPipeline, globalFrame);
+
+  globalSimulatedAhead = globalPipelined && engine_animating ();
+  if (globalSimulatedAhead)
+    {
+      sim_clock_tick (globalClock, sim_clock_real_seconds ());
+      frame_pipeline_post (globalPipeline, engine_frame_request ());
+    }
+  return packet;
+}
+
+//! Waits for the simulation thread and the job workers to finish, registered with atexit as GLUT may exit from its main loop.
+void engine_pipeline_at_exit ()
 {
-  float fps;
-  int time;
-  char s[64];
+  frame_pipeline_stop (globalPipeline);
+  job_system_stop (globalJobs);
+  asset_io_stop (globalAssetIO);
+}
+
+//! @} end of group framePipeline
+
+//! Draws the scene, as seen by the camera of the active profile, to the current framebuffer.
+void engine_frame ()
+{
+  globalFrameBegin = sim_clock_real_seconds ();
+  profiler_frame_begin ();
+  profiler_scope scope ("frame", true);
+
+  profile[globalProfile].camera ();
+  const struct frame_packet &packet = engine_simulate ();
 
   // clear buffers
   glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  // helps in avoiding rounding mistakes, discards old matrix, read more
-  glLoadIdentity ();
+  if (globalRenderer == RENDERER_FIXED)
+    glLoadMatrixf (value_ptr (packet.request.view));
+
+  // render models, with the chunks of those streaming in uploaded so far
+  model_streams_upload ();
+  operations_draw (packet);
+}
+
+/*!
+ * Gathers the counters of the frame just drawn, appending them to the statistics
+ * file and drawing them over it when asked for.
+ *
+ * The frame time is that of the frame itself, from its beginning to the swap, so a
+ * static scene drawn on demand is not charged the time it sat idle. The frame rate
+ * is taken apart, from the interval between frames drawn back to back only.
+ */
+void engine_frame_stats (const int width, const int height)
+{
+  static double last = -1;
+  const double now = sim_clock_real_seconds ();
+  // the previous frame had this one follow without waiting for input
+  const bool continuous = globalScheduler.continuous || globalScheduler.pacing == PACING_UNCAPPED;
+
+  struct frame_counters counters;
+  counters.frame = globalDrawnFrame;
+  counters.frame_ms = (now - globalFrameBegin) * 1000;
+  counters.interval_ms = last >= 0 && continuous ? (now - last) * 1000 : 0;
+  counters.draw_calls = globalRenderStats.draw_calls;
+  counters.triangles = globalRenderStats.triangles;
+  counters.state_changes = globalRenderStats.texture_binds + globalRenderStats.material_changes;
+  counters.visible = globalDrawnModels;
+  counters.culled = globalCulledModels;
+  counters.texture_bytes = globalGpuMemory.texture_bytes;
+  counters.buffer_bytes = globalGpuMemory.buffer_bytes;
+  frame_history_push (globalFrameHistory, counters.frame_ms);
+  if (counters.interval_ms > 0)
+    frame_history_push (globalIntervalHistory, counters.interval_ms);
+  last = now;
+
+  if (globalStatsFile)
+    stats_csv_row (globalStatsFile, counters);
+  if (!globalShowOverlay)
+    return;
+
+  const struct frame_time_summary times = frame_history_summary (globalFrameHistory);
+  const struct frame_time_summary intervals = frame_history_summary (globalIntervalHistory);
+  char rate[32] = "IDLE";
+  if (continuous && intervals.avg > 0)
+    snprintf (rate, sizeof (rate), "%.1f FPS", 1000 / intervals.avg);
+  char line[4][128];
+  snprintf (line[0], sizeof (line[0]), "FRAME MS  MIN %.2f  AVG %.2f  P95 %.2f  P99 %.2f  (%s)",
+            times.min, times.avg, times.p95, times.p99, rate);
+  snprintf (line[1], sizeof (line[1]), "DRAWS %u  TRIANGLES %u  STATE CHANGES %u",
+            counters.draw_calls, counters.triangles, counters.state_changes);
+  snprintf (line[2], sizeof (line[2]), "MEMORY  TEXTURES %.1f MB  BUFFERS %.1f MB",
+            (double) counters.texture_bytes / (1 << 20), (double) counters.buffer_bytes / (1 << 20));
+  snprintf (line[3], sizeof (line[3]), "MODELS  VISIBLE %u  CULLED %u", counters.visible, counters.culled);
+  overlay_draw (globalOverlay, {line[0], line[1], line[2], line[3]}, width, height);
+}
+
+//! the scene being drawn, watched with its assets for hot reloads
+static string globalScenePath;
+static struct file_watch globalFileWatch;
+
+/*! @addtogroup hotReload
+ * @{*/
+
+//! Watches the scene and every model and texture it draws, those already watched being skipped.
+void engine_watch_scene ()
+{
+  file_watch_add (globalFileWatch, globalScenePath);
+  for (const auto &model: globalModels)
+    {
+      file_watch_add (globalFileWatch, model.file);
+      if (!model.texture_file.empty ())
+        file_watch_add (globalFileWatch, model.texture_file);
+    }
+}
+
+/*!
+ * Has the next frame rebuild the scene, reading again only the changed files: the
+ * scene itself, when it is among them, and the models and textures among them.
+ * Transforms need nothing more as they are applied from the operations every frame.
+ * The camera is left where the user put it.
+ * @return whether the scene is rebuilt.
+ */
+bool engine_reload (const set<string> &changed)
+{
+  const bool scene_changed = changed.count (globalScenePath);
+  // a scene saved halfway through an edit waits for the next save, without stopping the simulation
+  if (scene_changed && !operations_xml_well_formed (globalScenePath))
+    return false;
+
+  // the models and operations are the simulation's until it is done
+  frame_pipeline_sync (globalPipeline);
+  for (const auto &path: changed)
+    cerr << "[reload] " << path << " changed" << endl;
+  vector<string> files (changed.begin (), changed.end ());
+  vector<float> operations;
+  // a scene in error, a missing model say, is told and the one drawn is kept
+  if (scene_changed && !operations_read_xml (globalScenePath, operations, &globalJobs, &files))
+    {
+      cerr << "[reload] '" << globalScenePath << "' has errors, the previous scene is kept" << endl;
+      return false;
+    }
+  globalScenePool.begin = profiler_now ();
+  scene_pool_fill (globalScenePool, globalModels, changed);
+  model_streams_drop ();
+  if (scene_changed)
+    globalOperations.swap (operations);
+  // the pool has the rest
+  std::erase_if (files, [] (const string &file)
+  {
+    if (file == globalScenePath)
+      return true;
+    const auto buffers = globalScenePool.buffers.find (file);
+    const auto textures = globalScenePool.textures.find (file);
+    return (buffers != globalScenePool.buffers.end () && !buffers->second.empty ())
+           || (textures != globalScenePool.textures.end () && !textures->second.empty ());
+  });
+  asset_io_read_ahead (globalAssetIO, files);
+  globalSceneBuild.scene = true;
+  return true;
+}
+
+//! milliseconds between two looks for changed files
+const unsigned int WATCH_POLL_MS = 200;
+
+//! Reloads the scene when it or its assets changed on disk, polling as frames are only drawn on demand.
+void engineWatchTimer (int)
+{
+  set<string> changed;
+  file_watch_poll (globalFileWatch, changed);
+  if (!changed.empty () && engine_reload (changed))
+    engine_request_frame ();
+  glutTimerFunc (WATCH_POLL_MS, engineWatchTimer, 0);
+}
+
+//! @} end of group hotReload
+
+/*! @addtogroup frameScheduler
+ * @{*/
+
+//! Whether the next frame differs from the last even without input: animations run, the camera keeps moving or models stream in.
+bool engine_animating ()
+{
+  return (globalSceneAnimated && !globalClock.paused) || (globalProfile == FPS && fpsMoving ())
+         || !globalModelStreams.empty ();
+}
+
+/*!
+ * Idle callback while frames are pending: has the next one drawn when it is due,
+ * and unregisters itself once none is, so a static scene leaves the CPU idle
+ * until the next input.
+ */
+void engineIdle ()
+{
+  if (!frame_scheduler_pending (globalScheduler))
+    {
+      glutIdleFunc (nullptr);
+      return;
+    }
+  frame_scheduler_wait (globalScheduler);
+  glutPostRedisplay ();
+}
 
+//! Sets how many display refreshes a buffer swap waits for, where the GLX extensions allow it.
+void engine_swap_interval (const int interval)
+{
+#ifndef __APPLE__
+  typedef int (*swap_interval_mesa) (unsigned int);
+  typedef int (*swap_interval_sgi) (int);
+  const auto mesa = (swap_interval_mesa) glutGetProcAddress ("glXSwapIntervalMESA");
+  const auto sgi = (swap_interval_sgi) glutGetProcAddress ("glXSwapIntervalSGI");
+  if (mesa)
+    mesa (interval);
+  else if (sgi && interval > 0)
+    sgi (interval);
+  else
+    cerr << "[engine] cannot set the swap interval, the driver's default is kept" << endl;
+#endif
+}
+
+//! @} end of group frameScheduler
+
+void renderScene ()
+{
+  const bool reloading = globalSceneBuild.scene;
   if (globalProfileHasChanged)
     {
       loadProfile (profile[globalProfile]);
@@ -1532,102 +2882,341 @@ void renderScene ()
         profile[globalProfile].init ();
       globalProfileHasChanged = false;
     }
-  profile[globalProfile].camera ();
-
-  // render models
-  operations_render (globalOperations);
-
-  // calculate and display frame rate
-  ++frame;
-  time = glutGet (GLUT_ELAPSED_TIME);
-  if (time - timebase > 1000)
-    {
-      fps = frame * 1000.0 / (time - timebase);
-      timebase = time;
-      frame = 0;
-      sprintf (s, "FPS: %f6.2", fps);
-      glutSetWindowTitle (s);
-    }
+  engine_frame ();
+  // the rebuilt scene may draw new files
+  if (reloading)
+    engine_watch_scene ();
+  engine_frame_stats (glutGet (GLUT_WINDOW_WIDTH), glutGet (GLUT_WINDOW_HEIGHT));
 
   // End of frame
-  glutSwapBuffers ();
+  {
+    profiler_scope scope ("swap");
+    glutSwapBuffers ();
+  }
+  frame_scheduler_done (globalScheduler, engine_animating ());
 }
 
 void xml_load_and_set_env (const string &filename)
 {
-  operations_load_xml (filename, globalOperations);
-  operations_render (globalOperations);
+  globalScenePath = filename;
+  // the workers read large files too
+  job_system_start (globalJobs, globalJobWorkers);
+  globalAssetIO.skip = engine_read_ahead_skip;
+  asset_io_start (globalAssetIO, ASSET_IO_THREADS);
+  atexit (engine_pipeline_at_exit);
+  vector<string> files;
+  operations_load_xml (filename, globalOperations, &globalJobs, &files);
+  asset_io_read_ahead (globalAssetIO, files);
+  frame_pipeline_start (globalPipeline, operations_update, globalPipelined);
+  // the default camera comes from the scene
+  frame_pipeline_run (globalPipeline, engine_frame_request ());
   env_load_defaults ();
   cerr << "LOOK_AT(" << globalCenterX << "," << globalCenterY << "," << globalCenterZ << ")" << endl;
   cerr << "POSITION(" << globalEyeX << "," << globalEyeY << "," << globalEyeZ << ")" << endl;
 }
 
-void engine_run (int argc, char **argv)
+void engine_usage ()
 {
+  fprintf (stderr, "usage: engine [-r fixed|shader] [-F rate|vsync|uncapped] [-S] [-j workers] [-t step] [-T time] [-w] [-n frames [-s WIDTHxHEIGHT] [-o prefix]] [-P trace] [-c stats] <xml_file>\n"
+                   "  -r  renderer: the fixed-function pipeline (default) or OpenGL 3.3 core profile shaders\n"
+                   "  -F  frame pacing: redraw on change at most this many times per second (default 60),\n"
+                   "      on change at most once per display refresh, or every frame as fast as possible\n"
+                   "  -S  simulate frames on the GL thread, instead of a frame ahead on a thread of their own\n"
+                   "  -j  threads helping to simulate each frame (default: one per core beyond two)\n"
+                   "  -t  advance animations by a fixed step of this many seconds per frame\n"
+                   "      (default 1/60 for offscreen frames, else real time)\n"
+                   "  -T  start animations at this many seconds\n"
+                   "  -w  draw polygons as wireframes\n"
+                   "  -n  render this many frames offscreen, without a window, printing their timings, and exit\n"
+                   "  -s  size of the window or of the offscreen frames (default 800x800)\n"
+                   "  -o  save each offscreen frame to <prefix><frame number>.png\n"
+                   "  -P  write the frame profile to this Chrome trace file at exit (else to trace.json on key f)\n"
+                   "  -c  write the counters of every frame to this CSV file\n");
+  exit (EXIT_FAILURE);
+}
 
-  if (argc != 2)
+//! OpenGL state of the selected renderer, set once the context exists.
+void engine_gl_setup ()
+{
+  //  OpenGL settings
+  glEnable (GL_DEPTH_TEST);
+
+  if (globalRenderer == RENDERER_SHADER)
+    globalPhong = phong_program_create ();
+  else
+    {
+      // activate 2D texturing (slide 10) [class11]
+      glEnable (GL_TEXTURE_2D);
+
+      /*
+       * For lighting to work properly when scales are applied to a model,
+       * the following code below should be added to the initialization.
+       * Activating this feature will result in normalizes normals after
+       * applying the geometric transformations, and before applying lighting.
+       */
+      glEnable (GL_RESCALE_NORMAL);
+
+      // activate lighting (done once in initialization) (slides 5) [class9]
+      glEnable (GL_LIGHTING);
+      // glEnable (GL_LIGHTi) done when needed
+
+      // activate arrays (slide 12) [class11]
+      glEnableClientState (GL_VERTEX_ARRAY);
+      glEnableClientState (GL_NORMAL_ARRAY);
+      glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+
+      /*
+       * To allow for ambient colors to be reproduced without having
+       * to activate the ambient component for all lights, the following
+       * code should be added to the initialization:
+       */
+      const float amb[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+      glLightModelfv (GL_LIGHT_MODEL_AMBIENT, amb);
+    }
+
+  // other details
+  //glEnable (GL_CULL_FACE);
+  //glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
+  if (globalWireframe)
+    glPolygonMode (GL_FRONT_AND_BACK, GL_LINE);
+
+  overlay_create (globalOverlay, globalRenderer == RENDERER_SHADER);
+  profiler_init (true);
+}
+
+//! Writes the trace asked for with -P, registered with atexit as GLUT may exit from its main loop.
+void engine_trace_at_exit ()
+{
+  profiler_export_chrome (globalTracePath);
+}
+
+//! Closes the stats asked for with -c, so their last rows are written, registered with atexit likewise.
+void engine_stats_at_exit ()
+{
+  if (globalStatsFile)
+    fclose (globalStatsFile);
+  globalStatsFile = nullptr;
+}
+
+#ifdef USE_HEADLESS
+/*!
+ * Renders a number of frames offscreen with the explorer camera and exits.
+ * Prints, as CSV on stdout, the CPU time spent issuing each frame and the GPU
+ * time spent executing it (GL_TIME_ELAPSED).
+ * @param[in] dump_prefix when not null, each frame is saved to <dump_prefix><frame>.png.
+ */
+void engine_headless_run (const char *const filename, const unsigned int frames,
+                          const int width, const int height, const char *const dump_prefix)
+{
+  using clock = std::chrono::steady_clock;
+
+  globalHeadless = true;
+  struct headless_target target;
+  headless_create (target, width, height, globalRenderer == RENDERER_SHADER);
+  engine_gl_setup ();
+  defaultChangeSize (width, height);
+  const auto load_start = clock::now ();
+  xml_load_and_set_env (filename);
+  cerr << "[headless] scene loaded in "
+       << std::chrono::duration<double, std::milli> (clock::now () - load_start).count () << " ms" << endl;
+
+  // two queries, the one of the previous frame being read while the current one runs
+  GLuint queries[2];
+  glGenQueries (2, queries);
+  vector<double> cpu_ms (frames);
+  double cpu_total = 0, gpu_total = 0;
+  printf ("frame,cpu_ms,gpu_ms\n");
+  const auto report = [&] (const unsigned int f)
+  {
+    GLuint64 elapsed;
+    glGetQueryObjectui64v (queries[f % 2], GL_QUERY_RESULT, &elapsed);
+    const double gpu_ms = (double) elapsed / 1e6;
+    printf ("%u,%.3f,%.3f\n", f, cpu_ms[f], gpu_ms);
+    cpu_total += cpu_ms[f];
+    gpu_total += gpu_ms;
+  };
+
+  for (unsigned int f = 0; f < frames; ++f)
+    {
+      const auto start = clock::now ();
+      glBeginQuery (GL_TIME_ELAPSED, queries[f % 2]);
+      engine_frame ();
+      glEndQuery (GL_TIME_ELAPSED);
+      cpu_ms[f] = std::chrono::duration<double, std::milli> (clock::now () - start).count ();
+      engine_frame_stats (width, height);
+      // frames follow each other, so they are simulated ahead as in a window
+      frame_scheduler_done (globalScheduler, engine_animating ());
+
+      if (dump_prefix)
+        {
+          char path[BUFSIZ];
+          snprintf (path, sizeof (path), "%s%04u.png", dump_prefix, f);
+          headless_dump (target, path);
+        }
+      if (f > 0)
+        report (f - 1);
+    }
+  if (frames > 0)
+    report (frames - 1);
+  cerr << "[headless] " << frames << " frames, mean cpu " << cpu_total / frames
+       << " ms, mean gpu " << gpu_total / frames << " ms" << endl;
+
+  glDeleteQueries (2, queries);
+  profiler_flush ();
+  headless_destroy (target);
+}
+#endif
+
+void engine_run (int argc, char **argv)
+{
+  unsigned int frames = 0;
+  int width = 800, height = 800;
+  const char *dump_prefix = nullptr;
+
+  int option;
+  while ((option = getopt (argc, argv, "r:F:Sj:t:T:wn:s:o:P:c:")) != -1)
+    switch (option)
+      {
+        case 'r':
+          if (string (optarg) == "fixed")
+            globalRenderer = RENDERER_FIXED;
+          else if (string (optarg) == "shader")
+            globalRenderer = RENDERER_SHADER;
+          else
+            engine_usage ();
+        break;
+        case 'F':
+          if (string (optarg) == "vsync")
+            globalScheduler.pacing = PACING_VSYNC;
+          else if (string (optarg) == "uncapped")
+            globalScheduler.pacing = PACING_UNCAPPED;
+          else
+            {
+              const double rate = strtod (optarg, nullptr);
+              if (rate <= 0)
+                engine_usage ();
+              globalScheduler.pacing = PACING_TARGET;
+              globalScheduler.interval = 1 / rate;
+            }
+        break;
+        case 'S':
+          globalPipelined = false;
+        break;
+        case 'j':
+          {
+            char *end;
+            globalJobWorkers = (unsigned int) strtoul (optarg, &end, 10);
+            if (*end || end == optarg)
+              engine_usage ();
+          }
+        break;
+        case 't':
+          globalClock.fixed_step = strtod (optarg, nullptr);
+          if (globalClock.fixed_step <= 0)
+            engine_usage ();
+        break;
+        case 'T':
+          sim_clock_seek (globalClock, strtod (optarg, nullptr));
+        break;
+        case 'w':
+          globalWireframe = true;
+        break;
+        case 'n':
+          frames = (unsigned int) strtoul (optarg, nullptr, 10);
+          if (!frames)
+            engine_usage ();
+        break;
+        case 's':
+          if (sscanf (optarg, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+            engine_usage ();
+        break;
+        case 'o':
+          dump_prefix = optarg;
+        break;
+        case 'P':
+          globalTracePath = optarg;
+        break;
+        case 'c':
+          if (globalStatsFile)
+            fclose (globalStatsFile);
+          globalStatsFile = fopen (optarg, "w");
+          if (!globalStatsFile)
+            {
+              fprintf (stderr, "could not open '%s' for writing\n", optarg);
+              exit (EXIT_FAILURE);
+            }
+          stats_csv_header (globalStatsFile);
+        break;
+        default:
+          engine_usage ();
+      }
+  if (argc - optind != 1)
     {
       fprintf (stderr, "Engine only receives one argument, namley: the xml file defining what to draw\n");
-      exit (EXIT_FAILURE);
+      engine_usage ();
     }
+  if (globalTracePath)
+    atexit (engine_trace_at_exit);
+  if (globalStatsFile)
+    atexit (engine_stats_at_exit);
 
+  if (frames)
+    {
+      // reproducible runs: the same frame always shows the same scene
+      if (globalClock.fixed_step <= 0)
+        globalClock.fixed_step = 1.0 / 60;
+#ifdef USE_HEADLESS
+      engine_headless_run (argv[optind], frames, width, height, dump_prefix);
+      exit (EXIT_SUCCESS);
+#else
+      fprintf (stderr, "Engine was built without offscreen rendering (EGL was not found)\n");
+      exit (EXIT_FAILURE);
+#endif
+    }
 
   // init GLUT and the window
   glutInit (&argc, argv);
 
-  glutInitDisplayMode (GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGBA);
+  unsigned int display_mode = GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGBA;
+  if (globalRenderer == RENDERER_SHADER)
+    {
+#ifdef __APPLE__
+      display_mode |= GLUT_3_2_CORE_PROFILE;
+#else
+      glutInitContextVersion (3, 3);
+      glutInitContextProfile (GLUT_CORE_PROFILE);
+#endif
+    }
+  glutInitDisplayMode (display_mode);
   glutInitWindowPosition (100, 100);
-  glutInitWindowSize (800, 800);
+  glutInitWindowSize (width, height);
   glutCreateWindow ("engine");
 
   // Required callback registry
   glutDisplayFunc (renderScene);
   loadProfile (profile[globalProfile]);
 
-
-  //  OpenGL settings
-  glEnable (GL_DEPTH_TEST);
-
-  // activate 2D texturing (slide 10) [class11]
-  glEnable (GL_TEXTURE_2D);
-
-  /*
-   * For lighting to work properly when scales are applied to a model,
-   * the following code below should be added to the initialization.
-   * Activating this feature will result in normalizes normals after
-   * applying the geometric transformations, and before applying lighting.
-   */
-  glEnable (GL_RESCALE_NORMAL);
-
-  // activate lighting (done once in initialization) (slides 5) [class9]
-  glEnable (GL_LIGHTING);
-  // glEnable (GL_LIGHTi) done when needed
-
-  // activate arrays (slide 12) [class11]
-  glEnableClientState (GL_VERTEX_ARRAY);
-  glEnableClientState (GL_NORMAL_ARRAY);
-  glEnableClientState (GL_TEXTURE_COORD_ARRAY);
-
-  /*
-   * To allow for ambient colors to be reproduced without having
-   * to activate the ambient component for all lights, the following
-   * code should be added to the initialization:
-   */
-  const float amb[4] = {1.0f, 1.0f, 1.0f, 1.0f};
-  glLightModelfv (GL_LIGHT_MODEL_AMBIENT, amb);
-
-  // other details
-  //glEnable (GL_CULL_FACE);
-  //glPolygonMode (GL_FRONT_AND_BACK, GL_FILL);
-
+  // core profiles need the experimental entry points
+  glewExperimental = GL_TRUE;
   glewInit ();
 
-  xml_load_and_set_env (argv[1]);
+  engine_gl_setup ();
+  if (globalScheduler.pacing != PACING_TARGET)
+    engine_swap_interval (globalScheduler.pacing == PACING_VSYNC ? 1 : 0);
+
+  xml_load_and_set_env (argv[optind]);
+  // edits to the scene and its assets show up without restarting
+  if (file_watch_create (globalFileWatch))
+    {
+      engine_watch_scene ();
+      glutTimerFunc (WATCH_POLL_MS, engineWatchTimer, 0);
+    }
+  engine_request_frame ();
   glutMainLoop ();
 }
 
 /*!
- * ⟨command⟩ ::= ⟨xml_file⟩
+ * ⟨command⟩ ::= [-r ⟨renderer⟩] [-F ⟨pacing⟩] [-S] [-j ⟨workers⟩] [-t ⟨step⟩] [-T ⟨time⟩] [-w] [-n ⟨frames⟩ [-s ⟨width⟩x⟨height⟩] [-o ⟨prefix⟩]] [-P ⟨trace⟩] [-c ⟨stats⟩] ⟨xml_file⟩
  */
 int main (int argc, char **argv)
 {
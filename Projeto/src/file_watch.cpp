@@ -0,0 +1,110 @@
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include "file_watch.h"
+
+using std::string, std::cerr, std::endl;
+namespace fs = std::filesystem;
+
+/*! @addtogroup fileWatch
+ * @{
+ * Tells which of a set of files were written since it was last asked, without blocking.
+ *
+ * Directories are watched rather than the files themselves: editors often save by
+ * writing a new file and renaming it over the old one, which a watch on the old
+ * file would not see. A file counts as changed once it is closed after writing or
+ * moved into place, so half written files are never reported.
+ *
+ * Only Linux has inotify, elsewhere no file ever changes.
+ */
+
+static string file_watch_key (const fs::path &path)
+{
+  return path.lexically_normal ().string ();
+}
+
+//! @return false when files cannot be watched, on this system or for lack of inotify instances.
+bool file_watch_create (struct file_watch &watch)
+{
+#ifdef __linux__
+  watch.fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+  if (watch.fd < 0)
+    {
+      perror ("[file_watch] inotify_init1");
+      return false;
+    }
+  return true;
+#else
+  return false;
+#endif
+}
+
+//! Watches one more file, which need not exist yet. Files already watched are ignored.
+void file_watch_add (struct file_watch &watch, const string &path)
+{
+  if (watch.fd < 0)
+    return;
+  const string key = file_watch_key (path);
+  if (watch.files.count (key))
+    return;
+  watch.files[key] = path;
+#ifdef __linux__
+  const fs::path parent = fs::path (path).parent_path ();
+  const string directory = parent.empty () ? "." : parent.string ();
+  const int wd = inotify_add_watch (watch.fd, directory.c_str (), IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd < 0)
+    {
+      cerr << "[file_watch] cannot watch '" << directory << "': " << strerror (errno) << endl;
+      return;
+    }
+  watch.directories[wd] = directory;
+#endif
+}
+
+/*!
+ * Adds to changed the watched files written since the last poll, as they were added.
+ */
+void file_watch_poll (struct file_watch &watch, std::set<string> &changed)
+{
+#ifdef __linux__
+  if (watch.fd < 0)
+    return;
+  alignas (struct inotify_event) char buffer[16 * (sizeof (struct inotify_event) + NAME_MAX + 1)];
+  ssize_t length;
+  while ((length = read (watch.fd, buffer, sizeof (buffer))) > 0)
+    for (char *p = buffer; p < buffer + length;)
+      {
+        const auto *const event = (const struct inotify_event *) p;
+        p += sizeof (struct inotify_event) + event->len;
+        const auto directory = watch.directories.find (event->wd);
+        if (!event->len || directory == watch.directories.end ())
+          continue;
+        const auto file = watch.files.find (file_watch_key (fs::path (directory->second) / event->name));
+        if (file != watch.files.end ())
+          changed.insert (file->second);
+      }
+  if (length < 0 && errno != EAGAIN)
+    perror ("[file_watch] read");
+#endif
+}
+
+void file_watch_destroy (struct file_watch &watch)
+{
+#ifdef __linux__
+  if (watch.fd >= 0)
+    close (watch.fd);
+#endif
+  watch.fd = -1;
+  watch.directories.clear ();
+  watch.files.clear ();
+}
+
+//!@} end of group fileWatch
@@ -0,0 +1,18 @@
+#ifndef _FILE_WATCH_H_
+#define _FILE_WATCH_H_
+#include <map>
+#include <set>
+#include <string>
+
+//! Files watched for changes, through inotify on the directories holding them.
+struct file_watch {
+  int fd = -1;
+  std::map<int, std::string> directories;       // watch descriptor -> directory
+  std::map<std::string, std::string> files;     // normalized path -> path as added
+};
+
+bool file_watch_create (struct file_watch &watch);
+void file_watch_add (struct file_watch &watch, const std::string &path);
+void file_watch_poll (struct file_watch &watch, std::set<std::string> &changed);
+void file_watch_destroy (struct file_watch &watch);
+#endif //_FILE_WATCH_H_
@@ -0,0 +1,139 @@
+#include "frame_pipeline.h"
+#include "profiler.h"
+
+/*! @addtogroup framePipeline
+ * @{
+ * Runs the simulation of a frame, animation, BVH refit, culling and the sort of the
+ * render queue, on its own thread, while the GL thread submits the previous one.
+ *
+ * The GL thread posts a request for frame N with the clock and camera it read, and
+ * draws packet N-1; the simulation thread turns request N into packet N meanwhile.
+ * Packets go through a triple buffer: the simulation writes the back one, hands it
+ * over by swapping it with the middle one, and the GL thread takes the middle one
+ * in turn by swapping it with the front one it is done drawing. Neither side ever
+ * blocks the other on a buffer, the only waits being for the frame itself.
+ *
+ * A packet is a snapshot, the GL thread reading nothing the simulation writes but
+ * it. The request is only written while the simulation waits for the next one.
+ * Each packet has its own arena for the transient data of its frame, reset when
+ * the packet is reused: whatever the frame being drawn allocated there stays valid
+ * while the next ones are simulated.
+ *
+ * Without a thread, or for frames run inline, the update runs on the GL thread and
+ * the packet is handed over the same way.
+ */
+
+//! Set on the middle index while its packet is newer than the front one.
+const unsigned int PACKET_FRESH = 4;
+
+static void frame_pipeline_publish (struct frame_pipeline &pipeline, const uint64_t frame)
+{
+  pipeline.back = pipeline.middle.exchange (pipeline.back | PACKET_FRESH, std::memory_order_acq_rel) & ~PACKET_FRESH;
+  pipeline.published.store (frame, std::memory_order_release);
+  pipeline.published.notify_all ();
+}
+
+static void frame_pipeline_update (struct frame_pipeline &pipeline, const struct frame_request &request)
+{
+  struct frame_packet &packet = pipeline.packets[pipeline.back];
+  arena_reset (packet.arena);
+  packet.request = request;
+  pipeline.update (request, packet);
+}
+
+static void frame_pipeline_thread (struct frame_pipeline &pipeline)
+{
+  profiler_thread ("simulation");
+  for (;;)
+    {
+      const uint64_t requested = pipeline.requested.load (std::memory_order_acquire);
+      if (pipeline.quit.load (std::memory_order_acquire))
+        return;
+      // frames run inline are published before they count as requested, so they are never run again here
+      if (requested <= pipeline.published.load (std::memory_order_acquire))
+        {
+          pipeline.requested.wait (requested, std::memory_order_acquire);
+          continue;
+        }
+      const struct frame_request request = pipeline.request;
+      {
+        profiler_scope scope ("simulate");
+        frame_pipeline_update (pipeline, request);
+      }
+      frame_pipeline_publish (pipeline, request.frame);
+    }
+}
+
+/*!
+ * @param[in] update fills a packet from a request, on the simulation thread.
+ * @param[in] threaded whether to run the updates on their own thread, rather than inline in frame_pipeline_post.
+ */
+void frame_pipeline_start (struct frame_pipeline &pipeline, const frame_update update, const bool threaded)
+{
+  pipeline.update = update;
+  pipeline.threaded = threaded;
+  if (threaded)
+    pipeline.thread = std::thread (frame_pipeline_thread, std::ref (pipeline));
+}
+
+/*!
+ * Has the simulation start on a frame, from the GL thread. The previous one must
+ * have been acquired, so the simulation is waiting for this one.
+ */
+void frame_pipeline_post (struct frame_pipeline &pipeline, const struct frame_request &request)
+{
+  if (!pipeline.threaded)
+    {
+      frame_pipeline_run (pipeline, request);
+      return;
+    }
+  pipeline.request = request;
+  pipeline.requested.store (request.frame, std::memory_order_release);
+  pipeline.requested.notify_one ();
+}
+
+/*!
+ * Simulates a frame on the GL thread, once the simulation thread is idle, e.g. for
+ * frames that upload to GL while they are built.
+ */
+void frame_pipeline_run (struct frame_pipeline &pipeline, const struct frame_request &request)
+{
+  frame_pipeline_sync (pipeline);
+  frame_pipeline_update (pipeline, request);
+  frame_pipeline_publish (pipeline, request.frame);
+  pipeline.requested.store (request.frame, std::memory_order_release);
+}
+
+/*!
+ * Waits for the packet of a frame, or a later one, and takes it for drawing.
+ * It stays valid until the next call.
+ */
+const struct frame_packet &frame_pipeline_acquire (struct frame_pipeline &pipeline, const uint64_t frame)
+{
+  for (uint64_t published; (published = pipeline.published.load (std::memory_order_acquire)) < frame;)
+    pipeline.published.wait (published, std::memory_order_acquire);
+  if (pipeline.middle.load (std::memory_order_relaxed) & PACKET_FRESH)
+    pipeline.front = pipeline.middle.exchange (pipeline.front, std::memory_order_acq_rel) & ~PACKET_FRESH;
+  return pipeline.packets[pipeline.front];
+}
+
+//! Waits until the simulation is done with every frame requested, so the scene may be touched.
+void frame_pipeline_sync (struct frame_pipeline &pipeline)
+{
+  const uint64_t requested = pipeline.requested.load (std::memory_order_relaxed);
+  for (uint64_t published; (published = pipeline.published.load (std::memory_order_acquire)) < requested;)
+    pipeline.published.wait (published, std::memory_order_acquire);
+}
+
+void frame_pipeline_stop (struct frame_pipeline &pipeline)
+{
+  if (!pipeline.thread.joinable ())
+    return;
+  frame_pipeline_sync (pipeline);
+  pipeline.quit.store (true, std::memory_order_release);
+  pipeline.requested.fetch_add (1, std::memory_order_release);
+  pipeline.requested.notify_one ();
+  pipeline.thread.join ();
+}
+
+//!@} end of group framePipeline
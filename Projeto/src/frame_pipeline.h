@@ -0,0 +1,59 @@
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "arena.h"
+#include "render_queue.h"
+#include "sim_clock.h"
+
+//! What the simulation of a frame starts from, taken on the GL thread when the frame begins.
+struct frame_request {
+  uint64_t frame = 0; // from 1
+  struct sim_clock clock;
+  glm::mat4 view{1};
+  glm::mat4 projection{1};
+  float near = 1, far = 1000; // of the projection
+};
+
+//! All the GL thread needs to draw a frame, left untouched by the simulation while it is drawn.
+struct frame_packet {
+  struct frame_request request;          // the packet was simulated from
+  uint64_t scene = 0;                    // builds of the scene so far, GL state set up from the scene follows its changes
+  std::vector<glm::mat4> worlds;         // by model, of the visible ones only
+  std::vector<glm::mat4> curve_worlds;   // by curve
+  std::vector<struct draw_packet> queue; // the visible models, in drawing order
+  unsigned int visible = 0;
+  unsigned int culled = 0;
+  struct frame_arena arena;              // transient data of the frame, reset when the packet is simulated again
+};
+
+typedef void (*frame_update) (const struct frame_request &request, struct frame_packet &packet);
+
+/*!
+ * Simulation thread turning frame requests into packets, handed over to the GL thread
+ * through a triple buffer.
+ */
+struct frame_pipeline {
+  frame_update update = nullptr;
+  bool threaded = false;
+  std::thread thread;
+  struct frame_request request;          // written by the GL thread only while the simulation waits
+  std::atomic<uint64_t> requested{0};    // frame of the last request
+  std::atomic<uint64_t> published{0};    // frame of the last packet handed over
+  std::atomic<bool> quit{false};
+  struct frame_packet packets[3];
+  std::atomic<unsigned int> middle{1};   // packet handed over, with PACKET_FRESH until the GL thread takes it
+  unsigned int back = 0;                 // packet the simulation writes
+  unsigned int front = 2;                // packet the GL thread draws
+};
+
+void frame_pipeline_start (struct frame_pipeline &pipeline, frame_update update, bool threaded);
+void frame_pipeline_post (struct frame_pipeline &pipeline, const struct frame_request &request);
+void frame_pipeline_run (struct frame_pipeline &pipeline, const struct frame_request &request);
+const struct frame_packet &frame_pipeline_acquire (struct frame_pipeline &pipeline, uint64_t frame);
+void frame_pipeline_sync (struct frame_pipeline &pipeline);
+void frame_pipeline_stop (struct frame_pipeline &pipeline);
+#endif //_FRAME_PIPELINE_H_
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "frame_scheduler.h"
+
+/*! @addtogroup frameScheduler
+ * @{
+ * A static scene is drawn once and then left alone until input arrives, the camera
+ * moves or assets are reloaded; animated scenes are drawn continuously, but no
+ * faster than the target rate.
+ *
+ * Frames start on a fixed grid of the interval rather than an interval after the
+ * previous one ended, so the rate does not drift with how long frames take. The
+ * wait sleeps until shortly before the frame is due, as the scheduler wakes sleepers
+ * up to a millisecond or so late, and yields for the rest: frames start within
+ * microseconds of their time without spinning a core for the whole interval.
+ */
+
+//! the scheduler may wake a sleeping thread this late
+const double SLEEP_SLACK = 1.5e-3;
+
+static double frame_scheduler_now ()
+{
+  using namespace std::chrono;
+  return duration<double> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+//! Something visible changed: the next frame is drawn.
+void frame_scheduler_invalidate (struct frame_scheduler &scheduler)
+{
+  scheduler.dirty = true;
+}
+
+//! Whether a frame is to be drawn, now or once its time comes.
+bool frame_scheduler_pending (const struct frame_scheduler &scheduler)
+{
+  return scheduler.dirty || scheduler.continuous || scheduler.pacing == PACING_UNCAPPED;
+}
+
+//! Blocks until the next frame may start, at the target rate only as the others never wait.
+void frame_scheduler_wait (const struct frame_scheduler &scheduler)
+{
+  if (scheduler.pacing != PACING_TARGET)
+    return;
+  const double sleep = scheduler.due - SLEEP_SLACK - frame_scheduler_now ();
+  if (sleep > 0)
+    std::this_thread::sleep_for (std::chrono::duration<double> (sleep));
+  while (frame_scheduler_now () < scheduler.due)
+    std::this_thread::yield ();
+}
+
+/*!
+ * To be called when a frame has been drawn.
+ * @param[in] continuous whether animations are running, so the next frame is drawn without waiting for a change.
+ */
+void frame_scheduler_done (struct frame_scheduler &scheduler, const bool continuous)
+{
+  scheduler.dirty = false;
+  scheduler.continuous = continuous;
+  // back on the grid, unless the frame came late: the next one is then due at once, not in a burst
+  scheduler.due = std::max (scheduler.due + scheduler.interval, frame_scheduler_now ());
+}
+
+//!@} end of group frameScheduler
@@ -0,0 +1,23 @@
+#ifndef _FRAME_SCHEDULER_H_
+#define _FRAME_SCHEDULER_H_
+
+enum {
+  PACING_TARGET = 0, // on demand, at most at the target rate, sleeping in between
+  PACING_VSYNC,      // on demand, at most at the display rate, the swap waiting for it
+  PACING_UNCAPPED    // every frame as soon as possible, for benchmarks
+};
+
+//! Decides when the next frame is drawn: only when something changed, and no sooner than its pacing allows.
+struct frame_scheduler {
+  int pacing = PACING_TARGET;
+  double interval = 1.0 / 60; // seconds between frames at the target rate
+  double due = -1;            // real seconds at which the next frame may start
+  bool dirty = true;          // input, the camera or the scene changed since the last frame
+  bool continuous = false;    // animations are running, so every frame differs from the previous
+};
+
+void frame_scheduler_invalidate (struct frame_scheduler &scheduler);
+bool frame_scheduler_pending (const struct frame_scheduler &scheduler);
+void frame_scheduler_wait (const struct frame_scheduler &scheduler);
+void frame_scheduler_done (struct frame_scheduler &scheduler, bool continuous);
+#endif //_FRAME_SCHEDULER_H_
@@ -0,0 +1,141 @@
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <IL/il.h>
+#include "headless.h"
+
+using std::cerr, std::endl;
+
+/*! @addtogroup headless
+ * @{
+ * Rendering without a display, for benchmarks and CI.
+ *
+ * The context comes from EGL on the surfaceless platform (EGL_MESA_platform_surfaceless),
+ * which needs neither an X server nor a GPU: with Mesa it falls back to llvmpipe.
+ * Having no surface, the context draws into a framebuffer object of the requested size.
+ */
+
+static void headless_fail (const char *const what)
+{
+  cerr << "[headless] " << what << " (EGL error 0x" << std::hex << eglGetError () << std::dec << ")" << endl;
+  exit (EXIT_FAILURE);
+}
+
+static EGLDisplay headless_display ()
+{
+  const char *const extensions = eglQueryString (EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (extensions && strstr (extensions, "EGL_MESA_platform_surfaceless"))
+    {
+      const auto get_platform_display =
+          (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress ("eglGetPlatformDisplayEXT");
+      if (get_platform_display)
+        return get_platform_display (EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+  return eglGetDisplay (EGL_DEFAULT_DISPLAY);
+}
+
+/*!
+ * Creates the context, makes it current and binds a width × height framebuffer to draw into.
+ * @param[in] core_profile whether to ask for a 3.3 core profile instead of a compatibility one.
+ */
+void headless_create (struct headless_target &target, const int width, const int height, const bool core_profile)
+{
+  target.display = headless_display ();
+  if (target.display == EGL_NO_DISPLAY || !eglInitialize (target.display, nullptr, nullptr))
+    headless_fail ("failed to initialize an EGL display");
+  if (!eglBindAPI (EGL_OPENGL_API))
+    headless_fail ("EGL display does not support desktop OpenGL");
+
+  const EGLint config_attributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig config = nullptr;
+  EGLint configs = 0;
+  eglChooseConfig (target.display, config_attributes, &config, 1, &configs);
+
+  const EGLint core_attributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3,
+      EGL_CONTEXT_MINOR_VERSION, 3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE};
+  const EGLint compatibility_attributes[] = {
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+      EGL_NONE};
+  // surfaceless contexts (EGL_KHR_no_config_context) do not need a config
+  target.context = eglCreateContext (target.display, configs ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                                     core_profile ? core_attributes : compatibility_attributes);
+  if (target.context == EGL_NO_CONTEXT)
+    headless_fail ("failed to create an OpenGL context");
+  if (!eglMakeCurrent (target.display, EGL_NO_SURFACE, EGL_NO_SURFACE, target.context))
+    headless_fail ("failed to make the context current");
+
+  // without a GLX display glewInit fails after having loaded the GL entry points, which is all it is needed for
+  glewExperimental = GL_TRUE;
+  const GLenum glew_status = glewInit ();
+  if (glew_status != GLEW_OK && glew_status != GLEW_ERROR_NO_GLX_DISPLAY)
+    {
+      cerr << "[headless] glewInit failed: " << glewGetErrorString (glew_status) << endl;
+      exit (EXIT_FAILURE);
+    }
+
+  target.width = width;
+  target.height = height;
+  glGenRenderbuffers (1, &target.color);
+  glBindRenderbuffer (GL_RENDERBUFFER, target.color);
+  glRenderbufferStorage (GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glGenRenderbuffers (1, &target.depth);
+  glBindRenderbuffer (GL_RENDERBUFFER, target.depth);
+  glRenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer (GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers (1, &target.framebuffer);
+  glBindFramebuffer (GL_FRAMEBUFFER, target.framebuffer);
+  glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color);
+  glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+  if (glCheckFramebufferStatus (GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+      cerr << "[headless] incomplete framebuffer" << endl;
+      exit (EXIT_FAILURE);
+    }
+
+  cerr << "[headless] " << glGetString (GL_RENDERER) << ", OpenGL " << glGetString (GL_VERSION)
+       << ", " << width << "x" << height << endl;
+}
+
+//! Saves the framebuffer to an image file, its format given by the extension.
+void headless_dump (const struct headless_target &target, const char *const path)
+{
+  static bool isFirstTimeBeingExecuted = true;
+  if (isFirstTimeBeingExecuted)
+    {
+      ilInit ();
+      ilEnable (IL_FILE_OVERWRITE);
+      isFirstTimeBeingExecuted = false;
+    }
+
+  std::vector<unsigned char> pixels (4 * (size_t) target.width * target.height);
+  glPixelStorei (GL_PACK_ALIGNMENT, 1);
+  glReadPixels (0, 0, target.width, target.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data ());
+
+  ILuint image;
+  ilGenImages (1, &image);
+  ilBindImage (image);
+  // glReadPixels rows start at the bottom, as do DevIL's by default
+  ilTexImage (target.width, target.height, 1, 4, IL_RGBA, IL_UNSIGNED_BYTE, pixels.data ());
+  if (!ilSaveImage ((ILstring) path))
+    cerr << "[headless] failed to save '" << path << "', ERROR#" << ilGetError () << endl;
+  ilDeleteImages (1, &image);
+}
+
+void headless_destroy (struct headless_target &target)
+{
+  glDeleteFramebuffers (1, &target.framebuffer);
+  glDeleteRenderbuffers (1, &target.color);
+  glDeleteRenderbuffers (1, &target.depth);
+  eglMakeCurrent (target.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext (target.display, target.context);
+  eglTerminate (target.display);
+  target = {};
+}
+
+//!@} end of group headless
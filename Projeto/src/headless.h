@@ -0,0 +1,20 @@
+#ifndef _HEADLESS_H_
+#define _HEADLESS_H_
+#include <EGL/egl.h>
+#include <GL/glew.h>
+
+//! Offscreen GL context, without window system, drawing into a framebuffer object.
+struct headless_target {
+  EGLDisplay display = EGL_NO_DISPLAY;
+  EGLContext context = EGL_NO_CONTEXT;
+  GLuint framebuffer = 0;
+  GLuint color = 0;
+  GLuint depth = 0;
+  int width = 0;
+  int height = 0;
+};
+
+void headless_create (struct headless_target &target, int width, int height, bool core_profile);
+void headless_dump (const struct headless_target &target, const char *path);
+void headless_destroy (struct headless_target &target);
+#endif //_HEADLESS_H_
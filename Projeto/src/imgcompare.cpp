@@ -0,0 +1,215 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+#include <IL/il.h>
+
+using std::vector, std::cerr, std::endl;
+
+/*! @addtogroup imgcompare
+ * @{
+ * Compares a rendered frame with a reference image, as the regression harness
+ * (regress/regress.sh) does for every test scene.
+ *
+ * Images are told apart the way they look, not by their bytes: both are blurred
+ * by a 3×3 box, so that edges rasterized a pixel apart still match, and pixels
+ * are compared by their distance in CIELAB (ΔE*ab, 2.3 being a just noticeable
+ * difference). The images match when few enough pixels are further apart than
+ * the tolerance.
+ *
+ * References being screenshots of a window, a larger reference is cropped to
+ * its client area: borders of equal width left, right and below, and the title
+ * bar above.
+ *
+ * Exit status, as cmp(1): 0 when the images match, 1 when they differ, 2 on trouble.
+ */
+
+const int MATCH = 0;
+const int DIFFERENT = 1;
+const int TROUBLE = 2;
+
+struct image {
+  int width = 0;
+  int height = 0;
+  vector<float> lab; // L*, a*, b* per pixel, top row first
+};
+
+static float srgb_to_linear (const float c)
+{
+  return c <= 0.04045f ? c / 12.92f : powf ((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float lab_f (const float t)
+{
+  const float delta = 6.0f / 29;
+  return t > delta * delta * delta ? cbrtf (t) : t / (3 * delta * delta) + 4.0f / 29;
+}
+
+//! CIELAB of an sRGB colour, with the D65 white point.
+static void rgb_to_lab (const float r, const float g, const float b, float *const lab)
+{
+  const float R = srgb_to_linear (r), G = srgb_to_linear (g), B = srgb_to_linear (b);
+  const float x = (0.4124f * R + 0.3576f * G + 0.1805f * B) / 0.95047f;
+  const float y = 0.2126f * R + 0.7152f * G + 0.0722f * B;
+  const float z = (0.0193f * R + 0.1192f * G + 0.9505f * B) / 1.08883f;
+  lab[0] = 116 * lab_f (y) - 16;
+  lab[1] = 500 * (lab_f (x) - lab_f (y));
+  lab[2] = 200 * (lab_f (y) - lab_f (z));
+}
+
+/*!
+ * Loads an image, blurred and in CIELAB.
+ * @param[in] crop_width, crop_height when not 0, size of the client area the image, a window screenshot, is cropped to.
+ */
+static struct image image_load (const char *const path, const int crop_width, const int crop_height)
+{
+  ILuint handle;
+  ilGenImages (1, &handle);
+  ilBindImage (handle);
+  if (!ilLoadImage ((ILstring) path) || !ilConvertImage (IL_RGB, IL_UNSIGNED_BYTE))
+    {
+      cerr << "[imgcompare] failed loading '" << path << "', ERROR#" << ilGetError () << endl;
+      exit (TROUBLE);
+    }
+  const int full_width = ilGetInteger (IL_IMAGE_WIDTH);
+  const int full_height = ilGetInteger (IL_IMAGE_HEIGHT);
+  const ILubyte *const rgb = ilGetData ();
+
+  struct image image;
+  image.width = crop_width ? crop_width : full_width;
+  image.height = crop_height ? crop_height : full_height;
+  const int border = (full_width - image.width) / 2;
+  const int x0 = border;
+  const int y0 = full_height - image.height - border;
+  if (border < 0 || y0 < 0)
+    {
+      cerr << "[imgcompare] '" << path << "' (" << full_width << "x" << full_height
+           << ") is smaller than the image it is compared with" << endl;
+      exit (TROUBLE);
+    }
+
+  // 3×3 box blur, clamped at the edges, in sRGB
+  vector<float> blurred (3 * (size_t) image.width * image.height);
+  for (int y = 0; y < image.height; ++y)
+    for (int x = 0; x < image.width; ++x)
+      {
+        float sum[3] = {0, 0, 0};
+        int count = 0;
+        for (int dy = -1; dy <= 1; ++dy)
+          for (int dx = -1; dx <= 1; ++dx)
+            {
+              const int sx = x + dx, sy = y + dy;
+              if (sx < 0 || sy < 0 || sx >= image.width || sy >= image.height)
+                continue;
+              const ILubyte *const p = &rgb[3 * ((size_t) (y0 + sy) * full_width + x0 + sx)];
+              for (int c = 0; c < 3; ++c)
+                sum[c] += p[c];
+              ++count;
+            }
+        float *const out = &blurred[3 * ((size_t) y * image.width + x)];
+        for (int c = 0; c < 3; ++c)
+          out[c] = sum[c] / (255.0f * (float) count);
+      }
+  ilDeleteImages (1, &handle);
+
+  image.lab.resize (blurred.size ());
+  for (size_t p = 0; p < blurred.size (); p += 3)
+    rgb_to_lab (blurred[p], blurred[p + 1], blurred[p + 2], &image.lab[p]);
+  return image;
+}
+
+/*!
+ * Writes the image dimmed to grey, the pixels that differ from the reference in red.
+ */
+static void diff_save (const char *const path, const struct image &image, const vector<bool> &different)
+{
+  vector<ILubyte> rgb (3 * (size_t) image.width * image.height);
+  for (size_t p = 0; p < different.size (); ++p)
+    {
+      const auto grey = (ILubyte) (image.lab[3 * p] * 255 / 100 / 3);
+      rgb[3 * p] = different[p] ? 255 : grey;
+      rgb[3 * p + 1] = different[p] ? 0 : grey;
+      rgb[3 * p + 2] = different[p] ? 0 : grey;
+    }
+  ILuint handle;
+  ilGenImages (1, &handle);
+  ilBindImage (handle);
+  ilTexImage (image.width, image.height, 1, 3, IL_RGB, IL_UNSIGNED_BYTE, rgb.data ());
+  ilRegisterOrigin (IL_ORIGIN_UPPER_LEFT);
+  if (!ilSaveImage ((ILstring) path))
+    cerr << "[imgcompare] failed to save '" << path << "', ERROR#" << ilGetError () << endl;
+  ilDeleteImages (1, &handle);
+}
+
+void usage ()
+{
+  fprintf (stderr, "usage: imgcompare [-e delta_e] [-f fraction] [-d diff.png] <reference> <image>\n"
+                   "  -e  colour distance (CIELAB ΔE) above which two pixels differ (default 10)\n"
+                   "  -f  fraction of pixels allowed to differ (default 0.01)\n"
+                   "  -d  save where the images differ to this file\n");
+  exit (TROUBLE);
+}
+
+/*!
+ * ⟨command⟩ ::= [-e ⟨delta_e⟩] [-f ⟨fraction⟩] [-d ⟨diff⟩] ⟨reference⟩ ⟨image⟩
+ */
+int main (int argc, char **argv)
+{
+  float tolerance = 10;
+  double allowed = 0.01;
+  const char *diff_path = nullptr;
+
+  int option;
+  while ((option = getopt (argc, argv, "e:f:d:")) != -1)
+    switch (option)
+      {
+        case 'e':
+          tolerance = strtof (optarg, nullptr);
+        break;
+        case 'f':
+          allowed = strtod (optarg, nullptr);
+        break;
+        case 'd':
+          diff_path = optarg;
+        break;
+        default:
+          usage ();
+      }
+  if (argc - optind != 2)
+    usage ();
+  const char *const reference_path = argv[optind];
+  const char *const image_path = argv[optind + 1];
+
+  ilInit ();
+  ilEnable (IL_ORIGIN_SET);
+  ilOriginFunc (IL_ORIGIN_UPPER_LEFT);
+  ilEnable (IL_FILE_OVERWRITE);
+
+  const struct image image = image_load (image_path, 0, 0);
+  const struct image reference = image_load (reference_path, image.width, image.height);
+
+  vector<bool> different (image.lab.size () / 3);
+  size_t count = 0;
+  float worst = 0;
+  for (size_t p = 0; p < different.size (); ++p)
+    {
+      const float *const a = &image.lab[3 * p];
+      const float *const b = &reference.lab[3 * p];
+      const float delta_e = sqrtf ((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1])
+                                   + (a[2] - b[2]) * (a[2] - b[2]));
+      worst = fmaxf (worst, delta_e);
+      different[p] = delta_e > tolerance;
+      count += different[p];
+    }
+
+  const double fraction = (double) count / (double) different.size ();
+  printf ("%.3f%% of pixels differ, max ΔE %.1f\n", 100 * fraction, worst);
+  if (diff_path)
+    diff_save (diff_path, image, different);
+  return fraction <= allowed ? MATCH : DIFFERENT;
+}
+
+//!@} end of group imgcompare
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <string>
+
+#include "jobs.h"
+#include "profiler.h"
+
+/*! @addtogroup jobs
+ * @{
+ * Work-stealing scheduler for the phases of a frame.
+ *
+ * A phase is a task over a range of items, nodes or models, split into chunks when
+ * it becomes ready; tasks form a graph through their dependencies. Each thread
+ * pushes the chunks it makes ready to the back of its own deque and pops from
+ * there, so related chunks tend to run where their data is already cached; a thread
+ * whose deque is empty steals from the front of another's, taking the oldest and so
+ * usually the largest share of work left. Workers sleep while every deque is empty.
+ *
+ * The thread calling job_graph_run works on the graph too, from queue 0, until it is
+ * done: with no workers at all graphs simply run on it. Only one thread at a time
+ * may run graphs.
+ *
+ * Graphs are allocated from the arena of the frame they run for, and the queues keep
+ * their storage once emptied, so running a graph allocates nothing.
+ */
+
+//! chunks a task is split into per thread, so threads finishing early have some to steal
+const unsigned int CHUNKS_PER_THREAD = 4;
+
+//! queue of the calling thread: 0 unless it is a worker
+static thread_local unsigned int globalJobQueue = 0;
+
+//! Workers to start by default: a core each, besides the GL and simulation threads.
+unsigned int job_system_default_workers ()
+{
+  const unsigned int cores = std::thread::hardware_concurrency ();
+  return cores > 2 ? cores - 2 : 0;
+}
+
+static void job_push (struct job_system &system, const struct job &job)
+{
+  struct job_queue &queue = *system.queues[globalJobQueue];
+  const std::lock_guard<std::mutex> lock (queue.mutex);
+  if (queue.front == queue.jobs.size ())
+    {
+      queue.jobs.clear ();
+      queue.front = 0;
+    }
+  queue.jobs.push_back (job);
+  system.queued.fetch_add (1, std::memory_order_release);
+}
+
+//! Takes the most recent job of the calling thread's queue, else steals the oldest of another.
+static bool job_next (struct job_system &system, struct job &job)
+{
+  const unsigned int queues = (unsigned int) system.queues.size ();
+  for (unsigned int q = 0; q < queues; ++q)
+    {
+      const bool own = q == 0;
+      struct job_queue &queue = *system.queues[(globalJobQueue + q) % queues];
+      const std::lock_guard<std::mutex> lock (queue.mutex);
+      if (queue.front == queue.jobs.size ())
+        continue;
+      if (own)
+        {
+          job = queue.jobs.back ();
+          queue.jobs.pop_back ();
+        }
+      else
+        job = queue.jobs[queue.front++];
+      system.queued.fetch_sub (1, std::memory_order_relaxed);
+      return true;
+    }
+  return false;
+}
+
+static void job_task_push (struct job_system &system, struct job_task *task);
+
+//! Releases the tasks waiting on one just done.
+static void job_task_done (struct job_system &system, struct job_task *const task)
+{
+  for (const struct job_edge *edge = task->dependents; edge; edge = edge->next)
+    if (edge->task->waiting.fetch_sub (1, std::memory_order_acq_rel) == 1)
+      job_task_push (system, edge->task);
+  // after its dependents are queued, so the graph is never seen done too early
+  task->graph->unfinished.fetch_sub (1, std::memory_order_acq_rel);
+}
+
+//! Splits a ready task into chunks and queues them, waking workers to steal them.
+static void job_task_push (struct job_system &system, struct job_task *const task)
+{
+  if (!task->count)
+    {
+      job_task_done (system, task);
+      return;
+    }
+  const unsigned int chunks_wanted = CHUNKS_PER_THREAD * (unsigned int) system.queues.size ();
+  const unsigned int size = std::max (task->grain, (task->count + chunks_wanted - 1) / chunks_wanted);
+  const unsigned int chunks = (task->count + size - 1) / size;
+  task->remaining.store (chunks, std::memory_order_relaxed);
+  for (unsigned int c = 0; c < chunks; ++c)
+    job_push (system, {task, c * size, std::min (task->count, (c + 1) * size)});
+
+  if (system.workers.empty ())
+    return;
+  // a worker checking for jobs under the lock either sees them or is waiting already
+  {
+    const std::lock_guard<std::mutex> lock (system.sleep_mutex);
+  }
+  if (chunks > 1)
+    system.wake.notify_all ();
+  else
+    system.wake.notify_one ();
+}
+
+static void job_execute (struct job_system &system, const struct job &job)
+{
+  struct job_task *const task = job.task;
+  {
+    profiler_scope scope (task->name);
+    task->function (task->data, job.begin, job.end);
+  }
+  if (task->remaining.fetch_sub (1, std::memory_order_acq_rel) == 1)
+    job_task_done (system, task);
+}
+
+static void job_worker (struct job_system &system, const unsigned int queue)
+{
+  globalJobQueue = queue;
+  const std::string name = "jobs " + std::to_string (queue);
+  profiler_thread (name.c_str ());
+  for (;;)
+    {
+      struct job job;
+      if (job_next (system, job))
+        {
+          job_execute (system, job);
+          continue;
+        }
+      std::unique_lock<std::mutex> lock (system.sleep_mutex);
+      system.wake.wait (lock, [&system]
+      {
+        return system.quit || system.queued.load (std::memory_order_acquire) > 0;
+      });
+      if (system.quit)
+        return;
+    }
+}
+
+//! @param[in] workers threads to start, besides the one running graphs.
+void job_system_start (struct job_system &system, const unsigned int workers)
+{
+  for (unsigned int q = 0; q <= workers; ++q)
+    system.queues.push_back (std::make_unique<struct job_queue> ());
+  for (unsigned int w = 1; w <= workers; ++w)
+    system.workers.emplace_back (job_worker, std::ref (system), w);
+}
+
+//! Joins the workers, once no graph is running.
+void job_system_stop (struct job_system &system)
+{
+  {
+    const std::lock_guard<std::mutex> lock (system.sleep_mutex);
+    system.quit = true;
+  }
+  system.wake.notify_all ();
+  // a worker exiting the program stops them from its own thread, which cannot join itself
+  for (auto &worker: system.workers)
+    if (worker.get_id () == std::this_thread::get_id ())
+      worker.detach ();
+    else
+      worker.join ();
+  system.workers.clear ();
+}
+
+/*!
+ * Adds a task to a graph, to run once the tasks given with job_graph_depend are done.
+ * @param[in] function called on chunks of [0, count), from any thread and concurrently.
+ * @param[in] grain items per chunk at least, for items too cheap to be worth a job each.
+ */
+struct job_task *job_graph_add (struct job_graph &graph, const char *const name, const job_function function,
+                                void *const data, const unsigned int count, const unsigned int grain)
+{
+  struct job_task *const task = arena_new<struct job_task> (*graph.arena);
+  task->name = name;
+  task->function = function;
+  task->data = data;
+  task->count = count;
+  task->grain = std::max (grain, 1u);
+  task->graph = &graph;
+  if (graph.last)
+    graph.last->next = task;
+  else
+    graph.first = task;
+  graph.last = task;
+  ++graph.tasks;
+  return task;
+}
+
+//! Has a task wait for another of the same graph.
+void job_graph_depend (struct job_task *const task, struct job_task *const on)
+{
+  on->dependents = arena_new<struct job_edge> (*task->graph->arena, job_edge{task, on->dependents});
+  task->waiting.fetch_add (1, std::memory_order_relaxed);
+}
+
+//! Runs every task of a graph in dependency order, the calling thread working on them too until all are done.
+void job_graph_run (struct job_system &system, struct job_graph &graph)
+{
+  graph.unfinished.store (graph.tasks, std::memory_order_relaxed);
+  // the roots are found first, as workers may release other tasks as soon as one is pushed
+  for (struct job_task *task = graph.first; task; task = task->next)
+    task->root = !task->waiting.load (std::memory_order_relaxed);
+  for (struct job_task *task = graph.first; task; task = task->next)
+    if (task->root)
+      job_task_push (system, task);
+
+  while (graph.unfinished.load (std::memory_order_acquire))
+    {
+      struct job job;
+      if (job_next (system, job))
+        job_execute (system, job);
+      else
+        // the last chunks are running elsewhere
+        std::this_thread::yield ();
+    }
+}
+
+//! Runs a function over [0, count) in chunks across the threads, returning once all are done.
+void job_parallel_for (struct job_system &system, struct frame_arena &arena, const char *const name,
+                       const job_function function, void *const data, const unsigned int count,
+                       const unsigned int grain)
+{
+  struct job_graph graph;
+  graph.arena = &arena;
+  job_graph_add (graph, name, function, data, count, grain);
+  job_graph_run (system, graph);
+}
+
+//!@} end of group jobs
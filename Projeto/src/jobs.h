@@ -0,0 +1,77 @@
+#ifndef _JOBS_H_
+#define _JOBS_H_
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "arena.h"
+
+//! Runs over the items [begin, end) of its task.
+typedef void (*job_function) (void *data, unsigned int begin, unsigned int end);
+
+//! Node of a job graph: a function over a range of items, run in chunks once the tasks it depends on are done.
+struct job_task {
+  const char *name = nullptr; // static string, the span of each chunk in the profile
+  job_function function = nullptr;
+  void *data = nullptr;
+  unsigned int count = 0;     // items
+  unsigned int grain = 1;     // items per chunk, at least
+  struct job_graph *graph = nullptr;
+  struct job_task *next = nullptr;        // in its graph
+  struct job_edge *dependents = nullptr;
+  bool root = false;                      // depends on no task, found before any is run
+  std::atomic<unsigned int> waiting{0};   // tasks it depends on not done yet
+  std::atomic<unsigned int> remaining{0}; // chunks not done yet
+};
+
+//! Task to release once another is done.
+struct job_edge {
+  struct job_task *task;
+  struct job_edge *next;
+};
+
+//! Chunk of a task, what the queues hold.
+struct job {
+  struct job_task *task = nullptr;
+  unsigned int begin = 0;
+  unsigned int end = 0;
+};
+
+//! Deque of one thread: its owner pushes and pops at the back, the others steal from the front.
+struct job_queue {
+  std::mutex mutex;
+  std::vector<struct job> jobs; // kept allocated once emptied
+  size_t front = 0;             // first job not stolen yet
+};
+
+//! Tasks of a frame and their dependencies, run together by job_graph_run.
+struct job_graph {
+  struct frame_arena *arena = nullptr; // the tasks live in, until it is reset
+  struct job_task *first = nullptr;
+  struct job_task *last = nullptr;
+  unsigned int tasks = 0;
+  std::atomic<unsigned int> unfinished{0};
+};
+
+//! Worker threads, each with its queue, plus one queue for the thread running graphs.
+struct job_system {
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<struct job_queue>> queues; // [0] for the thread running graphs, then by worker
+  std::atomic<unsigned int> queued{0};                   // jobs in every queue, workers sleeping while none is
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  bool quit = false;                                     // guarded by sleep_mutex
+};
+
+unsigned int job_system_default_workers ();
+void job_system_start (struct job_system &system, unsigned int workers);
+void job_system_stop (struct job_system &system);
+struct job_task *job_graph_add (struct job_graph &graph, const char *name, job_function function, void *data,
+                                unsigned int count, unsigned int grain = 1);
+void job_graph_depend (struct job_task *task, struct job_task *on);
+void job_graph_run (struct job_system &system, struct job_graph &graph);
+void job_parallel_for (struct job_system &system, struct frame_arena &arena, const char *name,
+                       job_function function, void *data, unsigned int count, unsigned int grain = 1);
+#endif //_JOBS_H_
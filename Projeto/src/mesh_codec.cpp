@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "mesh_codec.h"
+
+using std::vector;
+
+/*! @addtogroup meshCodec
+ * @{
+ * Lossless codecs of vertex and index streams, in the manner of meshoptimizer's,
+ * which leave the bytes much more compressible by a general purpose compressor.
+ *
+ * Meshes are indexed first, identical vertices of the triangles being stored once,
+ * in the order they are first used. Indices are then mostly the next vertex not
+ * used yet, or one used shortly before, and are coded as such in a byte or two.
+ *
+ * Vertices are coded a block of up to 256 at a time, byte by byte of their stride:
+ * each byte as its difference to the same byte of the previous vertex, zigzagged so
+ * small differences either way are small numbers. Differences are packed in groups
+ * of 16, in 0, 2, 4 or 8 bits each as the largest needs, told by 2 bits per group
+ * ahead of them:
+ *
+ * @code{.unparsed}
+ * block     per byte of the stride: headers, ⌈groups / 4⌉ bytes, then the groups
+ * group     16 differences of 0, 2, 4 or 8 bits, from the lowest bits of the first byte up
+ * @endcode
+ *
+ * The decoder unpacks a group, undoes the zigzag and sums the differences in a few
+ * SSE2 instructions, then interleaves the bytes of a block back into its vertices
+ * words at a time, so it is not far behind a copy of the floats it decodes into.
+ */
+
+//! vertices of a block at most, and the bytes of the block at most, so it is decoded in the L1 cache
+const size_t MESH_BLOCK_VERTICES = 256;
+const size_t MESH_BLOCK_BYTES = 8192;
+const size_t MESH_GROUP = 16;
+
+static size_t mesh_block_vertices (const size_t stride)
+{
+  const size_t vertices = std::min (MESH_BLOCK_VERTICES, MESH_BLOCK_BYTES / std::max<size_t> (stride, 1));
+  return std::max (MESH_GROUP, vertices & ~(MESH_GROUP - 1));
+}
+
+/*!
+ * Indexes the vertices given as streams of attributes, two vertices being the same
+ * when every attribute is, byte for byte.
+ * @param[out] indices the vertex each vertex is, of the unique ones.
+ * @param[out] unique the first of the vertices each unique one is, in order.
+ */
+void mesh_deduplicate (const vector<struct mesh_stream> &streams, const size_t count,
+                       vector<uint32_t> &indices, vector<uint32_t> &unique)
+{
+  // open addressing, the table at most half full
+  size_t buckets = 16;
+  while (buckets < 2 * count)
+    buckets *= 2;
+  const uint32_t EMPTY = ~0u;
+  vector<uint32_t> table (buckets, EMPTY);
+  indices.resize (count);
+  unique.clear ();
+
+  const auto equal = [&streams] (const size_t a, const size_t b)
+  {
+    for (const struct mesh_stream &stream: streams)
+      if (memcmp (stream.data + a * stream.stride, stream.data + b * stream.stride, stream.stride))
+        return false;
+    return true;
+  };
+  for (size_t v = 0; v < count; ++v)
+    {
+      // FNV-1a
+      uint64_t hash = 14695981039346656037ull;
+      for (const struct mesh_stream &stream: streams)
+        for (size_t b = 0; b < stream.stride; ++b)
+          hash = (hash ^ stream.data[v * stream.stride + b]) * 1099511628211ull;
+      size_t bucket = (size_t) (hash ^ (hash >> 32)) & (buckets - 1);
+      while (table[bucket] != EMPTY && !equal (unique[table[bucket]], v))
+        bucket = (bucket + 1) & (buckets - 1);
+      if (table[bucket] == EMPTY)
+        {
+          table[bucket] = (uint32_t) unique.size ();
+          unique.push_back ((uint32_t) v);
+        }
+      indices[v] = table[bucket];
+    }
+}
+
+static uint8_t mesh_zigzag (const uint8_t delta)
+{
+  return (uint8_t) ((delta << 1) ^ (uint8_t) ((int8_t) delta >> 7));
+}
+
+//! bits of each group size code
+static const unsigned int MESH_GROUP_BITS[4] = {0, 2, 4, 8};
+
+static void mesh_encode_group (const uint8_t *const values, const unsigned int bits, vector<uint8_t> &out)
+{
+  if (bits == 8)
+    out.insert (out.end (), values, values + MESH_GROUP);
+  else if (bits)
+    {
+      const unsigned int per_byte = 8 / bits;
+      for (size_t i = 0; i < MESH_GROUP; i += per_byte)
+        {
+          uint8_t byte = 0;
+          for (unsigned int j = 0; j < per_byte; ++j)
+            byte |= (uint8_t) (values[i + j] << (j * bits));
+          out.push_back (byte);
+        }
+    }
+}
+
+//! @param[in] stride bytes of a vertex, the codec being for any.
+void mesh_encode_vertices (const uint8_t *const vertices, const size_t count, const size_t stride,
+                           vector<uint8_t> &out)
+{
+  const size_t block_vertices = mesh_block_vertices (stride);
+  vector<uint8_t> previous (stride, 0);
+  uint8_t values[MESH_GROUP];
+  for (size_t begin = 0; begin < count; begin += block_vertices)
+    {
+      const size_t end = std::min (count, begin + block_vertices);
+      const size_t groups = (end - begin + MESH_GROUP - 1) / MESH_GROUP;
+      for (size_t k = 0; k < stride; ++k)
+        {
+          const size_t headers = out.size ();
+          out.resize (out.size () + (groups + 3) / 4, 0);
+          uint8_t last = previous[k];
+          for (size_t g = 0; g < groups; ++g)
+            {
+              uint8_t largest = 0;
+              for (size_t i = 0; i < MESH_GROUP; ++i)
+                {
+                  const size_t v = begin + g * MESH_GROUP + i;
+                  // the end of the last group repeats the last vertex, its differences being 0
+                  const uint8_t byte = v < end ? vertices[v * stride + k] : last;
+                  values[i] = mesh_zigzag ((uint8_t) (byte - last));
+                  largest = std::max (largest, values[i]);
+                  last = byte;
+                }
+              const unsigned int code = largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+              out[headers + g / 4] |= (uint8_t) (code << (2 * (g % 4)));
+              mesh_encode_group (values, MESH_GROUP_BITS[code], out);
+            }
+        }
+      memcpy (previous.data (), vertices + (end - 1) * stride, stride);
+    }
+}
+
+#ifdef __SSE2__
+//! Every byte of the register its last.
+static inline __m128i mesh_broadcast_last (const __m128i x)
+{
+  const __m128i high = _mm_unpackhi_epi8 (x, x);
+  const __m128i last = _mm_shufflehi_epi16 (high, 0xFF);
+  return _mm_unpackhi_epi64 (last, last);
+}
+#endif
+
+/*!
+ * Decodes the headers and groups of a byte of the stride, of a block, adding the
+ * differences up from the same byte of the vertex before.
+ * @param[in,out] data past what was read.
+ * @param[in,out] last the byte of the vertex before, then of the last vertex.
+ * @param[out] lane the byte of each vertex, rounded up to whole groups.
+ * @return whether there were so many bytes.
+ */
+static bool mesh_decode_lane (const uint8_t *&data, size_t &size, const size_t groups, uint8_t &last,
+                              uint8_t *const lane)
+{
+  const uint8_t *const headers = data;
+  size_t read = (groups + 3) / 4;
+  if (read > size)
+    return false;
+#ifdef __SSE2__
+  // the running byte is kept in every byte of a register, the groups depending on nothing else
+  __m128i previous = _mm_set1_epi8 ((char) last);
+  const __m128i mask2 = _mm_set1_epi8 (0x03), mask4 = _mm_set1_epi8 (0x0F);
+  const __m128i one = _mm_set1_epi8 (1), low7 = _mm_set1_epi8 (0x7F);
+  for (size_t g = 0; g < groups; ++g)
+    {
+      const unsigned int code = (headers[g / 4] >> (2 * (g % 4))) & 3;
+      const size_t bytes = MESH_GROUP_BITS[code] * MESH_GROUP / 8;
+      if (read + bytes > size)
+        return false;
+      const uint8_t *const group = data + read;
+      read += bytes;
+      __m128i z;
+      switch (code)
+        {
+          case 0:
+            _mm_storeu_si128 ((__m128i *) (lane + g * MESH_GROUP), previous);
+            continue;
+          case 1:
+            {
+              int32_t word;
+              memcpy (&word, group, sizeof (word));
+              const __m128i packed = _mm_cvtsi32_si128 (word);
+              const __m128i a0 = _mm_and_si128 (packed, mask2);
+              const __m128i a1 = _mm_and_si128 (_mm_srli_epi16 (packed, 2), mask2);
+              const __m128i a2 = _mm_and_si128 (_mm_srli_epi16 (packed, 4), mask2);
+              const __m128i a3 = _mm_and_si128 (_mm_srli_epi16 (packed, 6), mask2);
+              z = _mm_unpacklo_epi16 (_mm_unpacklo_epi8 (a0, a1), _mm_unpacklo_epi8 (a2, a3));
+              break;
+            }
+          case 2:
+            {
+              const __m128i packed = _mm_loadl_epi64 ((const __m128i *) group);
+              z = _mm_unpacklo_epi8 (_mm_and_si128 (packed, mask4), _mm_and_si128 (_mm_srli_epi16 (packed, 4), mask4));
+              break;
+            }
+          default:
+            z = _mm_loadu_si128 ((const __m128i *) group);
+        }
+      // unzigzag, (z >> 1) ^ -(z & 1), then the prefix sum of the differences
+      __m128i x = _mm_xor_si128 (_mm_and_si128 (_mm_srli_epi16 (z, 1), low7),
+                                 _mm_sub_epi8 (_mm_setzero_si128 (), _mm_and_si128 (z, one)));
+      x = _mm_add_epi8 (x, _mm_slli_si128 (x, 1));
+      x = _mm_add_epi8 (x, _mm_slli_si128 (x, 2));
+      x = _mm_add_epi8 (x, _mm_slli_si128 (x, 4));
+      x = _mm_add_epi8 (x, _mm_slli_si128 (x, 8));
+      x = _mm_add_epi8 (x, previous);
+      _mm_storeu_si128 ((__m128i *) (lane + g * MESH_GROUP), x);
+      previous = mesh_broadcast_last (x);
+    }
+  last = (uint8_t) _mm_cvtsi128_si32 (previous);
+#else
+  for (size_t g = 0; g < groups; ++g)
+    {
+      const unsigned int code = (headers[g / 4] >> (2 * (g % 4))) & 3;
+      const unsigned int bits = MESH_GROUP_BITS[code];
+      if (read + bits * MESH_GROUP / 8 > size)
+        return false;
+      const uint8_t *const group = data + read;
+      read += bits * MESH_GROUP / 8;
+      uint8_t *const bytes = lane + g * MESH_GROUP;
+      if (!bits)
+        {
+          memset (bytes, last, MESH_GROUP);
+          continue;
+        }
+      const unsigned int per_byte = 8 / bits;
+      const uint8_t mask = (uint8_t) ((1u << bits) - 1);
+      for (size_t i = 0; i < MESH_GROUP; ++i)
+        {
+          const uint8_t z = (uint8_t) ((group[i / per_byte] >> ((i % per_byte) * bits)) & mask);
+          last = (uint8_t) (last + ((z >> 1) ^ (uint8_t) -(z & 1)));
+          bytes[i] = last;
+        }
+    }
+#endif
+  data += read;
+  size -= read;
+  return true;
+}
+
+/*!
+ * Interleaves the lanes of a block into its vertices. With SSE2, and strides of
+ * pairs of bytes as those of the models are, 16 vertices at a time: their bytes of
+ * 2 or 4 lanes at once are unpacked into the words each vertex has of them, stored
+ * a word at a time, instead of a byte.
+ */
+static void mesh_transpose (const uint8_t *const lanes, const size_t lane_size, const size_t count,
+                            const size_t stride, uint8_t *const vertices)
+{
+  size_t v = 0;
+#ifdef __SSE2__
+  if (stride % 2 == 0)
+    for (; v + MESH_GROUP <= count; v += MESH_GROUP)
+      {
+        uint8_t *const out = vertices + v * stride;
+        size_t k = 0;
+        for (; k + 4 <= stride; k += 4)
+          {
+            const uint8_t *const lane = lanes + k * lane_size + v;
+            const __m128i b0 = _mm_loadu_si128 ((const __m128i *) lane);
+            const __m128i b1 = _mm_loadu_si128 ((const __m128i *) (lane + lane_size));
+            const __m128i b2 = _mm_loadu_si128 ((const __m128i *) (lane + 2 * lane_size));
+            const __m128i b3 = _mm_loadu_si128 ((const __m128i *) (lane + 3 * lane_size));
+            const __m128i low01 = _mm_unpacklo_epi8 (b0, b1), high01 = _mm_unpackhi_epi8 (b0, b1);
+            const __m128i low23 = _mm_unpacklo_epi8 (b2, b3), high23 = _mm_unpackhi_epi8 (b2, b3);
+            uint32_t words[MESH_GROUP];
+            _mm_storeu_si128 ((__m128i *) words, _mm_unpacklo_epi16 (low01, low23));
+            _mm_storeu_si128 ((__m128i *) (words + 4), _mm_unpackhi_epi16 (low01, low23));
+            _mm_storeu_si128 ((__m128i *) (words + 8), _mm_unpacklo_epi16 (high01, high23));
+            _mm_storeu_si128 ((__m128i *) (words + 12), _mm_unpackhi_epi16 (high01, high23));
+            for (size_t i = 0; i < MESH_GROUP; ++i)
+              memcpy (out + i * stride + k, &words[i], sizeof (words[i]));
+          }
+        if (k < stride)
+          {
+            const uint8_t *const lane = lanes + k * lane_size + v;
+            const __m128i b0 = _mm_loadu_si128 ((const __m128i *) lane);
+            const __m128i b1 = _mm_loadu_si128 ((const __m128i *) (lane + lane_size));
+            uint16_t words[MESH_GROUP];
+            _mm_storeu_si128 ((__m128i *) words, _mm_unpacklo_epi8 (b0, b1));
+            _mm_storeu_si128 ((__m128i *) (words + 8), _mm_unpackhi_epi8 (b0, b1));
+            for (size_t i = 0; i < MESH_GROUP; ++i)
+              memcpy (out + i * stride + k, &words[i], sizeof (words[i]));
+          }
+      }
+#endif
+  for (; v < count; ++v)
+    for (size_t k = 0; k < stride; ++k)
+      vertices[v * stride + k] = lanes[k * lane_size + v];
+}
+
+/*!
+ * @param[out] vertices count of stride bytes.
+ * @return whether the data held them all.
+ */
+bool mesh_decode_vertices (const uint8_t *data, size_t size, const size_t count, const size_t stride,
+                           uint8_t *const vertices)
+{
+  const size_t block_vertices = mesh_block_vertices (stride);
+  // the block decoded byte by byte of the stride, transposed into the vertices once whole
+  vector<uint8_t> lanes (block_vertices * stride);
+  vector<uint8_t> previous (stride, 0);
+  for (size_t begin = 0; begin < count; begin += block_vertices)
+    {
+      const size_t block = std::min (count - begin, block_vertices);
+      const size_t groups = (block + MESH_GROUP - 1) / MESH_GROUP;
+      for (size_t k = 0; k < stride; ++k)
+        if (!mesh_decode_lane (data, size, groups, previous[k], lanes.data () + k * block_vertices))
+          return false;
+      mesh_transpose (lanes.data (), block_vertices, block, stride, vertices + begin * stride);
+    }
+  return true;
+}
+
+static void mesh_encode_varint (uint32_t value, vector<uint8_t> &out)
+{
+  while (value >= 0x80)
+    {
+      out.push_back ((uint8_t) (value | 0x80));
+      value >>= 7;
+    }
+  out.push_back ((uint8_t) value);
+}
+
+//! Of vertices indexed in the order they are first used, as mesh_deduplicate leaves them.
+void mesh_encode_indices (const uint32_t *const indices, const size_t count, vector<uint8_t> &out)
+{
+  uint32_t next = 0, last = 0;
+  for (size_t i = 0; i < count; ++i)
+    {
+      const uint32_t index = indices[i];
+      if (index == next)
+        {
+          // the next vertex not used yet
+          out.push_back (0);
+          ++next;
+        }
+      else
+        {
+          const int32_t delta = (int32_t) (index - last);
+          mesh_encode_varint ((((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31)) + 1, out);
+          next = std::max (next, index + 1);
+        }
+      last = index;
+    }
+}
+
+//! @return whether the data held them all, each less than vertex_count.
+bool mesh_decode_indices (const uint8_t *const data, const size_t size, const size_t count,
+                          const uint32_t vertex_count, uint32_t *const indices)
+{
+  size_t read = 0;
+  uint32_t next = 0, last = 0;
+  for (size_t i = 0; i < count; ++i)
+    {
+      if (read == size)
+        return false;
+      uint32_t code = data[read++];
+      if (code & 0x80)
+        {
+          code &= 0x7F;
+          for (unsigned int shift = 7;; shift += 7)
+            {
+              if (read == size || shift > 28)
+                return false;
+              const uint8_t byte = data[read++];
+              code |= (uint32_t) (byte & 0x7F) << shift;
+              if (!(byte & 0x80))
+                break;
+            }
+        }
+      // without branching on which it is, as there is no telling
+      const uint32_t zigzag = code - 1;
+      const uint32_t index = code ? last + ((zigzag >> 1) ^ -(zigzag & 1)) : next;
+      next = std::max (next, index + 1);
+      if (index >= vertex_count)
+        return false;
+      indices[i] = last = index;
+    }
+  return true;
+}
+
+//! @} end of group meshCodec
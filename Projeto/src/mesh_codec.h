@@ -0,0 +1,19 @@
+#ifndef _MESH_CODEC_H_
+#define _MESH_CODEC_H_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! An attribute of the vertices: their stride bytes each, one after another.
+struct mesh_stream {
+  const uint8_t *data;
+  size_t stride;
+};
+
+void mesh_deduplicate (const std::vector<struct mesh_stream> &streams, size_t count,
+                       std::vector<uint32_t> &indices, std::vector<uint32_t> &unique);
+void mesh_encode_vertices (const uint8_t *vertices, size_t count, size_t stride, std::vector<uint8_t> &out);
+bool mesh_decode_vertices (const uint8_t *data, size_t size, size_t count, size_t stride, uint8_t *vertices);
+void mesh_encode_indices (const uint32_t *indices, size_t count, std::vector<uint8_t> &out);
+bool mesh_decode_indices (const uint8_t *data, size_t size, size_t count, uint32_t vertex_count, uint32_t *indices);
+#endif //_MESH_CODEC_H_
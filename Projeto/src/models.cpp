@@ -0,0 +1,1801 @@
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "curves.h"
+#include "mesh_codec.h"
+#include "models.h"
+
+using glm::mat4, glm::vec4, glm::vec3, glm::vec2, glm::mat4x3;
+using glm::normalize, glm::cross;
+
+using std::vector, std::array;
+
+using std::string, std::ifstream, std::ios;
+using std::cerr, std::endl;
+
+/*! @addtogroup generator
+* @{*/
+
+struct baseModel {
+  int nVertices;
+  float *vertices;
+  float *normals;
+  float *texture_coordinates;
+};
+
+/*! @addtogroup points
+ * @{*/
+void points_vertex (const float x, const float y, const float z, unsigned int *pos, float points[])
+{
+  points[*pos] = x;
+  points[*pos + 1] = y;
+  points[*pos + 2] = z;
+  *pos += 3;
+}
+
+void points_write (const char *filename, const unsigned int nVertices, const float points[])
+{
+  FILE *fp = fopen (filename, "w");
+  if (!fp)
+    {
+      fprintf (stderr, "failed to open file: %s", filename);
+      exit (1);
+    }
+
+  fwrite (&nVertices, sizeof (unsigned int), 1, fp);
+  fwrite (points, 3 * sizeof (float), nVertices, fp);
+
+  fclose (fp);
+}
+
+struct model_encoding globalModelEncoding;
+
+/*! @addtogroup quantization
+ * @{
+ * Models written quantized (generator -q) take 12 to 14 bytes per vertex instead
+ * of 32, on disk and on the GPU, which reads them as they are:
+ *
+ * @code{.unparsed}
+ * int32    MODEL_QUANTIZED, where the vertex count of floats is
+ * int32    number of vertices
+ * int32    bits of each normal component, 16 or 8
+ * float[3] offset, float[3] scale of the positions
+ * uint16[3] per vertex: position, (p - offset) / scale * 65535 rounded
+ * int16[2] or int8[2] per vertex: normal, octahedral, signed normalized
+ * uint16[2] per vertex: texture coordinates, half floats
+ * @endcode
+ *
+ * The positions are off by about 1/131070 of the bounds along each axis at most,
+ * the normals by hundredths of a degree with 16 bits and about a degree with 8.
+ */
+
+//! Projection of a unit vector on the octahedron, unfolded onto [-1, 1]², far more even to quantize than its coordinates.
+static vec2 octahedral_encode (const vec3 n)
+{
+  const float l1 = fabsf (n.x) + fabsf (n.y) + fabsf (n.z);
+  if (l1 == 0)
+    return vec2 (0, 0);
+  const vec2 p (n.x / l1, n.y / l1);
+  if (n.z >= 0)
+    return p;
+  // the lower half folds over the diagonals
+  return vec2 ((1 - fabsf (p.y)) * (p.x >= 0 ? 1.0f : -1.0f), (1 - fabsf (p.x)) * (p.y >= 0 ? 1.0f : -1.0f));
+}
+
+static vec3 octahedral_decode (const vec2 e)
+{
+  vec3 n (e.x, e.y, 1 - fabsf (e.x) - fabsf (e.y));
+  const float t = fmaxf (-n.z, 0);
+  n.x += n.x >= 0 ? -t : t;
+  n.y += n.y >= 0 ? -t : t;
+  return normalize (n);
+}
+
+//! Largest value of a signed normalized integer of the bits, standing for 1.
+static float snorm_max (const unsigned int bits)
+{
+  return (float) ((1 << (bits - 1)) - 1);
+}
+
+void model_quantize (const vector<vec3> &vertices, const vector<vec3> &normals, const vector<vec2> &texture,
+                     const unsigned int normal_bits, struct model_quantized &quantized)
+{
+  const size_t nVertices = vertices.size ();
+  quantized.nVertices = (unsigned int) nVertices;
+  quantized.normal_bits = normal_bits;
+  vec3 min (0, 0, 0), max (0, 0, 0);
+  if (nVertices)
+    min = max = vertices[0];
+  for (const vec3 &vertex: vertices)
+    {
+      min = glm::min (min, vertex);
+      max = glm::max (max, vertex);
+    }
+  quantized.offset = min;
+  quantized.scale = max - min;
+
+  quantized.positions.resize (3 * nVertices);
+  for (size_t v = 0; v < nVertices; ++v)
+    for (int c = 0; c < 3; ++c)
+      quantized.positions[3 * v + c] = quantized.scale[c] > 0
+                                       ? (uint16_t) lroundf ((vertices[v][c] - min[c]) / quantized.scale[c] * 65535)
+                                       : 0;
+
+  const size_t normal_bytes = normal_bits / 8;
+  const float normal_max = snorm_max (normal_bits);
+  quantized.normals.resize (2 * normal_bytes * nVertices);
+  for (size_t v = 0; v < nVertices; ++v)
+    {
+      const vec2 e = octahedral_encode (v < normals.size () ? normals[v] : vec3 (0, 0, 1));
+      const int16_t q[2] = {(int16_t) lroundf (glm::clamp (e.x, -1.0f, 1.0f) * normal_max),
+                            (int16_t) lroundf (glm::clamp (e.y, -1.0f, 1.0f) * normal_max)};
+      for (int c = 0; c < 2; ++c)
+        if (normal_bytes == 2)
+          memcpy (&quantized.normals[(2 * v + c) * 2], &q[c], 2);
+        else
+          quantized.normals[2 * v + c] = (int8_t) q[c];
+    }
+
+  quantized.texture.resize (2 * nVertices);
+  for (size_t v = 0; v < nVertices; ++v)
+    {
+      const vec2 uv = v < texture.size () ? texture[v] : vec2 (0, 0);
+      quantized.texture[2 * v] = glm::packHalf1x16 (uv.x);
+      quantized.texture[2 * v + 1] = glm::packHalf1x16 (uv.y);
+    }
+}
+
+//! Only the positions, which the bounds of a model are computed from.
+void model_dequantize_positions (const struct model_quantized &quantized, vector<vec3> &vertices)
+{
+  vertices.resize (quantized.nVertices);
+  const vec3 step = quantized.scale / 65535.0f;
+  for (size_t v = 0; v < quantized.nVertices; ++v)
+    vertices[v] = quantized.offset + step * vec3 (quantized.positions[3 * v], quantized.positions[3 * v + 1],
+                                                  quantized.positions[3 * v + 2]);
+}
+
+//! As the vertex stage dequantizes them.
+void model_dequantize (const struct model_quantized &quantized,
+                       vector<vec3> &vertices, vector<vec3> &normals, vector<vec2> &texture)
+{
+  model_dequantize_positions (quantized, vertices);
+  const size_t normal_bytes = quantized.normal_bits / 8;
+  const float normal_max = snorm_max (quantized.normal_bits);
+  normals.resize (quantized.nVertices);
+  texture.resize (quantized.nVertices);
+  for (size_t v = 0; v < quantized.nVertices; ++v)
+    {
+      int16_t q[2];
+      for (int c = 0; c < 2; ++c)
+        if (normal_bytes == 2)
+          memcpy (&q[c], &quantized.normals[(2 * v + c) * 2], 2);
+        else
+          q[c] = quantized.normals[2 * v + c];
+      normals[v] = octahedral_decode (vec2 (fmaxf (q[0] / normal_max, -1), fmaxf (q[1] / normal_max, -1)));
+      texture[v] = vec2 (glm::unpackHalf1x16 (quantized.texture[2 * v]),
+                         glm::unpackHalf1x16 (quantized.texture[2 * v + 1]));
+    }
+}
+
+static void model_write_quantized (FILE *const fp, const char *const filename,
+                                   const vector<vec3> &vertices,
+                                   const vector<vec3> &normals,
+                                   const vector<vec2> &texture)
+{
+  struct model_quantized quantized;
+  model_quantize (vertices, normals, texture, globalModelEncoding.normal_bits, quantized);
+  const int header[3] = {MODEL_QUANTIZED, (int) quantized.nVertices, (int) quantized.normal_bits};
+  fwrite (header, sizeof (header[0]), 3, fp);
+  fwrite (&quantized.offset, sizeof (quantized.offset), 1, fp);
+  fwrite (&quantized.scale, sizeof (quantized.scale), 1, fp);
+  fwrite (quantized.positions.data (), sizeof (quantized.positions[0]), quantized.positions.size (), fp);
+  fwrite (quantized.normals.data (), sizeof (quantized.normals[0]), quantized.normals.size (), fp);
+  fwrite (quantized.texture.data (), sizeof (quantized.texture[0]), quantized.texture.size (), fp);
+  fclose (fp);
+
+  cerr << "[generator] Wrote "
+       << quantized.nVertices << " vertices quantized, normals of "
+       << quantized.normal_bits << " bits, to "
+       << filename << endl;
+}
+
+//! Reads what follows the tag of a quantized model, exiting when it is truncated.
+static void model_read_quantized (FILE *const fp, const char *const filename, struct model_quantized &quantized)
+{
+  int header[2];
+  if (fread (header, sizeof (header[0]), 2, fp) != 2 || header[0] < 0 || (header[1] != 16 && header[1] != 8)
+      || fread (&quantized.offset, sizeof (quantized.offset), 1, fp) != 1
+      || fread (&quantized.scale, sizeof (quantized.scale), 1, fp) != 1)
+    {
+      cerr << "failed reading the header of quantized model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  quantized.nVertices = (unsigned int) header[0];
+  quantized.normal_bits = (unsigned int) header[1];
+  quantized.positions.resize (3 * (size_t) quantized.nVertices);
+  quantized.normals.resize (2 * (size_t) quantized.nVertices * quantized.normal_bits / 8);
+  quantized.texture.resize (2 * (size_t) quantized.nVertices);
+  if (fread (quantized.positions.data (), sizeof (quantized.positions[0]), quantized.positions.size (), fp)
+      != quantized.positions.size ()
+      || fread (quantized.normals.data (), sizeof (quantized.normals[0]), quantized.normals.size (), fp)
+         != quantized.normals.size ()
+      || fread (quantized.texture.data (), sizeof (quantized.texture[0]), quantized.texture.size (), fp)
+         != quantized.texture.size ())
+    {
+      cerr << "truncated quantized model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+}
+
+//! @} end of group quantization
+
+/*! @addtogroup compression
+ * @{
+ * Models written compressed (generator -c, or -z to follow with zstd) are indexed
+ * and their index and vertex streams coded with mesh_codec, which the spheres,
+ * cones and patches of the generator, each vertex shared by about six triangles,
+ * take a fraction of the bytes of floats in, quantized or not:
+ *
+ * @code{.unparsed}
+ * model_compressed_header
+ * indices, then positions, normals and texture coordinates of the unique vertices,
+ * each coded, together compressed with zstd when the header says so
+ * @endcode
+ *
+ * They are read back as triangles, the vertices of each being copied out of the
+ * unique ones, so the engine draws them as any other.
+ */
+
+//! zstd level, the files being written once and read many times
+const int MODEL_ZSTD_LEVEL = 19;
+
+//! Header of compressed models, all of 4 bytes fields.
+struct model_compressed_header {
+  int32_t tag = MODEL_COMPRESSED;
+  int32_t normal_bits = 0;             // of quantized attributes, 0 for floats
+  float offset[3] = {}, scale[3] = {}; // of quantized positions
+  uint32_t nVertices = 0;              // of the triangles
+  uint32_t nUnique = 0;                // vertices
+  uint32_t zstd = 0;                   // whether the streams are compressed with zstd
+  uint32_t sizes[4] = {};              // of the index, position, normal and texture coordinate streams, coded
+  uint32_t stored = 0;                 // bytes following the header
+};
+
+//! Strides of the attributes of a vertex, floats or quantized.
+static void model_compressed_strides (const unsigned int normal_bits, size_t strides[3])
+{
+  strides[0] = normal_bits ? 3 * sizeof (uint16_t) : sizeof (vec3);
+  strides[1] = normal_bits ? 2 * normal_bits / 8 : sizeof (vec3);
+  strides[2] = normal_bits ? 2 * sizeof (uint16_t) : sizeof (vec2);
+}
+
+//! @return the number of unique vertices, stored.
+static uint32_t model_write_compressed (FILE *const fp, const char *const filename,
+                                        const vector<vec3> &vertices,
+                                        const vector<vec3> &normals,
+                                        const vector<vec2> &texture)
+{
+  struct model_compressed_header header;
+  const size_t nVertices = vertices.size ();
+  header.nVertices = (uint32_t) nVertices;
+  vector<vec3> normals_padded (normals);
+  vector<vec2> texture_padded (texture);
+  normals_padded.resize (nVertices, vec3 (0, 0, 1));
+  texture_padded.resize (nVertices, vec2 (0, 0));
+  struct model_quantized quantized;
+  vector<struct mesh_stream> streams;
+  if (globalModelEncoding.quantized)
+    {
+      model_quantize (vertices, normals_padded, texture_padded, globalModelEncoding.normal_bits, quantized);
+      header.normal_bits = (int32_t) quantized.normal_bits;
+      memcpy (header.offset, &quantized.offset, sizeof (header.offset));
+      memcpy (header.scale, &quantized.scale, sizeof (header.scale));
+      streams.push_back ({(const uint8_t *) quantized.positions.data (), 0});
+      streams.push_back ({(const uint8_t *) quantized.normals.data (), 0});
+      streams.push_back ({(const uint8_t *) quantized.texture.data (), 0});
+    }
+  else
+    {
+      streams.push_back ({(const uint8_t *) vertices.data (), 0});
+      streams.push_back ({(const uint8_t *) normals_padded.data (), 0});
+      streams.push_back ({(const uint8_t *) texture_padded.data (), 0});
+    }
+  size_t strides[3];
+  model_compressed_strides ((unsigned int) header.normal_bits, strides);
+  for (int a = 0; a < 3; ++a)
+    streams[a].stride = strides[a];
+
+  vector<uint32_t> indices, unique;
+  mesh_deduplicate (streams, nVertices, indices, unique);
+  header.nUnique = (uint32_t) unique.size ();
+  vector<uint8_t> coded;
+  mesh_encode_indices (indices.data (), indices.size (), coded);
+  header.sizes[0] = (uint32_t) coded.size ();
+  vector<uint8_t> attribute;
+  for (int a = 0; a < 3; ++a)
+    {
+      attribute.resize (unique.size () * strides[a]);
+      for (size_t u = 0; u < unique.size (); ++u)
+        memcpy (&attribute[u * strides[a]], streams[a].data + unique[u] * strides[a], strides[a]);
+      const size_t before = coded.size ();
+      mesh_encode_vertices (attribute.data (), unique.size (), strides[a], coded);
+      header.sizes[1 + a] = (uint32_t) (coded.size () - before);
+    }
+
+  if (globalModelEncoding.zstd)
+    {
+#ifdef USE_ZSTD
+      vector<uint8_t> compressed (ZSTD_compressBound (coded.size ()));
+      const size_t size = ZSTD_compress (compressed.data (), compressed.size (), coded.data (), coded.size (),
+                                         MODEL_ZSTD_LEVEL);
+      if (ZSTD_isError (size))
+        {
+          cerr << "failed compressing model: " << filename << ": " << ZSTD_getErrorName (size) << endl;
+          exit (EXIT_FAILURE);
+        }
+      compressed.resize (size);
+      coded.swap (compressed);
+      header.zstd = 1;
+#else
+      cerr << "failed compressing model: " << filename << ": built without zstd" << endl;
+      exit (EXIT_FAILURE);
+#endif
+    }
+  header.stored = (uint32_t) coded.size ();
+  fwrite (&header, sizeof (header), 1, fp);
+  fwrite (coded.data (), 1, coded.size (), fp);
+  fclose (fp);
+
+  cerr << "[generator] Wrote "
+       << nVertices << " vertices compressed, "
+       << unique.size () << " unique, in "
+       << sizeof (header) + coded.size () << " bytes to "
+       << filename << endl;
+  return header.nUnique;
+}
+
+//! Copies the attribute of each vertex out of the unique ones.
+template<size_t stride>
+static void model_gather (uint8_t *const out, const uint8_t *const unique, const vector<uint32_t> &indices)
+{
+  for (size_t v = 0; v < indices.size (); ++v)
+    memcpy (out + v * stride, unique + indices[v] * stride, stride);
+}
+
+static void model_gather (uint8_t *const out, const uint8_t *const unique, const size_t stride,
+                          const vector<uint32_t> &indices)
+{
+  switch (stride)
+    {
+      case 2:
+        model_gather<2> (out, unique, indices);
+        break;
+      case 4:
+        model_gather<4> (out, unique, indices);
+        break;
+      case 6:
+        model_gather<6> (out, unique, indices);
+        break;
+      case 8:
+        model_gather<8> (out, unique, indices);
+        break;
+      case 12:
+        model_gather<12> (out, unique, indices);
+        break;
+      default:
+        for (size_t v = 0; v < indices.size (); ++v)
+          memcpy (out + v * stride, unique + indices[v] * stride, stride);
+    }
+}
+
+/*!
+ * Reads what follows the tag of a compressed model, exiting when it is truncated or corrupt.
+ * @return whether its attributes are quantized, and so read into quantized, else into the vectors.
+ */
+static bool model_read_compressed (FILE *const fp, const char *const filename,
+                                   vector<vec3> &vertices,
+                                   vector<vec3> &normals,
+                                   vector<vec2> &texture,
+                                   struct model_quantized &quantized)
+{
+  struct model_compressed_header header;
+  const size_t tag = sizeof (header.tag);
+  if (fread ((char *) &header + tag, sizeof (header) - tag, 1, fp) != 1
+      || (header.normal_bits != 0 && header.normal_bits != 16 && header.normal_bits != 8))
+    {
+      cerr << "failed reading the header of compressed model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  // kept from model to model, so their pages are faulted in once, not for each
+  static thread_local vector<uint8_t> stored, coded, unique;
+  static thread_local vector<uint32_t> indices;
+  stored.resize (header.stored);
+  if (fread (stored.data (), 1, stored.size (), fp) != stored.size ())
+    {
+      cerr << "truncated compressed model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  if (header.zstd)
+    {
+#ifdef USE_ZSTD
+      coded.resize ((size_t) header.sizes[0] + header.sizes[1] + header.sizes[2] + header.sizes[3]);
+      const size_t size = ZSTD_decompress (coded.data (), coded.size (), stored.data (), stored.size ());
+      if (ZSTD_isError (size) || size != coded.size ())
+        {
+          cerr << "corrupt compressed model: " << filename << endl;
+          exit (EXIT_FAILURE);
+        }
+      stored.swap (coded);
+#else
+      cerr << "failed reading compressed model: " << filename << ": built without zstd" << endl;
+      exit (EXIT_FAILURE);
+#endif
+    }
+
+  size_t strides[3];
+  model_compressed_strides ((unsigned int) header.normal_bits, strides);
+  indices.resize (header.nVertices);
+  bool decoded = (size_t) header.sizes[0] + header.sizes[1] + header.sizes[2] + header.sizes[3] == stored.size ()
+                 && mesh_decode_indices (stored.data (), header.sizes[0], indices.size (), header.nUnique,
+                                         indices.data ());
+  const bool is_quantized = header.normal_bits != 0;
+  uint8_t *out[3];
+  if (is_quantized)
+    {
+      quantized.nVertices = header.nVertices;
+      quantized.normal_bits = (unsigned int) header.normal_bits;
+      memcpy (&quantized.offset, header.offset, sizeof (header.offset));
+      memcpy (&quantized.scale, header.scale, sizeof (header.scale));
+      quantized.positions.resize (3 * (size_t) header.nVertices);
+      quantized.normals.resize (strides[1] * header.nVertices);
+      quantized.texture.resize (2 * (size_t) header.nVertices);
+      out[0] = (uint8_t *) quantized.positions.data ();
+      out[1] = (uint8_t *) quantized.normals.data ();
+      out[2] = (uint8_t *) quantized.texture.data ();
+    }
+  else
+    {
+      vertices.resize (header.nVertices);
+      normals.resize (header.nVertices);
+      texture.resize (header.nVertices);
+      out[0] = (uint8_t *) vertices.data ();
+      out[1] = (uint8_t *) normals.data ();
+      out[2] = (uint8_t *) texture.data ();
+    }
+  size_t offset = header.sizes[0];
+  for (int a = 0; a < 3 && decoded; ++a)
+    {
+      unique.resize ((size_t) header.nUnique * strides[a]);
+      decoded = mesh_decode_vertices (stored.data () + offset, header.sizes[1 + a], header.nUnique, strides[a],
+                                      unique.data ());
+      offset += header.sizes[1 + a];
+      model_gather (out[a], unique.data (), strides[a], indices);
+    }
+  if (!decoded)
+    {
+      cerr << "corrupt compressed model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  return is_quantized;
+}
+
+//! @} end of group compression
+
+/*! @addtogroup header
+ * @{
+ * Models are written with a header (since version 1) telling what they are, so
+ * the engine may cull and allocate them before reading them: their encoding and
+ * the attributes they have, their counts and bounds, and the size and XXH64 of
+ * the payload that follows, against which it is checked when read:
+ *
+ * @code{.unparsed}
+ * model_header
+ * payload, a legacy model of the encoding: floats, quantized, compressed or chunked
+ * @endcode
+ *
+ * Floats are written without the attributes the model lacks, as texture
+ * coordinates may be, the other encodings with them as defaults: normals +z and
+ * texture coordinates zeros. Legacy models, without a header, are read as ever: they
+ * begin with their vertex count or a tag, which the magic never is.
+ */
+
+//! First bytes of models with a header: read as an int, negative, but none of the tags.
+const char MODEL_MAGIC[4] = {'3', 'd', 'M', '\xb3'};
+
+//! Bounds of the positions, the sphere centered on the box.
+static void model_bounds (const vec3 *const positions, const size_t count,
+                          vec3 &min, vec3 &max, vec3 &center, float &radius)
+{
+  if (!count)
+    return;
+  min = max = positions[0];
+  for (size_t v = 1; v < count; ++v)
+    {
+      min = glm::min (min, positions[v]);
+      max = glm::max (max, positions[v]);
+    }
+  center = (min + max) / 2.0f;
+  float radius2 = 0;
+  for (size_t v = 0; v < count; ++v)
+    {
+      const vec3 d = positions[v] - center;
+      radius2 = std::max (radius2, glm::dot (d, d));
+    }
+  radius = sqrtf (radius2);
+}
+
+//! @return whether the model has a header, exiting when it is of a version not known.
+static bool model_header_is (const struct model_header &header, const char *const filename)
+{
+  if (memcmp (header.magic, MODEL_MAGIC, sizeof (header.magic)))
+    return false;
+  if (header.version == 0 || header.version > MODEL_VERSION)
+    {
+      cerr << "unsupported version " << header.version << " of model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  return true;
+}
+
+//! Reads the header of a model, if it has one, else leaves the stream at its start, the header of version 0.
+static bool model_header_read (FILE *const fp, const char *const filename, struct model_header &header)
+{
+  if (fread (&header, sizeof (header), 1, fp) == 1 && model_header_is (header, filename))
+    return true;
+  header = {};
+  rewind (fp);
+  return false;
+}
+
+//! Checks the payload, of the size read, is whole and its checksum that of the header, exiting when not.
+static void model_header_check (const struct model_header &header, const char *const filename,
+                                const char *const payload, const size_t size)
+{
+  if (size < header.payload)
+    {
+      cerr << "truncated model, " << size << " of " << header.payload << " bytes: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  if (xxh64 (payload, header.payload) != header.checksum)
+    {
+      cerr << "corrupt model, its checksum differs: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+}
+
+//! @} end of group header
+
+/*! @addtogroup chunked
+ * @{
+ * Models written chunked (generator -k) can be drawn before they are read whole:
+ * their vertices are interleaved, as a single buffer object holds them, and split
+ * in chunks of whole triangles, each of which the table of contents tells the
+ * bounds of, so the bounds of the model are known before any vertex is read:
+ *
+ * @code{.unparsed}
+ * model_chunked_header
+ * model_chunk          per chunk
+ * model_vertex         per vertex, chunk after chunk
+ * @endcode
+ *
+ * Offsets are from the tag, where the payload following the header of the model begins.
+ *
+ * The engine uploads a chunk at a time as frames go by, drawing the triangles
+ * uploaded so far, so no more than a chunk of the model is ever held in memory.
+ */
+
+//! Header of chunked models, with the bounds of the whole model, as those of its chunks are.
+struct model_chunked_header {
+  int32_t tag = MODEL_CHUNKED;
+  uint32_t nChunks = 0;
+  uint64_t nVertices = 0;
+  struct model_chunk bounds; // of every vertex, its offset and count unused
+};
+
+static void model_chunk_bounds (const vec3 *const positions, const size_t count, struct model_chunk &chunk)
+{
+  model_bounds (positions, count, chunk.min, chunk.max, chunk.center, chunk.radius);
+}
+
+static void model_write_chunked (FILE *const fp, const char *const filename,
+                                 const vector<vec3> &vertices,
+                                 const vector<vec3> &normals,
+                                 const vector<vec2> &texture)
+{
+  struct model_chunked_header header;
+  header.nVertices = vertices.size ();
+  header.nChunks = (uint32_t) ((vertices.size () + MODEL_CHUNK_VERTICES - 1) / MODEL_CHUNK_VERTICES);
+  model_chunk_bounds (vertices.data (), vertices.size (), header.bounds);
+  vector<struct model_chunk> chunks (header.nChunks);
+  uint64_t offset = sizeof (header) + chunks.size () * sizeof (struct model_chunk);
+  for (size_t c = 0; c < chunks.size (); ++c)
+    {
+      const size_t begin = c * MODEL_CHUNK_VERTICES;
+      chunks[c].offset = offset;
+      chunks[c].nVertices = (uint32_t) std::min<size_t> (MODEL_CHUNK_VERTICES, vertices.size () - begin);
+      model_chunk_bounds (vertices.data () + begin, chunks[c].nVertices, chunks[c]);
+      offset += chunks[c].nVertices * sizeof (struct model_vertex);
+    }
+  fwrite (&header, sizeof (header), 1, fp);
+  fwrite (chunks.data (), sizeof (struct model_chunk), chunks.size (), fp);
+
+  vector<struct model_vertex> interleaved;
+  for (size_t c = 0; c < chunks.size (); ++c)
+    {
+      const size_t begin = c * MODEL_CHUNK_VERTICES;
+      interleaved.resize (chunks[c].nVertices);
+      for (size_t v = 0; v < interleaved.size (); ++v)
+        interleaved[v] = {vertices[begin + v],
+                          begin + v < normals.size () ? normals[begin + v] : vec3 (0, 0, 1),
+                          begin + v < texture.size () ? texture[begin + v] : vec2 (0, 0)};
+      fwrite (interleaved.data (), sizeof (struct model_vertex), interleaved.size (), fp);
+    }
+  fclose (fp);
+
+  cerr << "[generator] Wrote "
+       << header.nVertices << " vertices in "
+       << header.nChunks << " chunks to "
+       << filename << endl;
+}
+
+//! Reads what follows the tag of a chunked model, its table of contents, exiting when it is truncated or corrupt.
+static void model_chunks_read_contents (struct model_chunks &chunks)
+{
+  struct model_chunked_header header;
+  const size_t tag = sizeof (header.tag);
+  if (fread ((char *) &header + tag, sizeof (header) - tag, 1, chunks.fp) != 1)
+    {
+      cerr << "failed reading the header of chunked model: " << chunks.filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  chunks.nVertices = header.nVertices;
+  chunks.bounds = header.bounds;
+  if (chunks.header.version)
+    xxh64_update (chunks.hash, (const char *) &header + tag, sizeof (header) - tag);
+  // as many as there may be of the vertices, so a corrupt count is not allocated
+  if (header.nChunks > header.nVertices / MODEL_CHUNK_VERTICES + 1)
+    {
+      cerr << "corrupt chunked model: " << chunks.filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  chunks.chunks.resize (header.nChunks);
+  if (fread (chunks.chunks.data (), sizeof (struct model_chunk), header.nChunks, chunks.fp) != header.nChunks)
+    {
+      cerr << "truncated chunked model: " << chunks.filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  if (chunks.header.version)
+    xxh64_update (chunks.hash, chunks.chunks.data (), chunks.chunks.size () * sizeof (struct model_chunk));
+  uint64_t nVertices = 0;
+  bool corrupt = false;
+  for (const struct model_chunk &chunk: chunks.chunks)
+    {
+      corrupt = corrupt || chunk.nVertices > MODEL_CHUNK_VERTICES;
+      nVertices += chunk.nVertices;
+    }
+  if (corrupt || nVertices != chunks.nVertices)
+    {
+      cerr << "corrupt chunked model: " << chunks.filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  chunks.next = 0;
+}
+
+/*!
+ * Tells a chunked model by its first bytes, those of its header and the tag following it at least.
+ * @return whether it is one, and so to be read by model_chunks_open.
+ */
+bool model_chunked (const char *const head, const size_t size)
+{
+  struct model_header header;
+  int32_t tag;
+  if (size >= sizeof (header) + sizeof (tag))
+    {
+      memcpy (&header, head, sizeof (header));
+      if (!memcmp (header.magic, MODEL_MAGIC, sizeof (header.magic)))
+        return header.encoding == MODEL_CHUNKED;
+    }
+  if (size < sizeof (tag))
+    return false;
+  memcpy (&tag, head, sizeof (tag));
+  return tag == MODEL_CHUNKED;
+}
+
+/*!
+ * Opens a chunked model and reads its table of contents, exiting when it is truncated or corrupt.
+ * @return whether it is one, else it is left to model_read.
+ */
+bool model_chunks_open (const char *const filename, struct model_chunks &chunks)
+{
+  chunks.fp = fopen (filename, "r");
+  chunks.header = {};
+  chunks.base = 0;
+  if (chunks.fp && model_header_read (chunks.fp, filename, chunks.header))
+    chunks.base = sizeof (chunks.header);
+  int32_t tag;
+  if (!chunks.fp || fread (&tag, sizeof (tag), 1, chunks.fp) != 1 || tag != MODEL_CHUNKED)
+    {
+      model_chunks_close (chunks);
+      return false;
+    }
+  chunks.filename = filename;
+  xxh64_reset (chunks.hash);
+  if (chunks.header.version)
+    xxh64_update (chunks.hash, &tag, sizeof (tag));
+  model_chunks_read_contents (chunks);
+  return true;
+}
+
+/*!
+ * Reads the next chunk, exiting when it is truncated, or, once the last is read, its checksum differs.
+ * @param[out] vertices of the chunk alone, the memory of the previous one being reused.
+ * @return whether there was one left.
+ */
+bool model_chunks_read (struct model_chunks &chunks, vector<struct model_vertex> &vertices)
+{
+  if (chunks.next == chunks.chunks.size ())
+    return false;
+  const struct model_chunk &chunk = chunks.chunks[chunks.next++];
+  vertices.resize (chunk.nVertices);
+  if (fseeko (chunks.fp, (off_t) (chunks.base + chunk.offset), SEEK_SET)
+      || fread (vertices.data (), sizeof (struct model_vertex), chunk.nVertices, chunks.fp) != chunk.nVertices)
+    {
+      cerr << "truncated chunked model: " << chunks.filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  if (!chunks.header.version)
+    return true;
+  // the chunks follow one another, so they are hashed as the payload is
+  xxh64_update (chunks.hash, vertices.data (), vertices.size () * sizeof (struct model_vertex));
+  if (chunks.next == chunks.chunks.size ()
+      && (chunks.hash.total != chunks.header.payload || xxh64_digest (chunks.hash) != chunks.header.checksum))
+    {
+      cerr << "corrupt model, its checksum differs: " << chunks.filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  return true;
+}
+
+void model_chunks_close (struct model_chunks &chunks)
+{
+  if (chunks.fp)
+    fclose (chunks.fp);
+  chunks.fp = nullptr;
+}
+
+//! @} end of group chunked
+
+//! Writes the attributes of floats the model has, after their count, as legacy models are.
+static void model_write_floats (FILE *const fp, const char *const filename,
+                                const vector<vec3> &vertices,
+                                const vector<vec3> &normals,
+                                const vector<vec2> &texture,
+                                const uint32_t attributes)
+{
+  assert(vertices.size () < INT_MAX);
+  const int nVertices = vertices.size ();
+  const int nNormals = attributes & MODEL_NORMALS ? nVertices : 0;
+  const int nTextures = attributes & MODEL_TEXTURE ? nVertices : 0;
+  fwrite (&nVertices, sizeof (nVertices), 1, fp);
+  fwrite (vertices.data (), sizeof (vec3), nVertices, fp);
+  fwrite (normals.data (), sizeof (vec3), nNormals, fp);
+  fwrite (texture.data (), sizeof (vec2), nTextures, fp);
+
+  fclose (fp);
+
+  cerr << "[generator] Wrote "
+       << nVertices << " vertices, "
+       << nNormals << " normals, "
+       << nTextures << " textures to "
+       << filename << endl;
+}
+
+//! Writes floats, chunked or not, or quantized or compressed attributes as globalModelEncoding tells, after their header.
+void
+model_write (const char *const filename,
+             const vector<vec3> &vertices,
+             const vector<vec3> &normals,
+             const vector<vec2> &texture)
+{
+  FILE *fp = fopen (filename, "w");
+
+  if (!fp)
+    {
+      fprintf (stderr, "failed to open file: %s", filename);
+      exit (1);
+    }
+
+  struct model_header header;
+  memcpy (header.magic, MODEL_MAGIC, sizeof (header.magic));
+  header.version = MODEL_VERSION;
+  header.attributes = (normals.size () == vertices.size () ? MODEL_NORMALS : 0)
+                      | (texture.size () == vertices.size () ? MODEL_TEXTURE : 0);
+  header.nVertices = vertices.size ();
+  const bool quantized = globalModelEncoding.quantized && !globalModelEncoding.chunked;
+  if (quantized)
+    {
+      // of the positions as they are read back, which quantization moves
+      struct model_quantized read;
+      vector<vec3> positions;
+      model_quantize (vertices, normals, texture, globalModelEncoding.normal_bits, read);
+      model_dequantize_positions (read, positions);
+      model_bounds (positions.data (), positions.size (), header.min, header.max, header.center, header.radius);
+    }
+  else
+    model_bounds (vertices.data (), vertices.size (), header.min, header.max, header.center, header.radius);
+
+  // the payload is written to memory first, for the header to tell its size and checksum
+  char *payload = nullptr;
+  size_t size = 0;
+  FILE *const payload_fp = open_memstream (&payload, &size);
+  if (!payload_fp)
+    {
+      cerr << "failed to write model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  if (globalModelEncoding.chunked)
+    {
+      header.encoding = MODEL_CHUNKED;
+      model_write_chunked (payload_fp, filename, vertices, normals, texture);
+    }
+  else if (globalModelEncoding.compressed)
+    {
+      header.encoding = MODEL_COMPRESSED;
+      header.nIndices = vertices.size ();
+      header.nVertices = model_write_compressed (payload_fp, filename, vertices, normals, texture);
+    }
+  else if (quantized)
+    {
+      header.encoding = MODEL_QUANTIZED;
+      model_write_quantized (payload_fp, filename, vertices, normals, texture);
+    }
+  else
+    model_write_floats (payload_fp, filename, vertices, normals, texture, header.attributes);
+
+  header.payload = size;
+  header.checksum = xxh64 (payload, size);
+  fwrite (&header, sizeof (header), 1, fp);
+  fwrite (payload, 1, size, fp);
+  free (payload);
+  fclose (fp);
+}
+
+/*!
+ * Reads a model from the stream, which it closes, exiting when it is truncated.
+ * Quantized models are left so when wanted, the vectors then being emptied.
+ * @param attributes those floats are stored with, the other encodings storing them all.
+ */
+static void model_read_stream (FILE *const fp, const char *const filename,
+                               vector<vec3> &vertices,
+                               vector<vec3> &normals,
+                               vector<vec2> &texture,
+                               struct model_quantized *const quantized,
+                               const uint32_t attributes)
+{
+  // read number of vertices
+  int nVertices;
+  if (fread (&nVertices, sizeof (nVertices), 1, fp) != 1
+      || (nVertices < 0 && nVertices != MODEL_QUANTIZED && nVertices != MODEL_COMPRESSED
+          && nVertices != MODEL_CHUNKED))
+    {
+      cerr << "failed reading the number of vertices of model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  if (nVertices == MODEL_CHUNKED)
+    {
+      // whole, as those reading them a chunk at a time use model_chunks_open
+      struct model_chunks chunks;
+      chunks.fp = fp;
+      chunks.filename = filename;
+      model_chunks_read_contents (chunks);
+      vertices.clear ();
+      normals.clear ();
+      texture.clear ();
+      vertices.reserve (chunks.nVertices);
+      normals.reserve (chunks.nVertices);
+      texture.reserve (chunks.nVertices);
+      vector<struct model_vertex> chunk;
+      while (model_chunks_read (chunks, chunk))
+        for (const struct model_vertex &vertex: chunk)
+          {
+            vertices.push_back (vertex.position);
+            normals.push_back (vertex.normal);
+            texture.push_back (vertex.texture);
+          }
+      model_chunks_close (chunks);
+      return;
+    }
+  if (nVertices < 0)
+    {
+      struct model_quantized read;
+      struct model_quantized &into = quantized ? *quantized : read;
+      const bool is_quantized = nVertices == MODEL_QUANTIZED
+                                || model_read_compressed (fp, filename, vertices, normals, texture, into);
+      if (nVertices == MODEL_QUANTIZED)
+        model_read_quantized (fp, filename, into);
+      fclose (fp);
+      // compressed floats are read already
+      if (!is_quantized)
+        return;
+      if (quantized)
+        {
+          vertices.clear ();
+          normals.clear ();
+          texture.clear ();
+        }
+      else
+        model_dequantize (read, vertices, normals, texture);
+      return;
+    }
+
+  vertices.resize (nVertices);
+  const size_t nVerticesRead = fread (vertices.data (), sizeof (vec3), nVertices, fp);
+  if (nVerticesRead != nVertices)
+    {
+      cerr << nVerticesRead << " = nVerticesRead != nVertices = " << nVertices << endl;
+      exit (EXIT_FAILURE);
+    }
+
+  if (attributes & MODEL_NORMALS)
+    {
+      normals.resize (nVertices);
+      const size_t nNormalsRead = fread (normals.data (), sizeof (vec3), nVertices, fp);
+      if (nNormalsRead != nVertices)
+        {
+          cerr << nNormalsRead << " = nNormalsRead != nVertices = " << nVertices << endl;
+          exit (EXIT_FAILURE);
+        }
+    }
+  else
+    normals.assign (nVertices, vec3 (0, 0, 1));
+
+  texture.clear ();
+  if (attributes & MODEL_TEXTURE)
+    {
+      texture.resize (nVertices);
+      const size_t nTextureCoordinatesRead = fread (texture.data (), sizeof (vec2), nVertices, fp);
+      if (nTextureCoordinatesRead != nVertices)
+        {
+          cerr << nTextureCoordinatesRead << " = nTextureCoordinatesRead != nVertices = " << nVertices << endl;
+          exit (EXIT_FAILURE);
+        }
+    }
+
+  fclose (fp);
+}
+
+/*!
+ * Reads the payload of a model, read already, of the header, exiting when it is truncated or corrupt.
+ * Texture coordinates are left empty when the model has none, though its encoding stores zeros.
+ */
+static void model_read_payload (const struct model_header &header, const char *const filename,
+                                const char *const payload, const size_t size,
+                                vector<vec3> &vertices,
+                                vector<vec3> &normals,
+                                vector<vec2> &texture,
+                                struct model_quantized *const quantized)
+{
+  model_header_check (header, filename, payload, size);
+  // opened for reading only, so never written to
+  FILE *fp = fmemopen ((void *) payload, header.payload, "r");
+  if (!fp)
+    {
+      cerr << "failed to open model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  model_read_stream (fp, filename, vertices, normals, texture, quantized, header.attributes);
+  if (header.attributes & MODEL_TEXTURE)
+    return;
+  texture.clear ();
+  if (quantized)
+    quantized->texture.clear ();
+}
+
+/*!
+ * Reads a model written by model_write, exiting when the file is missing, truncated or corrupt.
+ * @param[out] quantized where a quantized model is left as it is, if wanted; else it is dequantized.
+ * @param[out] header of the model, if wanted, of version 0 when it has none.
+ */
+void model_read (const char *const filename,
+                 vector<vec3> &vertices,
+                 vector<vec3> &normals,
+                 vector<vec2> &texture,
+                 struct model_quantized *const quantized,
+                 struct model_header *const header)
+{
+  FILE *fp = fopen (filename, "r");
+  if (!fp)
+    {
+      cerr << "failed to open model: " << filename << endl;
+      exit (EXIT_FAILURE);
+    }
+  struct model_header read;
+  if (!model_header_read (fp, filename, read))
+    model_read_stream (fp, filename, vertices, normals, texture, quantized, MODEL_NORMALS | MODEL_TEXTURE);
+  else
+    {
+      // whole, to be checked before it is parsed, though no more than the file holds of a corrupt size
+      fseeko (fp, 0, SEEK_END);
+      const uint64_t stored = (uint64_t) ftello (fp) - sizeof (read);
+      static thread_local vector<char> payload;
+      payload.resize (std::min (stored, read.payload));
+      fseeko (fp, sizeof (read), SEEK_SET);
+      const size_t size = fread (payload.data (), 1, payload.size (), fp);
+      fclose (fp);
+      model_read_payload (read, filename, payload.data (), size, vertices, normals, texture, quantized);
+    }
+  if (header)
+    *header = read;
+}
+
+//! Reads a model from the contents of its file, read already, exiting when they are truncated or corrupt.
+void model_read_memory (const char *const filename, const char *const data, const size_t size,
+                        vector<vec3> &vertices,
+                        vector<vec3> &normals,
+                        vector<vec2> &texture,
+                        struct model_quantized *const quantized,
+                        struct model_header *const header)
+{
+  struct model_header read;
+  if (size >= sizeof (read))
+    memcpy (&read, data, sizeof (read));
+  if (size >= sizeof (read) && model_header_is (read, filename))
+    model_read_payload (read, filename, data + sizeof (read), size - sizeof (read),
+                        vertices, normals, texture, quantized);
+  else
+    {
+      read = {};
+      // opened for reading only, so never written to
+      FILE *fp = fmemopen ((void *) data, size, "r");
+      if (!fp)
+        {
+          cerr << "failed to open model: " << filename << endl;
+          exit (EXIT_FAILURE);
+        }
+      model_read_stream (fp, filename, vertices, normals, texture, quantized, MODEL_NORMALS | MODEL_TEXTURE);
+    }
+  if (header)
+    *header = read;
+}
+
+//!@} end of group points
+
+/*! @addtogroup model
+ * @{*/
+
+/*! @addtogroup plane
+* @{*/
+void model_plane_vertices (const float length,
+                           const unsigned int divisions,
+                           vector<vec3> &vertices,
+                           vector<vec3> &normals,
+                           vector<vec2> &texture)
+{
+  const float o = -length / 2.0f;
+  const float d = length / (float) divisions;
+
+  for (unsigned int uidiv1 = 1; uidiv1 <= divisions; ++uidiv1)
+    {
+      for (unsigned int uidiv2 = 1; uidiv2 <= divisions; ++uidiv2)
+        {
+          auto const fdiv1 = (float) uidiv1;
+          auto const fdiv2 = (float) uidiv2;
+          auto const fdivisions = (float) divisions;
+
+          for (auto e : {
+              array<float, 2>{-1, -1},//P1
+              array<float, 2>{-1, 0},//P1'z
+              array<float, 2>{0, -1},//P1'x
+
+              array<float, 2>{0, -1},//P1'x
+              array<float, 2>{-1, 0},//P1'z
+              array<float, 2>{0, 0}})//P2
+            {
+              vertices.emplace_back (o + d * (fdiv1 + e[0]), 0, o + d * (fdiv2 + e[1]));
+              normals.emplace_back (0, 1, 0);
+              texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+            }
+
+
+          /*Cull face*/
+          for (auto e : {
+              array<float, 2>{-1.0f, 0.0f},
+              array<float, 2>{-1.0f, -1.0f},
+              array<float, 2>{0.0f, -1.0f},
+
+              array<float, 2>{-1.0f, 0.0f},
+              array<float, 2>{0.0f, -1.0f},
+              array<float, 2>{0.0f, 0.0f}})
+            {
+              vertices.emplace_back (o + d * (fdiv1 + e[0]), 0, o + d * (fdiv2 + e[1]));
+              normals.emplace_back (0, -1, 0);
+              texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+            }
+        }
+    }
+}
+
+static inline unsigned int model_plane_nVertices (const unsigned int divisions)
+{ return divisions * divisions * 12; }
+
+void model_plane_write (const char *filepath, const float length, const unsigned int divisions)
+{
+  const unsigned int nVertices = model_plane_nVertices (divisions);
+  vector<vec3> vertices;
+  vertices.reserve (nVertices);
+  vector<vec3> normals;
+  normals.reserve (nVertices);
+  vector<vec2> texture;
+  texture.reserve (nVertices);
+  model_plane_vertices (length, divisions, vertices, normals, texture);
+  model_write (filepath, vertices, normals, texture);
+}
+//!@} end of group plane
+
+/*! @addtogroup cube
+* @{*/
+void model_cube_vertices (const float length,
+                          const unsigned int divisions,
+                          vector<vec3> &vertices,
+                          vector<vec3> &normals,
+                          vector<vec2> &texture)
+{
+  const float o = -length / 2.0f;
+  const float d = length / (float) divisions;
+
+  for (unsigned int uidiv1 = 1; uidiv1 <= divisions; uidiv1++)
+    {
+      for (unsigned int uidiv2 = 1; uidiv2 <= divisions; uidiv2++)
+        {
+          auto const fdiv1 = (float) uidiv1;
+          auto const fdiv2 = (float) uidiv2;
+          auto const fdivisions = (float) divisions;
+
+          // y+
+          for (auto e : {
+              array<float, 2>{-1, -1}, //P1
+              array<float, 2>{-1, 0}, //P1'z
+              array<float, 2>{0, -1}, //P1'x
+
+              array<float, 2>{0, -1}, //P1'x
+              array<float, 2>{-1, 0}, //P1'z
+              array<float, 2>{0, 0}   //P2
+          })
+            {
+              vertices.emplace_back (o + d * (fdiv1 + e[0]), -o, o + d * (fdiv2 + e[1]));
+              normals.emplace_back (0, 1, 0);
+              texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+            }
+
+          // y-
+          vertices.emplace_back (o + d * (fdiv1 - 1), o, o + d * fdiv2); //P1'z
+          vertices.emplace_back (o + d * (fdiv1 - 1), o, o + d * (fdiv2 - 1)); //P1
+          vertices.emplace_back (o + d * fdiv1, o, o + d * (fdiv2 - 1)); //P1'x
+
+          vertices.emplace_back (o + d * (fdiv1 - 1), o, o + d * fdiv2); //P1'z
+          vertices.emplace_back (o + d * fdiv1, o, o + d * (fdiv2 - 1)); //P1'x
+          vertices.emplace_back (o + d * fdiv1, o, o + d * fdiv2); //P2
+
+          for (int k = 0; k < 6; ++k)
+            normals.emplace_back (0, -1, 0);
+          for (auto e : {
+              vec2 (-1.0f, 0.0f),
+              vec2 (-1.0f, -1.0f),
+              vec2 (0.0f, -1.0f),
+
+              vec2 (-1.0f, 0.0f),
+              vec2 (0.0f, -1.0f),
+              vec2 (0.0f, 0.0f)})
+            texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+
+
+          // x-
+          vertices.emplace_back (o, o + d * (fdiv1 - 1), o + d * (fdiv2 - 1)); //P1
+          vertices.emplace_back (o, o + d * (fdiv1 - 1), o + d * fdiv2); //P1'z
+          vertices.emplace_back (o, o + d * fdiv1, o + d * (fdiv2 - 1)); //P1'x
+
+          vertices.emplace_back (o, o + d * fdiv1, o + d * (fdiv2 - 1)); //P1'x
+          vertices.emplace_back (o, o + d * (fdiv1 - 1), o + d * fdiv2); //P1'z
+          vertices.emplace_back (o, o + d * fdiv1, o + d * fdiv2); //P2
+
+          for (int k = 0; k < 6; ++k)
+            normals.emplace_back (-1, 0, 0);
+
+          for (auto e : {
+              vec2 (-1.0f, -1.0f),
+              vec2 (-1.0f, 0.0f),
+              vec2 (0.0f, -1.0f),
+
+              vec2 (0.0f, -1.0f),
+              vec2 (-1.0f, 0.0f),
+              vec2 (0.0f, 0.0f)})
+            texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+
+
+          // x+
+          vertices.emplace_back (-o, o + d * (fdiv1 - 1), o + d * fdiv2); //P1'z
+          vertices.emplace_back (-o, o + d * (fdiv1 - 1), o + d * (fdiv2 - 1)); //P1
+          vertices.emplace_back (-o, o + d * fdiv1, o + d * (fdiv2 - 1)); //P1'x
+
+          vertices.emplace_back (-o, o + d * (fdiv1 - 1), o + d * fdiv2); //P1'z
+          vertices.emplace_back (-o, o + d * fdiv1, o + d * (fdiv2 - 1)); //P1'x
+          vertices.emplace_back (-o, o + d * fdiv1, o + d * fdiv2); //P2
+
+          for (int k = 0; k < 6; ++k)
+            normals.emplace_back (1, 0, 0);
+
+          for (auto e : {
+              vec2 (-1.0f, 0.0f),
+              vec2 (-1.0f, -1.0f),
+              vec2 (0.0f, -1.0f),
+
+              vec2 (-1.0f, 0.0f),
+              vec2 (0.0f, -1.0f),
+              vec2 (0.0f, 0.0f)})
+            texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+
+
+          // z-
+          vertices.emplace_back (o + d * (fdiv1 - 1), o + d * (fdiv2 - 1), o); //P1
+          vertices.emplace_back (o + d * (fdiv1 - 1), o + d * fdiv2, o); //P1'z
+          vertices.emplace_back (o + d * fdiv1, o + d * (fdiv2 - 1), o); //P1'x
+
+          vertices.emplace_back (o + d * fdiv1, o + d * (fdiv2 - 1), o); //P1'x
+          vertices.emplace_back (o + d * (fdiv1 - 1), o + d * fdiv2, o); //P1'z
+          vertices.emplace_back (o + d * fdiv1, o + d * fdiv2, o); //P2
+
+          for (auto e : {
+              vec2 (-1.0f, -1.0f),//P1
+              vec2 (-1.0f, 0.0f),//P1'z
+              vec2 (0.0f, -1.0f),//P1'x
+
+              vec2 (0.0f, -1.0f),//P1'x
+              vec2 (-1.0f, 0.0f),//P1'z
+              vec2 (0.0f, 0.0f)//P2
+          })
+            {
+              normals.emplace_back (0, 0, -1);
+              texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+            }
+
+
+
+          // z+
+          vertices.emplace_back (o + d * (fdiv1 - 1), o + d * fdiv2, -o); //P1'z
+          vertices.emplace_back (o + d * (fdiv1 - 1), o + d * (fdiv2 - 1), -o); //P1
+          vertices.emplace_back (o + d * fdiv1, o + d * (fdiv2 - 1), -o); //P1'x
+
+          vertices.emplace_back (o + d * (fdiv1 - 1), o + d * fdiv2, -o); //P1'z
+          vertices.emplace_back (o + d * fdiv1, o + d * (fdiv2 - 1), -o); //P1'x
+          vertices.emplace_back (o + d * fdiv1, o + d * fdiv2, -o); //P2
+
+          for (int k = 0; k < 6; ++k)
+            normals.emplace_back (0, 0, 1);
+
+          for (auto e : {
+              vec2 (-1.0f, 0.0f),
+              vec2 (-1.0f, -1.0f),
+              vec2 (0.0f, -1.0f),
+
+              vec2 (-1.0f, 0.0f),
+              vec2 (0.0f, -1.0f),
+              vec2 (0.0f, 0.0f)
+          })
+            texture.emplace_back ((fdiv1 + e[0]) / fdivisions, (fdiv2 + e[1]) / fdivisions);
+        }
+    }
+}
+
+static inline unsigned int model_cube_nVertices (const unsigned int divisions)
+{ return divisions * divisions * 36; }
+
+void model_cube_write (const char *const filepath,
+                       const float length,
+                       const unsigned int divisions)
+{
+  const unsigned int nVertices = model_cube_nVertices (divisions);
+  vector<vec3> vertices;
+  vertices.reserve (nVertices);
+  vector<vec3> normals;
+  normals.reserve (nVertices);
+  vector<vec2> texture;
+  texture.reserve (nVertices);
+
+  model_cube_vertices (length, divisions, vertices, normals, texture);
+  model_write (filepath, vertices, normals, texture);
+}
+
+//!@} end of group cube
+
+/*! @addtogroup cone
+* @{*/
+
+/*!
+ * \f{aligned}{
+ * x &= r⋅\frac{h}{\textrm{height}} ⋅ \cos(θ)\\[2em]
+ * y &= h + \textrm{height}\\[2em]
+ * z &= r⋅\frac{h}{\textrm{height}} ⋅ \sin(θ)
+ * \f}\n
+ *
+ * \f{aligned}{
+ *  r &≥ 0\\
+ *  θ &∈ \left\{-π      + i⋅s : s = \frac{2π}{\textrm{slices}}      ∧ i ∈ \{0,...,\textrm{slices}\} \right\}\\
+ *  h &∈ \left\{- \textrm{height} + j⋅t : t =  \frac{\textrm{height}}{\textrm{stacks}} ∧ j ∈ \{0,...,\textrm{stacks}\} \right\}
+ *  \f}
+ *
+ *  See the [3d model](https://www.math3d.org/7oeSkmuns).
+ */
+
+template<typename T>
+    requires arithmetic<T>
+static inline void
+model_cone_vertex (const T r,
+                   const T height,
+                   const T theta,
+                   const T h,
+                   vector<vec3> &vertices)
+{
+  /*
+     x = r ⋅ (h/height) ⋅ cos(θ)
+     y = 2 ⋅ (height + h)
+     z = r ⋅ (h/height) ⋅ sin(θ)
+
+     r ≥ 0
+     θ ∈ {-π      + i⋅s : s = 2π/slices      ∧ i ∈ {0,...,slices} }
+     h ∈ {-height + j⋅t : t = height/stacks ∧ j ∈ {0,...,stacks} }
+
+     check:
+         1. https://www.math3d.org/7oeSkmuns
+   */
+  vertices.emplace_back (r * h / height * cos (theta), height + h, r * h / height * sin (theta));
+}
+
+template<typename T>
+    requires arithmetic<T>
+void model_cone_vertices (const T radius,
+                          const T height,
+                          const unsigned int slices,
+                          const unsigned int stacks,
+                          vector<vec3> &vertices,
+                          vector<vec3> &normals,
+                          vector<vec2> &texture)
+{
+
+  const T s = 2 * M_PI / (float) slices;
+  const T t = height / (float) stacks;
+
+  const T theta_0 = -M_PI;
+  const T h_0 = -height;
+
+  auto const fslices = (float) slices;
+  auto const fstacks = (float) stacks;
+
+  for (unsigned int slice = 1; slice <= slices; ++slice)
+    {
+      for (unsigned int stack = 1; stack <= stacks; ++stack)
+        {
+          auto const fslice = (float) slice;
+          auto const fstack = (float) stack;
+
+          //base
+          vertices.emplace_back (0, 0, 0); //O
+          texture.emplace_back (0, 0);
+          normals.emplace_back (0, -1, 0);
+          for (auto e : {
+              -1.0f,//P1
+              .0f //P2
+          })
+            {
+              model_cone_vertex (radius, height, theta_0 + s * (fslice + e), h_0, vertices); //P1
+              normals.emplace_back (0, -1, 0);
+            }
+
+          texture.emplace_back (-1, 0);
+          texture.emplace_back (0, 0);
+
+          int q = 0;
+          for (auto e : {
+              array<float, 2>{0, -1},
+              array<float, 2>{-1, 0},
+              array<float, 2>{0, 0},
+
+              array<float, 2>{0, -1},
+              array<float, 2>{-1, -1},
+              array<float, 2>{-1, 0},
+          })
+            {
+              model_cone_vertex (radius, height,
+                                 theta_0 + s * (fslice + e[0]),
+                                 h_0 + t * (fstack + e[1]), vertices);
+              if (q % 3 == 2)
+                {
+                  const auto P1 = vertices.end ()[-2];
+                  const auto P2 = vertices.end ()[-3];
+                  const auto P1_prime = vertices.end ()[-1];
+                  for (auto _ = 0; _ < 3; ++_)
+                    normals.emplace_back (normalize (cross (P2 - P1_prime, P1 - P1_prime)));
+                }
+
+              texture.emplace_back (fslice / fslices, fstack / fstacks);
+              ++q;
+            }
+        }
+    }
+}
+
+template void model_cone_vertices<float> (float, float, unsigned int, unsigned int,
+                                          vector<vec3> &, vector<vec3> &, vector<vec2> &);
+
+static inline unsigned int model_cone_nVertices (const unsigned int stacks, const unsigned int slices)
+{
+  return slices * stacks * 9;
+}
+
+void model_cone_write (const char *const filepath,
+                       const float radius,
+                       const float height,
+                       const unsigned int slices,
+                       const unsigned int stacks)
+{
+  const unsigned int nVertices = model_cone_nVertices (stacks, slices);
+  vector<vec3> vertices;
+  vertices.reserve (nVertices);
+  vector<vec3> normals;
+  normals.reserve (nVertices);
+  vector<vec2> texture;
+  texture.reserve (nVertices);
+  model_cone_vertices (radius, height, slices, stacks, vertices, normals, texture);
+  model_write (filepath, vertices, normals, texture);
+}
+
+//!@} end of group cone
+
+/*! @addtogroup sphere
+* @{*/
+
+static inline unsigned int model_sphere_nVertices (const unsigned int slices, const unsigned int stacks)
+{
+  return slices * stacks * 6;
+}
+
+static inline void
+model_sphere_vertex (const float r,
+                     const float theta,
+                     const float phi,
+                     vector<vec3> &vertices,
+                     vector<vec3> &normals)
+{
+  /*
+      x = r ⋅ sin(θ)cos(φ)
+      y = r ⋅ sin(φ)
+      z = r ⋅ cos(θ)cos(φ)
+
+      r ≥ 0
+      θ ∈ {-π +   i⋅s : s = 2π/slices ∧ i ∈ {0,...,slices} }
+      ϕ ∈ {-π/2 + j⋅t : t =  π/stacks ∧ j ∈ {0,...,stacks} }
+
+      check
+          1. https://www.math3d.org/EumEEZBKe
+          2. https://www.math3d.org/zE4n6xayX
+   */
+  vertices.emplace_back (r * sin (theta) * cos (phi), r * sin (phi), r * cos (theta) * cos (phi));
+  normals.emplace_back (sin (theta) * cos (phi), sin (phi), cos (theta) * cos (phi));
+}
+
+void model_sphere_vertices (const float r,
+                            const unsigned int slices,
+                            const unsigned int stacks,
+                            vector<vec3> &vertices,
+                            vector<vec3> &normals,
+                            vector<vec2> &texture)
+{
+  // https://www.math3d.org/EumEEZBKe
+  // https://www.math3d.org/zE4n6xayX
+
+  const float s = 2.0f * (float) M_PI / (float) slices;
+  const float t = M_PI / (float) stacks;
+  const float theta = -M_PI;
+  const float phi = -M_PI / 2.0f;
+
+  auto fslices = (float) slices;
+  auto fstacks = (float) stacks;
+
+  for (unsigned int slice = 1; slice <= slices; ++slice)
+    {
+      for (unsigned int stack = 1; stack <= stacks; ++stack)
+        {
+          auto fslice = (float) slice;
+          auto fstack = (float) stack;
+
+          texture.emplace_back ((fslice - 1) / fslices, fstack / fstacks); // P1'
+          texture.emplace_back (fslice / fslices, (fstack - 1) / fstacks); // P2
+          texture.emplace_back (fslice / fslices, fstack / fstacks); // P2'
+
+          texture.emplace_back ((fslice - 1) / fslices, (fstack - 1) / fstacks); // P1
+          texture.emplace_back (fslice / fslices, (fstack - 1) / fstacks); // P2
+          texture.emplace_back ((fslice - 1) / fslices, fstack / fstacks); // P1'
+
+          model_sphere_vertex (r, theta + s * (fslice - 1), phi + t * fstack, vertices, normals); // P1'
+          model_sphere_vertex (r, theta + s * fslice, phi + t * (fstack - 1), vertices, normals); // P2
+          model_sphere_vertex (r, theta + s * fslice, phi + t * fstack, vertices, normals); // P2'
+
+          model_sphere_vertex (r, theta + s * (fslice - 1), phi + t * (fstack - 1), vertices, normals); // P1
+          model_sphere_vertex (r, theta + s * fslice, phi + t * (fstack - 1), vertices, normals); // P2
+          model_sphere_vertex (r, theta + s * (fslice - 1), phi + t * fstack, vertices, normals); // P1'
+        }
+    }
+}
+
+void model_sphere_write (const char *const filepath,
+                         const float radius,
+                         const unsigned int slices,
+                         const unsigned int stacks)
+{
+
+  const unsigned int nVertices = model_sphere_nVertices (slices, stacks);
+  vector<vec3> vertices;
+  vertices.reserve (nVertices);
+  vector<vec3> normals;
+  normals.reserve (nVertices);
+  vector<vec2> texture;
+  texture.reserve (nVertices);
+  model_sphere_vertices (radius, slices, stacks, vertices, normals, texture);
+  model_write (filepath, vertices, normals, texture);
+}
+//!@} end of group sphere
+
+//!@} end of group model
+
+/*! @addtogroup bezier
+ * @{ */
+vector<array<vec3, 16>> read_Bezier (const char *const patch)
+{
+  string buffer;
+  ifstream myFile;
+
+  myFile.open (patch, ios::in | ios::out);
+  getline (myFile, buffer);
+  // Número de patches presentes no ficheiro.
+  const int n_patches = stoi (buffer);
+
+  // Vetor de vetores de índices.
+  vector<vector<int>> patches;
+
+  // Ciclo externo lê uma linha (patch) de cada vez
+  for (int j = 0; j < n_patches; j++)
+    {
+      vector<int> patchIndexes;
+      /*
+      Ciclo interno lê os índices dos pontos de controlo de cada patch, sabendo que cada
+      patch terá 16 pontos de controlo.
+      */
+      for (int i = 0; i < 15; i++)
+        {
+          getline (myFile, buffer, ',');
+          patchIndexes.push_back (stoi (buffer));
+        }
+      getline (myFile, buffer);
+      patchIndexes.push_back (stoi (buffer));
+      patches.push_back (patchIndexes);
+    }
+
+  getline (myFile, buffer);
+  // Número de pontos presentes no ficheiro.
+  const int pts = stoi (buffer);
+
+  // Vetor que guardará as coordenadas de pontos de controlo para superfície de Bézier.
+  vector<vec3> control;
+  for (int j = 0; j < pts; j++)
+    {
+      vec3 v;
+      getline (myFile, buffer, ',');
+      v[0] = stof (buffer);
+      getline (myFile, buffer, ',');
+      v[1] = stof (buffer);
+      getline (myFile, buffer);
+      v[2] = stof (buffer);
+      control.push_back (v);
+    }
+
+  /*
+  Percorrem-se os vetores que, para cada patch, guardam os seus índices de pontos de controlo.
+  Para cada patch, constroi-se um vetor com as coordenadas dos seus pontos de controlo.
+  */
+  vector<array<vec3, 16>> pointsInPatches;
+  for (auto &patche : patches)
+    {
+      array<vec3, 16> pointsInPatch{};
+      for (int j = 0; j < 16; j++)
+        {
+          pointsInPatch[j] = control[patche[j]];
+        }
+      pointsInPatches.push_back (pointsInPatch);
+    }
+
+  myFile.close ();
+  return pointsInPatches;
+}
+
+template<typename T> static inline vec4 monic_3rd_polynomial_at (T n)
+{
+  return {pow (n, 3), pow (n, 2), n, 1};
+}
+
+template<typename T> static inline vec4 deriv_of_monic_3rd_polynomial_at (T n)
+{
+  return {3 * pow (n, 2), 2 * n, 1, 0};
+}
+
+mat4x3 mat (const array<vec3, 4> C)
+{
+  return {C[0], C[1], C[2], C[3]};
+}
+
+/*!
+ *
+ * @param[in] u first component of the 2d point.
+ * @param[in] v second component of the 2d point.
+ * @param[in] cp a set of control points that define the bezier patch.
+ * @param[out] coordinate_in_3d_space cartesian three-dimensional coordinate of the
+ *                                    point specified by Beziér patch coordinate.
+ * @param[out] normal vector normal to the patch specified.
+ */
+void get_bezier_point_at (
+    const float u,
+    const float v,
+    const array<vec3, 16> &cp,
+    vec3 &coordinate_in_3d_space,
+    vec3 &normal)
+{
+
+  // P_u notation at (slide 17)[Curves and Surfaces]
+
+  // P(u,v) = UM(Pi0(P0u) + Pi1(P1u) + Pi2(P2u) Pi3(P3u)) based on (page 6)[CURVES AND SURFACES]
+
+  // 4 sets of control points for 4 Bézier curves
+  array<vec3, 4> C_i0 = {cp[0], cp[1], cp[2], cp[3]};
+  array<vec3, 4> C_i1 = {cp[4], cp[5], cp[6], cp[7]};
+  array<vec3, 4> C_i2 = {cp[8], cp[9], cp[10], cp[11]};
+  array<vec3, 4> C_i3 = {cp[12], cp[13], cp[14], cp[15]};
+
+  // calculate P_i(u) at each Bézier curve defined by Ci
+  vec3 P0u, P1u, P2u, P3u, _;
+  get_curve_point_at (u, Mb, C_i0, P0u, _);
+  get_curve_point_at (u, Mb, C_i1, P1u, _);
+  get_curve_point_at (u, Mb, C_i2, P2u, _);
+  get_curve_point_at (u, Mb, C_i3, P3u, _);
+
+  // Calculate vector tangent to u⃗
+  const auto VM = monic_3rd_polynomial_at (v) * Mb;
+  const auto U_prime = deriv_of_monic_3rd_polynomial_at (u);
+  const auto tangent_u =
+      (mat (C_i0) * VM[0] + mat (C_i1) * VM[1] + mat (C_i2) * VM[2] + mat (C_i3) * VM[3]) * Mb * U_prime;
+
+  vec3 Puv, tangent_v;
+  get_curve_point_at (v, Mb, {P0u, P1u, P2u, P3u}, Puv, tangent_v);
+
+  normal = normalize (cross (tangent_u, tangent_v));
+  coordinate_in_3d_space = Puv;
+}
+
+static inline unsigned int model_bezier_patch_nVertices (const unsigned int tesselation)
+{
+  return tesselation * tesselation * 6;
+}
+
+static inline unsigned int model_bezier_surface_nVertices (
+    const unsigned int number_of_patches,
+    const unsigned int tesselation)
+{
+  return model_bezier_patch_nVertices (tesselation) * number_of_patches;
+}
+
+void get_bezier_patch (
+    const array<vec3, 16> control_points,
+    const int int_tesselation,
+    vector<vec3> &vertices,
+    vector<vec3> &normals,
+    vector<vec2> &texture)
+{
+  auto float_tesselation = (float) int_tesselation;
+  const auto step = 1.0 / float_tesselation;
+  for (int v = 0; v < int_tesselation; ++v)
+    {
+      for (int u = 0; u < int_tesselation; ++u)
+        {
+          for (auto e : {
+              // upper triangle
+              array<float, 2>{0, 1},
+              array<float, 2>{0, 0},
+              array<float, 2>{1, 0},
+              // lower triangle
+              array<float, 2>{1, 0},
+              array<float, 2>{1, 1},
+              array<float, 2>{0, 1},
+          })
+            {
+              vec3 vertex, normal;
+              get_bezier_point_at (u * step + step * e[0], v * step + step * e[1], control_points, vertex, normal);
+
+              auto fu = (float) u;
+              auto fv = (float) v;
+              vertices.push_back (vertex);
+              normals.push_back (normal);
+              texture.emplace_back (-(u * step + step * e[0]), -(v * step + step * e[1]));
+            }
+
+          //          // upper triangle
+          //          vertices.push_back (get_bezier_point_at (u * step, v * step, control_points));
+          //          vertices.push_back (get_bezier_point_at (u * step, v * step + step, control_points));
+          //          vertices.push_back (get_bezier_point_at (u * step + step, v * step, control_points));
+          //          // lower triangle
+          //          vertices.push_back (get_bezier_point_at (u * step + step, v * step, control_points));
+          //          vertices.push_back (get_bezier_point_at (u * step + step, v * step + step, control_points));
+          //          vertices.push_back (get_bezier_point_at (u * step, v * step + step, control_points));
+        }
+    }
+}
+
+/*!
+ *
+ * @param control_elements 4 vertices define a bezier curve and 4 bezier curves define a bezier patch.
+ *                         A set of bezier patches define a bezier surface.
+ *                         Therefore, each control element of a bezier surface requires 16 vertices.
+ */
+void get_bezier_surface (
+    const vector<array<vec3, 16>> &control_elements,
+    const int tesselation,
+    vector<vec3> &vertices,
+    vector<vec3> &normals,
+    vector<vec2> &texture)
+{
+
+  for (auto &control_element : control_elements)
+    get_bezier_patch (control_element, tesselation, vertices, normals, texture);
+}
+
+void model_bezier_write (
+    const int tesselation,
+    const char *const in_patch_file,
+    const char *const out_3d_file)
+{
+  vector<array<vec3, 16>> control_points = read_Bezier (in_patch_file);
+
+  const unsigned int nVertices = model_bezier_surface_nVertices (control_points.size (), tesselation);
+  vector<vec3> vertices;
+  vertices.reserve (nVertices);
+  vector<vec3> normals;
+  normals.reserve (nVertices);
+  vector<vec2> texture;
+  texture.reserve (nVertices);
+
+  get_bezier_surface (control_points, tesselation, vertices, normals, texture);
+  if (nVertices != vertices.size ())
+    {
+      cerr << nVertices << " = nVertices != vertices.size () = " << vertices.size () << endl;
+      exit (EXIT_FAILURE);
+    }
+  //assert (nVertices == vertices.size ());
+
+  model_write (out_3d_file, vertices, normals, texture);
+}
+//!@} end of group bezier
+
+//!@} end of group generator
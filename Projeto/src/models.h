@@ -0,0 +1,163 @@
+#ifndef _MODELS_H_
+#define _MODELS_H_
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "xxh64.h"
+
+template<class T>
+concept arithmetic =  std::is_integral<T>::value or std::is_floating_point<T>::value;
+
+void points_vertex (float x, float y, float z, unsigned int *pos, float points[]);
+void points_write (const char *filename, unsigned int nVertices, const float points[]);
+//! Read where the vertex count of a model of floats is, which is never negative, for the other encodings.
+enum {
+  MODEL_QUANTIZED = -1,
+  MODEL_COMPRESSED = -2,
+  MODEL_CHUNKED = -3
+};
+
+//! How model_write encodes models: floats unless told otherwise.
+struct model_encoding {
+  bool quantized = false;
+  unsigned int normal_bits = 16; // of each octahedral component, 16 or 8
+  bool compressed = false;       // indexed, and the streams coded, quantized or not
+  bool zstd = false;             // the coded streams compressed with zstd too
+  bool chunked = false;          // floats interleaved in chunks, to be read a chunk at a time
+};
+extern struct model_encoding globalModelEncoding;
+
+//! Attributes a model has, besides positions, which every model has.
+enum {
+  MODEL_NORMALS = 1 << 0,
+  MODEL_TEXTURE = 1 << 1
+};
+
+//! Version of the header model_write writes, ahead of the payload legacy models hold alone.
+const uint32_t MODEL_VERSION = 1;
+
+//! Header of a model, telling what it is without reading its payload.
+struct model_header {
+  char magic[4] = {};
+  uint32_t version = 0;     // 0 for legacy models, which have none
+  int32_t encoding = 0;     // 0 for floats, else the tag the payload begins with
+  uint32_t attributes = 0;  // MODEL_NORMALS and MODEL_TEXTURE, those the model has
+  uint64_t nVertices = 0;   // stored
+  uint64_t nIndices = 0;    // of the triangles, 0 unless the vertices are indexed
+  glm::vec3 min{0}, max{0}; // bounding box
+  glm::vec3 center{0};      // and bounding sphere
+  float radius = -1;
+  uint64_t payload = 0;     // bytes following the header
+  uint64_t checksum = 0;    // XXH64 of them
+};
+
+//! Attributes of a model as quantized models store them, and the GPU reads them.
+struct model_quantized {
+  unsigned int nVertices = 0;
+  unsigned int normal_bits = 16;
+  glm::vec3 offset{0}, scale{0};   // positions are offset + scale * p / 65535
+  std::vector<uint16_t> positions; // 3 unsigned normalized per vertex
+  std::vector<int8_t> normals;     // 2 signed normalized octahedral components per vertex, of normal_bits
+  std::vector<uint16_t> texture;   // 2 half floats per vertex
+};
+
+void model_quantize (const std::vector<glm::vec3> &vertices, const std::vector<glm::vec3> &normals,
+                     const std::vector<glm::vec2> &texture, unsigned int normal_bits,
+                     struct model_quantized &quantized);
+void model_dequantize_positions (const struct model_quantized &quantized, std::vector<glm::vec3> &vertices);
+void model_dequantize (const struct model_quantized &quantized, std::vector<glm::vec3> &vertices,
+                       std::vector<glm::vec3> &normals, std::vector<glm::vec2> &texture);
+
+//! A vertex of a chunked model, its attributes interleaved as they are uploaded.
+struct model_vertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 texture;
+};
+
+//! Chunks hold this many vertices, whole triangles, but for the last.
+const unsigned int MODEL_CHUNK_VERTICES = 3 * 21845;
+
+//! Entry of the table of contents of a chunked model.
+struct model_chunk {
+  uint64_t offset = 0;   // in the file, of its vertices
+  uint32_t nVertices = 0;
+  uint32_t reserved = 0;
+  glm::vec3 min{0}, max{0}; // bounding box of its vertices
+  glm::vec3 center{0};      // and bounding sphere
+  float radius = -1;
+};
+
+//! A chunked model being read a chunk at a time.
+struct model_chunks {
+  FILE *fp = nullptr;
+  std::string filename;
+  struct model_header header;             // of the file, of version 0 when it has none
+  uint64_t base = 0;                      // offset of the chunked model, past the header
+  struct xxh64_state hash;                // of the payload read so far, checked after the last chunk
+  uint64_t nVertices = 0;
+  struct model_chunk bounds;              // of the whole model
+  std::vector<struct model_chunk> chunks; // the table of contents
+  size_t next = 0;                        // chunk read next
+};
+
+bool model_chunked (const char *head, size_t size);
+bool model_chunks_open (const char *filename, struct model_chunks &chunks);
+bool model_chunks_read (struct model_chunks &chunks, std::vector<struct model_vertex> &vertices);
+void model_chunks_close (struct model_chunks &chunks);
+
+void model_write (const char *filename,
+                  const std::vector<glm::vec3> &vertices,
+                  const std::vector<glm::vec3> &normals,
+                  const std::vector<glm::vec2> &texture);
+void model_read (const char *filename,
+                 std::vector<glm::vec3> &vertices,
+                 std::vector<glm::vec3> &normals,
+                 std::vector<glm::vec2> &texture,
+                 struct model_quantized *quantized = nullptr,
+                 struct model_header *header = nullptr);
+void model_read_memory (const char *filename, const char *data, size_t size,
+                        std::vector<glm::vec3> &vertices,
+                        std::vector<glm::vec3> &normals,
+                        std::vector<glm::vec2> &texture,
+                        struct model_quantized *quantized = nullptr,
+                        struct model_header *header = nullptr);
+
+void model_plane_vertices (float length, unsigned int divisions,
+                           std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals,
+                           std::vector<glm::vec2> &texture);
+void model_plane_write (const char *filepath, float length, unsigned int divisions);
+
+void model_cube_vertices (float length, unsigned int divisions,
+                          std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals,
+                          std::vector<glm::vec2> &texture);
+void model_cube_write (const char *filepath, float length, unsigned int divisions);
+
+template<typename T>
+    requires arithmetic<T>
+void model_cone_vertices (T radius, T height, unsigned int slices, unsigned int stacks,
+                          std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals,
+                          std::vector<glm::vec2> &texture);
+void model_cone_write (const char *filepath, float radius, float height, unsigned int slices, unsigned int stacks);
+
+void model_sphere_vertices (float r, unsigned int slices, unsigned int stacks,
+                            std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals,
+                            std::vector<glm::vec2> &texture);
+void model_sphere_write (const char *filepath, float radius, unsigned int slices, unsigned int stacks);
+
+std::vector<std::array<glm::vec3, 16>> read_Bezier (const char *patch);
+void get_bezier_point_at (float u, float v, const std::array<glm::vec3, 16> &cp,
+                          glm::vec3 &coordinate_in_3d_space, glm::vec3 &normal);
+void get_bezier_patch (std::array<glm::vec3, 16> control_points, int int_tesselation,
+                       std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals,
+                       std::vector<glm::vec2> &texture);
+void get_bezier_surface (const std::vector<std::array<glm::vec3, 16>> &control_elements, int tesselation,
+                         std::vector<glm::vec3> &vertices, std::vector<glm::vec3> &normals,
+                         std::vector<glm::vec2> &texture);
+void model_bezier_write (int tesselation, const char *in_patch_file, const char *out_3d_file);
+#endif //_MODELS_H_
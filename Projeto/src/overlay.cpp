@@ -0,0 +1,322 @@
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include "overlay.h"
+#include "shader.h"
+
+using std::string, std::vector;
+
+/*! @addtogroup overlay
+ * @{
+ * Text drawn over the scene, for statistics.
+ *
+ * Glyphs are 5×7 pixels, kept in a small atlas built at startup so that no font
+ * file is needed. Each frame the text is laid out into a single vertex buffer,
+ * background included, and drawn with one call.
+ */
+
+const int GLYPH_WIDTH = 5;
+const int GLYPH_HEIGHT = 7;
+const int CELL_WIDTH = GLYPH_WIDTH + 1;  // cells leave a blank column and row, so that filtering never bleeds
+const int CELL_HEIGHT = GLYPH_HEIGHT + 1;
+const int ATLAS_COLUMNS = 16;
+const int GLYPH_SCALE = 2;               // window pixels per glyph pixel
+const int MARGIN = 4;
+
+/*!
+ * Rows of the glyphs from ' ' to '`', then '{' to '~' and a full block, top row first,
+ * the most significant of the 5 bits being the leftmost pixel.
+ * Lower case letters are drawn in upper case.
+ */
+static const uint8_t GLYPHS[][GLYPH_HEIGHT] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // !
+    {0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00}, // "
+    {0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a}, // #
+    {0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04}, // $
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // %
+    {0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d}, // &
+    {0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00}, // \'
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // (
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // )
+    {0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00}, // *
+    {0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00}, // +
+    {0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08}, // ,
+    {0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00}, // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c}, // .
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // /
+    {0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e}, // 0
+    {0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e}, // 1
+    {0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f}, // 2
+    {0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e}, // 3
+    {0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02}, // 4
+    {0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e}, // 5
+    {0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e}, // 6
+    {0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+    {0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e}, // 8
+    {0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c}, // 9
+    {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00}, // :
+    {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08}, // ;
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, // <
+    {0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00}, // =
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, // >
+    {0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // ?
+    {0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e}, // @
+    {0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11}, // A
+    {0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e}, // B
+    {0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e}, // C
+    {0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c}, // D
+    {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f}, // E
+    {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10}, // F
+    {0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f}, // G
+    {0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11}, // H
+    {0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e}, // I
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c}, // J
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // K
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f}, // L
+    {0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11}, // M
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // N
+    {0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e}, // O
+    {0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10}, // P
+    {0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d}, // Q
+    {0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11}, // R
+    {0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e}, // S
+    {0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // T
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e}, // U
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04}, // V
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a}, // W
+    {0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11}, // X
+    {0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04}, // Y
+    {0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f}, // Z
+    {0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e}, // [
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00}, // backslash
+    {0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e}, // ]
+    {0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00}, // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f}, // _
+    {0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00}, // `
+    {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02}, // {
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // |
+    {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08}, // }
+    {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00}, // ~
+    {0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f}, // full block, for backgrounds
+};
+const unsigned int GLYPH_COUNT = sizeof (GLYPHS) / sizeof (GLYPHS[0]);
+const unsigned int FULL_BLOCK = GLYPH_COUNT - 1;
+const int ATLAS_WIDTH = ATLAS_COLUMNS * CELL_WIDTH;
+const int ATLAS_HEIGHT = (GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS * CELL_HEIGHT;
+
+static const char *const OVERLAY_VERTEX_SOURCE = R"(
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 texcoord;
+layout (location = 2) in vec4 tint;
+
+uniform vec2 screen;
+
+out vec2 uv;
+out vec4 color_in;
+
+void main ()
+{
+  uv = texcoord;
+  color_in = tint;
+  gl_Position = vec4 (position / screen * vec2 (2.0, -2.0) + vec2 (-1.0, 1.0), 0.0, 1.0);
+}
+)";
+
+static const char *const OVERLAY_FRAGMENT_SOURCE = R"(
+uniform sampler2D atlas;
+
+in vec2 uv;
+in vec4 color_in;
+
+out vec4 color;
+
+void main ()
+{
+  color = color_in * texture (atlas, uv);
+}
+)";
+
+static unsigned int overlay_glyph (const unsigned char c)
+{
+  const unsigned char upper = (unsigned char) toupper (c);
+  if (upper >= ' ' && upper <= '`')
+    return upper - ' ';
+  if (upper >= '{' && upper <= '~')
+    return upper - '{' + ('`' - ' ' + 1);
+  return '?' - ' ';
+}
+
+//! Builds the atlas texture, and the program and vertex array of core profiles.
+void overlay_create (struct overlay &overlay, const bool core)
+{
+  overlay.core = core;
+
+  // white texels, the glyph being in the alpha channel, so that text can be tinted
+  vector<GLubyte> texels (4 * ATLAS_WIDTH * ATLAS_HEIGHT, 0);
+  for (unsigned int g = 0; g < GLYPH_COUNT; ++g)
+    for (int row = 0; row < GLYPH_HEIGHT; ++row)
+      for (int column = 0; column < GLYPH_WIDTH; ++column)
+        {
+          const int x = (int) (g % ATLAS_COLUMNS) * CELL_WIDTH + column;
+          const int y = (int) (g / ATLAS_COLUMNS) * CELL_HEIGHT + row;
+          GLubyte *const texel = &texels[4 * (y * ATLAS_WIDTH + x)];
+          texel[0] = texel[1] = texel[2] = 255;
+          texel[3] = (GLYPHS[g][row] >> (GLYPH_WIDTH - 1 - column)) & 1 ? 255 : 0;
+        }
+
+  glGenTextures (1, &overlay.texture);
+  glBindTexture (GL_TEXTURE_2D, overlay.texture);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data ());
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture (GL_TEXTURE_2D, 0);
+
+  glGenBuffers (1, &overlay.buffer);
+  if (core)
+    {
+      overlay.program = shader_program (OVERLAY_VERTEX_SOURCE, OVERLAY_FRAGMENT_SOURCE);
+      overlay.screen = glGetUniformLocation (overlay.program, "screen");
+      glUseProgram (overlay.program);
+      glUniform1i (glGetUniformLocation (overlay.program, "atlas"), 0);
+      glUseProgram (0);
+
+      glGenVertexArrays (1, &overlay.vao);
+      glBindVertexArray (overlay.vao);
+      glBindBuffer (GL_ARRAY_BUFFER, overlay.buffer);
+      const GLsizei stride = sizeof (struct overlay_vertex);
+      glVertexAttribPointer (0, 2, GL_FLOAT, GL_FALSE, stride, (void *) offsetof (struct overlay_vertex, x));
+      glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE, stride, (void *) offsetof (struct overlay_vertex, u));
+      glVertexAttribPointer (2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *) offsetof (struct overlay_vertex, color));
+      glEnableVertexAttribArray (0);
+      glEnableVertexAttribArray (1);
+      glEnableVertexAttribArray (2);
+      glBindVertexArray (0);
+      glBindBuffer (GL_ARRAY_BUFFER, 0);
+    }
+}
+
+//! Appends the two triangles of a quad, its texture coordinates given in atlas texels.
+static void overlay_quad (vector<struct overlay_vertex> &vertices, const float x0, const float y0,
+                          const float x1, const float y1, const float u0, const float v0,
+                          const float u1, const float v1, const GLubyte *const color)
+{
+  const float s0 = u0 / ATLAS_WIDTH, s1 = u1 / ATLAS_WIDTH;
+  const float t0 = v0 / ATLAS_HEIGHT, t1 = v1 / ATLAS_HEIGHT;
+  const struct overlay_vertex corners[6] = {
+      {x0, y0, s0, t0}, {x0, y1, s0, t1}, {x1, y1, s1, t1},
+      {x0, y0, s0, t0}, {x1, y1, s1, t1}, {x1, y0, s1, t0}};
+  for (struct overlay_vertex corner: corners)
+    {
+      for (int c = 0; c < 4; ++c)
+        corner.color[c] = color[c];
+      vertices.push_back (corner);
+    }
+}
+
+static void overlay_layout (struct overlay &overlay, const vector<string> &lines)
+{
+  static const GLubyte BACKGROUND[4] = {0, 0, 0, 160};
+  static const GLubyte TEXT[4] = {255, 255, 255, 255};
+  const float advance = CELL_WIDTH * GLYPH_SCALE;
+  const float line_height = CELL_HEIGHT * GLYPH_SCALE;
+
+  size_t columns = 0;
+  for (const auto &line: lines)
+    columns = std::max (columns, line.size ());
+
+  overlay.vertices.clear ();
+  // the background samples the middle of the full block, which is opaque
+  const float block_u = (FULL_BLOCK % ATLAS_COLUMNS) * CELL_WIDTH + GLYPH_WIDTH / 2.0f;
+  const float block_v = (FULL_BLOCK / ATLAS_COLUMNS) * CELL_HEIGHT + GLYPH_HEIGHT / 2.0f;
+  overlay_quad (overlay.vertices, 0, 0, 2 * MARGIN + advance * columns, 2 * MARGIN + line_height * lines.size (),
+                block_u, block_v, block_u, block_v, BACKGROUND);
+
+  for (size_t l = 0; l < lines.size (); ++l)
+    for (size_t c = 0; c < lines[l].size (); ++c)
+      {
+        const unsigned int g = overlay_glyph (lines[l][c]);
+        if (g == 0) // space
+          continue;
+        const float x = MARGIN + advance * c;
+        const float y = MARGIN + line_height * l;
+        const float u = (g % ATLAS_COLUMNS) * CELL_WIDTH;
+        const float v = (g / ATLAS_COLUMNS) * CELL_HEIGHT;
+        overlay_quad (overlay.vertices, x, y, x + GLYPH_WIDTH * GLYPH_SCALE, y + GLYPH_HEIGHT * GLYPH_SCALE,
+                      u, v, u + GLYPH_WIDTH, v + GLYPH_HEIGHT, TEXT);
+      }
+}
+
+/*!
+ * Draws lines of text at the top left of a width × height viewport, over whatever is there.
+ * The GL state it changes is restored, except for the bound array buffer.
+ */
+void overlay_draw (struct overlay &overlay, const vector<string> &lines, const int width, const int height)
+{
+  overlay_layout (overlay, lines);
+  glBindBuffer (GL_ARRAY_BUFFER, overlay.buffer);
+  glBufferData (GL_ARRAY_BUFFER, (GLsizeiptr) (overlay.vertices.size () * sizeof (struct overlay_vertex)),
+                overlay.vertices.data (), GL_STREAM_DRAW);
+  glActiveTexture (GL_TEXTURE0);
+  glBindTexture (GL_TEXTURE_2D, overlay.texture);
+
+  if (overlay.core)
+    {
+      glDisable (GL_DEPTH_TEST);
+      glEnable (GL_BLEND);
+      glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glUseProgram (overlay.program);
+      glUniform2f (overlay.screen, (float) width, (float) height);
+      glBindVertexArray (overlay.vao);
+      glDrawArrays (GL_TRIANGLES, 0, (GLsizei) overlay.vertices.size ());
+      glBindVertexArray (0);
+      glUseProgram (0);
+      glDisable (GL_BLEND);
+      glEnable (GL_DEPTH_TEST);
+    }
+#ifndef __APPLE__
+  else
+    {
+      glPushAttrib (GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT);
+      glPushClientAttrib (GL_CLIENT_VERTEX_ARRAY_BIT);
+      glDisable (GL_LIGHTING);
+      glDisable (GL_DEPTH_TEST);
+      glEnable (GL_TEXTURE_2D);
+      glEnable (GL_BLEND);
+      glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glTexEnvi (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+      glMatrixMode (GL_PROJECTION);
+      glPushMatrix ();
+      glLoadIdentity ();
+      glOrtho (0, width, height, 0, -1, 1);
+      glMatrixMode (GL_MODELVIEW);
+      glPushMatrix ();
+      glLoadIdentity ();
+
+      const GLsizei stride = sizeof (struct overlay_vertex);
+      glEnableClientState (GL_VERTEX_ARRAY);
+      glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+      glEnableClientState (GL_COLOR_ARRAY);
+      glDisableClientState (GL_NORMAL_ARRAY);
+      glVertexPointer (2, GL_FLOAT, stride, (void *) offsetof (struct overlay_vertex, x));
+      glTexCoordPointer (2, GL_FLOAT, stride, (void *) offsetof (struct overlay_vertex, u));
+      glColorPointer (4, GL_UNSIGNED_BYTE, stride, (void *) offsetof (struct overlay_vertex, color));
+      glDrawArrays (GL_TRIANGLES, 0, (GLsizei) overlay.vertices.size ());
+
+      glPopMatrix ();
+      glMatrixMode (GL_PROJECTION);
+      glPopMatrix ();
+      glMatrixMode (GL_MODELVIEW);
+      glPopClientAttrib ();
+      glPopAttrib ();
+    }
+#endif
+  glBindTexture (GL_TEXTURE_2D, 0);
+}
+
+//!@} end of group overlay
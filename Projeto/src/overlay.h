@@ -0,0 +1,31 @@
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+#include <string>
+#include <vector>
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+//! Corner of a glyph quad, in window pixels from the top left.
+struct overlay_vertex {
+  float x, y;
+  float u, v;
+  GLubyte color[4] = {};
+};
+
+//! Text drawn over the viewport from a glyph atlas, with the fixed-function pipeline or a core profile program.
+struct overlay {
+  bool core = false;
+  GLuint texture = 0; // the glyph atlas
+  GLuint buffer = 0;
+  GLuint vao = 0;     // core profile only
+  GLuint program = 0; // core profile only
+  GLint screen = -1;
+  std::vector<struct overlay_vertex> vertices;
+};
+
+void overlay_create (struct overlay &overlay, bool core);
+void overlay_draw (struct overlay &overlay, const std::vector<std::string> &lines, int width, int height);
+#endif //_OVERLAY_H_
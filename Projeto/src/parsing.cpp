@@ -1,8 +1,12 @@
 #include <cstdio>
 #include <cstring>
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
+#include <unordered_set>
+
+#include <sys/stat.h>
 
 #ifndef USE_SYSTEM
 #include <sys/wait.h>
@@ -10,10 +14,12 @@
 #include <cassert>
 #else
 #include <filesystem>
+#include <sstream>
 using std::filesystem::current_path;
 #endif
 
-#include "tinyxml2.h"
+#include "jobs.h"
+#include "xml_stream.h"
 #include "parsing.h"
 
 char globalGeneratorExecutable[BUFSIZ];
@@ -27,10 +33,11 @@ bool globalUsingGenerator = false;
  * ⟨operations⟩ ::= ⟨position⟩⟨lookAt⟩⟨up⟩⟨projection⟩⟨light⟩⃰ ⟨grouping⟩⁺
  *      ⟨position⟩,⟨lookAt⟩,⟨up⟩,⟨projection⟩ ::= ⟨vec3f⟩
  *       ⟨light⟩ ::= ⟨point⟩ | ⟨directional⟩ | ⟨spotlight⟩
- *            ⟨point⟩ ::= ⟨POINT⟩⟨vec3f⟩
+ *            ⟨point⟩ ::= ⟨POINT⟩⟨vec3f⟩⟨range⟩
  *            ⟨directional⟩ ::= ⟨DIRECTIONAL⟩⟨vec3f⟩
- *            ⟨spotlight⟩ ::= ⟨SPOTLIGHT⟩⟨vec3f⟩⟨vec3f⟩⟨cutoff⟩
+ *            ⟨spotlight⟩ ::= ⟨SPOTLIGHT⟩⟨vec3f⟩⟨vec3f⟩⟨cutoff⟩⟨range⟩
  *                ⟨cutoff⟩ ::= ⟨float⟩ ∈ [0,90] ∪ {180}
+ *                ⟨range⟩ ::= ⟨float⟩ ≥ 0, 0 meaning unlimited
  *
  * ⟨grouping⟩ ::= ⟨BEGIN_GROUP⟩⟨elem⟩⁺⟨END_GROUP⟩
  *      ⟨elem⟩ ::= ⟨transformation⟩ | ⟨model_loading⟩ | ⟨grouping⟩
@@ -65,174 +72,304 @@ bool globalUsingGenerator = false;
  * the model filename characters and to int when reading the number of characters.
  */
 
-/*! @addtogroup Transforms
- * @{*/
+
+/*! @addtogroup xml
+ * @{
+ * The world file is read as a stream of elements (see xml_stream), each turned into
+ * operations as soon as it is read, so memory stays bounded by the depth of the
+ * hierarchy however large the file is, and deep hierarchies are walked on an
+ * explicit stack rather than by recursion.
+ *
+ * Of the camera, lights, transform, models, texture, color and each color component,
+ * only the first element of their parent counts, and the rest are skipped, as are
+ * elements of no meaning where they are. The operations come out in the order of
+ * the grammar above whatever the order of the elements: the lights, transforms and
+ * models of a world or group read after one of its groups are moved back in place.
+ * Well ordered files, with those first, need no moving at all.
+ *
+ * Large files are read in parallel, groups being independent of their siblings.
+ * The groups of the world's group are split off as they are found: only skimmed
+ * over for where they end, much faster than read, and left out of the operations.
+ * Those much larger than the rest are read apart from their own groups in turn,
+ * which are split off likewise. The rest are then read by the job system, each
+ * into operations of its own, spliced back in place in the order of the file; so
+ * the operations are the same as read by a single thread.
+ */
 
 using std::vector;
-using tinyxml2::XMLElement;
-using tinyxml2::XMLDocument, tinyxml2::XML_SUCCESS, tinyxml2::XMLError, tinyxml2::XML_NO_ATTRIBUTE;
 using std::cerr, std::endl;
 using std::string;
 
-void crashIfFailedAttributeQuery (const XMLError error, const XMLElement &element, const string &attributeName)
+//! Elements the parser is in, on its stack.
+enum parsing_context {
+  CONTEXT_DOCUMENT,
+  CONTEXT_WORLD,
+  CONTEXT_CAMERA,
+  CONTEXT_LIGHTS,
+  CONTEXT_GROUP,
+  CONTEXT_TRANSFORM,
+  CONTEXT_POINTS, // of an extended translation
+  CONTEXT_MODELS,
+  CONTEXT_MODEL,
+  CONTEXT_COLOR,
+  CONTEXT_SKIPPED // along with everything inside
+};
+
+//! Elements of which only the first of their parent counts, as bits of parsing_frame::seen.
+enum {
+  SEEN_WORLD = 1 << 0,
+  SEEN_CAMERA = 1 << 1,
+  SEEN_LIGHTS = 1 << 2,
+  SEEN_GENERATOR = 1 << 3,
+  SEEN_GROUP = 1 << 4,
+  SEEN_POSITION = 1 << 5,
+  SEEN_LOOK_AT = 1 << 6,
+  SEEN_UP = 1 << 7,
+  SEEN_PROJECTION = 1 << 8,
+  SEEN_TRANSFORM = 1 << 9,
+  SEEN_MODELS = 1 << 10,
+  SEEN_TEXTURE = 1 << 11,
+  SEEN_COLOR = 1 << 12,
+  SEEN_SHININESS = 1 << 13,
+  SEEN_DIFFUSE = 1 << 14 // and the other color components after it, in the order of colorNames
+};
+
+struct parsing_frame {
+  enum parsing_context context;
+  unsigned int seen = 0;
+  size_t transforms_end = 0; // groups: where their transforms end, and their models begin
+  size_t header_end = 0;     // world and groups: where their lights or models end, and their groups begin
+  size_t begin = 0;          // lights, transforms and models: where their operations begin, until moved in place
+  size_t points = 0;         // extended translations: where their number of points goes
+  bool split = false;        // groups: their groups are split off, to be read apart
+};
+
+//! An error met reading apart, reported once every group is read if it is the first in the file.
+struct parsing_error {
+  size_t offset = SIZE_MAX; // in the file, of what was to be read next when it was met
+  string message;
+};
+
+//! A group split off to be read apart, and spliced back in place into the operations of what it was split from.
+struct parsing_subtree {
+  size_t begin = 0, end = 0;   // in the file, from right after its start tag to right after its end tag
+  unsigned int line = 0;       // of begin
+  size_t position = 0;         // in the operations of what it was split from
+  bool split = false;          // read apart from its own groups, which are split off in turn
+  bool cut = false;            // ends where the file is not well-formed, to be read up to there
+  struct parsing_error error;  // of reading it, its own groups aside
+  vector<float> operations;
+  vector<struct parsing_subtree> children; // split off, in the order of the file
+  std::unordered_set<string> files;
+  vector<string> file_order;
+  unsigned int groups = 0;
+  unsigned int models = 0;
+};
+
+//! What a model is made of, kept until it is done so that its operations come in the order of the grammar.
+struct parsing_model {
+  string file;
+  bool generator;
+  string argv;
+  bool has_argv;
+  bool texture;
+  string texture_file;
+  bool has_color[4];
+  float color[4][3];
+  bool has_shininess;
+  float shininess;
+};
+
+struct parsing_state {
+  const string &filename;
+  vector<float> &operations;
+  struct xml_stream &stream;
+  vector<struct parsing_frame> stack{};
+  struct parsing_model model{};
+  size_t camera = 0;                  // where the camera operations are
+  std::unordered_set<string> files{}; // models and textures, checked once the world is read
+  vector<string> file_order{};        // the files, in the order first referred to
+  unsigned int groups = 0;
+  unsigned int models = 0;
+  vector<struct parsing_subtree> *subtrees = nullptr; // the groups split off go to
+  bool deferred = false; // errors are thrown as parsing_error, to be reported in the order of the file
+};
+
+const int COLORS = 4;
+const char *const colorNames[COLORS] = {"diffuse", "ambient", "specular", "emissive"};
+const operation_t colorTypes[COLORS] = {DIFFUSE, AMBIENT, SPECULAR, EMISSIVE};
+
+//! Reports the error and exits, or, reading groups apart or reloading, throws it to be reported once the file is read.
+void parsing_report (const struct parsing_state &state, const string &message)
 {
-  if (!error)
-    return;
-  cerr << "[parsing] failed parsing attribute " << attributeName << " of element " << element.Value ()
-       << "\nError: " << XMLDocument::ErrorIDToName (error) << endl;
+  const string report = "[parsing] '" + state.filename + "' " + message;
+  if (state.deferred)
+    throw parsing_error {xml_stream_offset (state.stream), report};
+  cerr << report << endl;
   exit (EXIT_FAILURE);
 }
 
-float getFloatAttribute (const XMLElement &e, const string &attributeName)
+void parsing_fail (const struct parsing_state &state, const string &message)
 {
-  float attributeValue;
-  XMLError error = e.QueryFloatAttribute (attributeName.c_str (), &attributeValue);
-  crashIfFailedAttributeQuery (error, e, attributeName);
-  return attributeValue;
+  parsing_report (state, "line " + std::to_string (xml_stream_line (state.stream)) + ": " + message);
 }
 
-template<typename T>
-T getAttribute (const XMLElement &e, const string &attributeName)
+//! For errors of the stream itself, which tell their line.
+void parsing_fail_stream (const struct parsing_state &state)
 {
-  T _attributeValue;
-  XMLError error;
-  if (std::is_same<float, T>::value)
-    {
-      float attributeValue;
-      error = e.QueryFloatAttribute (attributeName.c_str (), &attributeValue);
-      _attributeValue = attributeValue;
-    }
-  else if (std::is_same<bool, T>::value)
-    {
-      bool attributeValue;
-      error = e.QueryBoolAttribute (attributeName.c_str (), &attributeValue);
-      _attributeValue = attributeValue;
-    }
-  else if (std::is_same<string, T>::value)
-    {
-      const char **attributeValue;
-      error = e.QueryStringAttribute (attributeName.c_str (), attributeValue);
-      _attributeValue = **attributeValue;
-    }
-  crashIfFailedAttributeQuery (error, e, attributeName);
-  return _attributeValue;
+  parsing_report (state, state.stream.error);
 }
 
-string getStringAttribute (const XMLElement &e, const string &attributeName)
+//! Whether the element is the first of its kind in the element on top of the stack, so the one that counts.
+bool parsing_first (struct parsing_state &state, const unsigned int kind)
 {
-  const char **attributeValue;
-  XMLError error = e.QueryStringAttribute (attributeName.c_str (), attributeValue);
-  crashIfFailedAttributeQuery (error, e, attributeName);
-  return string{*attributeValue};
+  struct parsing_frame &parent = state.stack.back ();
+  const bool first = !(parent.seen & kind);
+  parent.seen |= kind;
+  return first;
 }
 
-void operations_push_transform_attributes (
-    const XMLElement &transform,
-    vector<float> &operations)
+const char *getStringAttribute (const struct parsing_state &state, const char *const attributeName)
 {
+  const char *const value = xml_stream_attribute (state.stream, attributeName);
+  if (!value)
+    parsing_fail (state, string ("missing attribute ") + attributeName + " of element " + state.stream.name);
+  return value;
+}
 
-  float angle;
-  {
-    const XMLError e = transform.QueryFloatAttribute ("angle", &angle);
-    if (e == XML_SUCCESS)
-      operations.push_back (angle);
-    else if (e != XML_NO_ATTRIBUTE)
-      {
-        fprintf (stderr, "[parsing] Parsing error %s at %s\n", transform.Value (), XMLDocument::ErrorIDToName (e));
-        exit (EXIT_FAILURE);
-      }
-  }
-  for (const string attribute_name : {"x", "y", "z"})
-    {
-      float attributeValue = getFloatAttribute (transform, attribute_name);
-      operations.push_back (attributeValue);
-    }
+//! @return false when the element has no such attribute.
+bool queryFloatAttribute (const struct parsing_state &state, const char *const attributeName, float &value)
+{
+  const char *const string_value = xml_stream_attribute (state.stream, attributeName);
+  if (!string_value)
+    return false;
+  char *end;
+  value = strtof (string_value, &end);
+  if (end == string_value)
+    parsing_fail (state, string ("failed parsing attribute ") + attributeName + " of element " + state.stream.name
+                         + ": '" + string_value + "' is not a number");
+  return true;
 }
 
-void
-operations_push_extended_translate_attributes (
-    const XMLElement *const extended_translate,
-    vector<float> &operations)
+float getFloatAttribute (const struct parsing_state &state, const char *const attributeName)
 {
-  if (!extended_translate)
-    {
-      fprintf (stderr, "[parsing] Null transform\n");
-      exit (EXIT_FAILURE);
-    }
+  float value;
+  if (!queryFloatAttribute (state, attributeName, value))
+    parsing_fail (state, string ("missing attribute ") + attributeName + " of element " + state.stream.name);
+  return value;
+}
+
+//! true, false, or a number, true unless 0.
+bool getBoolAttribute (const struct parsing_state &state, const char *const attributeName)
+{
+  const char *const value = getStringAttribute (state, attributeName);
+  char *end;
+  const long number = strtol (value, &end, 0);
+  if (end != value)
+    return number;
+  if (!strcmp (value, "true") || !strcmp (value, "True") || !strcmp (value, "TRUE"))
+    return true;
+  if (!strcmp (value, "false") || !strcmp (value, "False") || !strcmp (value, "FALSE"))
+    return false;
+  parsing_fail (state, string ("failed parsing attribute ") + attributeName + " of element " + state.stream.name
+                       + ": '" + value + "' is not a boolean");
+  return false;
+}
 
-  auto time = getAttribute<float> (*extended_translate, "time");
-  auto align = getAttribute<bool> (*extended_translate, "align");
+//! Skips the element just started, with all it holds.
+void parsing_skip (struct parsing_state &state)
+{
+  state.stack.push_back ({CONTEXT_SKIPPED});
+}
 
-  operations.push_back ((float) time);
-  operations.push_back ((float) align);
-  operations.push_back (0); // create space to insert the number of points
-  auto index_of_number_of_points = operations.size () - 1;
+//! Starts lights, transforms or models, which are moved in place when they end if they come late.
+void parsing_begin_header (struct parsing_state &state, const enum parsing_context context)
+{
+  struct parsing_frame header = {context};
+  header.begin = state.operations.size ();
+  state.stack.push_back (header);
+}
 
-  int number_of_points = 0;
-  for (auto child = extended_translate->FirstChildElement ("point"); child; child = child->NextSiblingElement ("point"))
-    {
-      ++number_of_points;
-      operations_push_transform_attributes (*child, operations);
-    }
-  operations[index_of_number_of_points] = (float) number_of_points;
+void parsing_end_header (struct parsing_state &state, const struct parsing_frame &header)
+{
+  vector<float> &operations = state.operations;
+  struct parsing_frame &parent = state.stack.back ();
+  const size_t length = operations.size () - header.begin;
+  const size_t place = header.context == CONTEXT_TRANSFORM ? parent.transforms_end : parent.header_end;
+  std::rotate (operations.begin () + (long) place, operations.begin () + (long) header.begin, operations.end ());
+  if (header.context == CONTEXT_TRANSFORM)
+    parent.transforms_end += length;
+  parent.header_end += length;
+  // the groups split off after the place, the last ones, move along
+  if (state.subtrees)
+    for (auto subtree = state.subtrees->rbegin (); subtree != state.subtrees->rend () && subtree->position >= place;
+         ++subtree)
+      subtree->position += length;
 }
 
-void operations_push_transformation (const XMLElement *const transformation, vector<float> &operations)
+/*! @addtogroup Transforms
+ * @{*/
+
+void operations_push_transform_attributes (const struct parsing_state &state, vector<float> &operations)
 {
-  assert (transformation != nullptr);
-  const string transformation_name = transformation->Value ();
+  float angle;
+  if (queryFloatAttribute (state, "angle", angle))
+    operations.push_back (angle);
+  for (const char *const attribute_name: {"x", "y", "z"})
+    operations.push_back (getFloatAttribute (state, attribute_name));
+}
+
+void operations_push_transformation (struct parsing_state &state)
+{
+  vector<float> &operations = state.operations;
+  const string &transformation_name = state.stream.name;
+  const bool extended = xml_stream_attribute (state.stream, "time");
 
   if ("translate" == transformation_name)
     {
-      if (transformation->Attribute ("time") != nullptr)
+      if (extended)
         {
           operations.push_back (EXTENDED_TRANSLATE);
-          cerr << "[parsing] EXTENDED_TRANSLATE" << endl;
-          operations_push_extended_translate_attributes (transformation, operations);
-        }
-      else
-        {
-          operations.push_back (TRANSLATE);
-          cerr << "[parsing] TRANSLATE" << endl;
-          operations_push_transform_attributes (*transformation, operations);
+          operations.push_back (getFloatAttribute (state, "time"));
+          operations.push_back ((float) getBoolAttribute (state, "align"));
+          // the number of points, counted as they are read
+          struct parsing_frame points = {CONTEXT_POINTS};
+          points.points = operations.size ();
+          operations.push_back (0);
+          state.stack.push_back (points);
+          return;
         }
+      operations.push_back (TRANSLATE);
+      operations_push_transform_attributes (state, operations);
     }
   else if ("rotate" == transformation_name)
     {
-      if (transformation->Attribute ("time"))
+      if (extended)
         {
           operations.push_back (EXTENDED_ROTATE);
-          cerr << "[parsing] EXTENDED_ROTATE" << endl;
-          auto time = getAttribute<float> (*transformation, "time");
-          operations.push_back (time);
-          operations_push_transform_attributes (*transformation, operations);
+          operations.push_back (getFloatAttribute (state, "time"));
         }
       else
-        {
-          operations.push_back (ROTATE);
-          cerr << "[parsing] ROTATE" << endl;
-          operations_push_transform_attributes (*transformation, operations);
-        }
+        operations.push_back (ROTATE);
+      operations_push_transform_attributes (state, operations);
     }
   else if ("scale" == transformation_name)
     {
       operations.push_back (SCALE);
-      cerr << "[parsing] SCALE" << endl;
-      operations_push_transform_attributes (*transformation, operations);
+      operations_push_transform_attributes (state, operations);
     }
   else
-    {
-      cerr << "[parsing] Unknown transformation: \"" << transformation_name << "\"" << endl;
-      exit (EXIT_FAILURE);
-    }
+    parsing_fail (state, "Unknown transformation: \"" + transformation_name + "\"");
+  parsing_skip (state);
 }
 
-void operations_push_transforms (const XMLElement *const transforms, vector<float> &operations)
+//! A point of the extended translation on top of the stack.
+void operations_push_point (struct parsing_state &state)
 {
-  const XMLElement *transform = transforms->FirstChildElement ();
-  do
-    operations_push_transformation (transform, operations);
-  while ((transform = transform->NextSiblingElement ()));
+  const size_t points = state.stack.back ().points;
+  operations_push_transform_attributes (state, state.operations);
+  ++state.operations[points];
+  parsing_skip (state);
 }
 //! @} end of group Transforms
 
@@ -240,371 +377,647 @@ void operations_push_transforms (const XMLElement *const transforms, vector<floa
  * @{
  */
 
-int operations_push_string_attribute (
-    const XMLElement *const element,
-    vector<float> &operations,
-    const char *const attribute_name)
+//! The number of characters of a file name and its characters; the file is checked for once the world is read.
+void operations_push_file_name (struct parsing_state &state, const string &file, vector<float> &operations)
 {
+  if (state.files.insert (file).second)
+    state.file_order.push_back (file);
+  operations.push_back ((float) file.size ());
+  operations.insert (operations.end (), file.begin (), file.end ());
+}
 
-  const char *const element_attribute_value = element->Attribute (attribute_name);
-  if (element_attribute_value == nullptr)
+void operations_generate_model (const struct parsing_state &state, const char *const model_name,
+                                const char *const generator_argv)
+{
+  cerr << "[parsing] generating model " << model_name << endl;
+#ifndef USE_SYSTEM
+  int stat;
+  if ((stat = fork ()) == 0)
     {
-      cerr << "[parsing] [operations_push_string_attribute] failed: attrbute " << attribute_name << " does not exist"
-           << endl;
-      exit (EXIT_FAILURE);
+      wordexp_t p;
+      wordexp ("generator", &p, WRDE_NOCMD | WRDE_UNDEF);
+      if (wordexp (generator_argv, &p, WRDE_NOCMD | WRDE_UNDEF | WRDE_APPEND))
+        {
+          cerr << "[parsing] failed argv expansion for model " << model_name << endl;
+          exit (EXIT_FAILURE);
+        }
+      execv (globalGeneratorExecutable, p.we_wordv);
+      perror ("[operations_generate_model child] generator failed");
+      _exit (EXIT_FAILURE);
     }
-  if (access (element_attribute_value, F_OK))
+  else if (stat == -1)
     {
-      cerr << "[parsing] file " << element_attribute_value << " not found" << endl;
-      exit (EXIT_FAILURE);
+      perror ("[operations_generate_model] ");
+      parsing_fail (state, string ("failed running the generator at model ") + model_name);
     }
-  int i = 0;
-  do
-    operations.push_back (element_attribute_value[i++]);
-  while (element_attribute_value[i]);
-  // add number of characters of element attribute string value
-  operations.insert (operations.end () - i, (float) i);
-  return i;
+  int status;
+  wait (&status);
+  if (WIFEXITED(status) && WEXITSTATUS(status))
+    parsing_fail (state, string ("generator failed at model ") + model_name);
+#else
+  std::stringstream command;
+  command << current_path() << "/" << globalGeneratorExecutable << " " << generator_argv;
+  if(system(command.str().data()))
+    parsing_fail (state, string ("generator failed at model ") + model_name);
+#endif
 }
 
-void operations_push_model (const XMLElement *const model, vector<float> &operations)
+void operations_begin_model (struct parsing_state &state)
 {
-  operations.push_back (BEGIN_MODEL);
-  {
+  struct parsing_model &model = state.model;
+  model.file = getStringAttribute (state, "file");
+  model.generator = model.has_argv = model.texture = model.has_shininess = false;
+  std::fill (std::begin (model.has_color), std::end (model.has_color), false);
+  state.stack.push_back ({CONTEXT_MODEL});
+}
+
+//! A generator, texture or color of the model being read.
+void operations_model_child (struct parsing_state &state)
+{
+  struct parsing_model &model = state.model;
+  const string &name = state.stream.name;
+  if ("generator" == name && parsing_first (state, SEEN_GENERATOR))
+    {
+      model.generator = true;
+      const char *const argv = xml_stream_attribute (state.stream, "argv");
+      model.has_argv = argv;
+      if (argv)
+        model.argv = argv;
+    }
+  else if ("texture" == name && parsing_first (state, SEEN_TEXTURE))
+    {
+      model.texture = true;
+      model.texture_file = getStringAttribute (state, "file");
+    }
+  else if ("color" == name && parsing_first (state, SEEN_COLOR))
+    {
+      state.stack.push_back ({CONTEXT_COLOR});
+      return;
+    }
+  parsing_skip (state);
+}
 
-    const char *const model_name = model->Attribute ("file");
-    if (model_name == nullptr)
+//! A material color component of the model being read.
+void operations_color_child (struct parsing_state &state)
+{
+  struct parsing_model &model = state.model;
+  const string &name = state.stream.name;
+  for (int c = 0; c < COLORS; ++c)
+    if (colorNames[c] == name && parsing_first (state, SEEN_DIFFUSE << c))
       {
-        cerr << "[parsing] [operations_push_string_attribute] failed: attrbute file does not exist" << endl;
-        exit (EXIT_FAILURE);
+        const float RGB_MAX = 255.0f;
+        model.has_color[c] = true;
+        model.color[c][0] = getFloatAttribute (state, "R") / RGB_MAX;
+        model.color[c][1] = getFloatAttribute (state, "G") / RGB_MAX;
+        model.color[c][2] = getFloatAttribute (state, "B") / RGB_MAX;
       }
+  if ("shininess" == name && parsing_first (state, SEEN_SHININESS))
+    {
+      model.has_shininess = true;
+      model.shininess = getFloatAttribute (state, "value");
+    }
+  parsing_skip (state);
+}
 
-    cerr << "[parsing]: BEGIN_MODEL(" << model_name << ")" << endl;
-
-    // generate model if specified
-    const XMLElement *const generator = model->FirstChildElement ("generator");
+void operations_push_model (struct parsing_state &state)
+{
+  const struct parsing_model &model = state.model;
+  vector<float> &operations = state.operations;
+  ++state.models;
+  operations.push_back (BEGIN_MODEL);
+  if (globalUsingGenerator && model.generator)
+    {
+      if (!model.has_argv)
+        parsing_fail (state, "failed parsing argv attribute of generator at model " + model.file);
+      operations_generate_model (state, model.file.c_str (), model.argv.c_str ());
+    }
+  if (model.file.empty ())
+    parsing_fail (state, "filename is empty");
+  operations_push_file_name (state, model.file, operations);
 
-    if (globalUsingGenerator && generator != nullptr)
-      {
-        cerr << "[parsing] generating model " << model_name << endl;
-        const char *generator_argv[10];
-        if (generator->QueryStringAttribute ("argv", generator_argv))
-          {
-            cerr << "failed parsing argv attribute of generator at model " << model_name << endl;
-            exit (EXIT_FAILURE);
-          }
-#ifndef USE_SYSTEM
-        int stat;
-        if ((stat = fork ()) == 0)
-          {
-            wordexp_t p;
-            wordexp ("generator", &p, WRDE_NOCMD | WRDE_UNDEF);
-            if (wordexp (*generator_argv, &p, WRDE_NOCMD | WRDE_UNDEF | WRDE_APPEND))
-              {
-                cerr << "[parsing] failed argv expansion for model " << model_name << endl;
-                exit (EXIT_FAILURE);
-              }
-            execv (globalGeneratorExecutable, p.we_wordv);
-            perror ("[operations_push_model child] generator failed");
-            _exit (EXIT_FAILURE);
-          }
-        else if (stat == -1)
-          {
-            perror ("[operations_push_model] ");
-            exit (EXIT_FAILURE);
-          }
-        int status;
-        wait (&status);
-        if (WIFEXITED(status) && WEXITSTATUS(status))
-          {
-            perror ("[operations_push_model] generator failed");
-            exit (EXIT_FAILURE);
-          }
-      }
-#else
-    std::stringstream command;
-    command << current_path() << "/" << globalGeneratorExecutable << " " << *generator_argv;
-    if(system(command.str().data()))
+  if (model.texture)
+    {
+      operations.push_back (TEXTURE);
+      operations_push_file_name (state, model.texture_file, operations);
+    }
+  for (int c = 0; c < COLORS; ++c)
+    if (model.has_color[c])
       {
-        cerr << "generator failed at model " << model_name << endl;
-        exit(EXIT_FAILURE);
+        operations.push_back (colorTypes[c]);
+        operations.insert (operations.end (), std::begin (model.color[c]), std::end (model.color[c]));
       }
-#endif
-    const int string_len = operations_push_string_attribute (model, operations, "file");
+  if (model.has_shininess)
+    operations.insert (operations.end (), {SHININESS, model.shininess});
+  operations.push_back (END_MODEL);
+}
+//! @} end of group Models
 
-    if (string_len <= 0)
-      {
-        fprintf (stderr, "[parsing] filename is empty");
-        exit (EXIT_FAILURE);
-      }
-  }
+/*! @addtogroup Groups
+ * @{*/
+
+//! @param[in] split whether its groups are to be split off.
+void operations_begin_group (struct parsing_state &state, const bool split = false)
+{
+  ++state.groups;
+  state.operations.push_back (BEGIN_GROUP);
+  struct parsing_frame group = {CONTEXT_GROUP};
+  group.transforms_end = group.header_end = state.operations.size ();
+  group.split = split;
+  state.stack.push_back (group);
+}
 
-  //texture
-  const XMLElement *const texture = model->FirstChildElement ("texture");
-  if (texture != nullptr)
+//! Skims over a group just started, to be read apart, leaving a place for it in the operations.
+void operations_split_group (struct parsing_state &state)
+{
+  // nothing to read apart in an empty group
+  if (state.stream.closing)
     {
-      operations.push_back (TEXTURE);
-      operations_push_string_attribute (texture, operations, "file");
+      operations_begin_group (state);
+      return;
     }
-  //color (material colors)
-  const XMLElement *const color = model->FirstChildElement ("color");
-  if (color != nullptr)
+  struct parsing_subtree subtree;
+  subtree.begin = xml_stream_offset (state.stream);
+  subtree.line = xml_stream_line (state.stream);
+  subtree.position = state.operations.size ();
+  if (!xml_stream_skip (state.stream))
     {
-      const int n = 4;
-      const char *const colorNames[n] = {"diffuse", "ambient", "specular", "emissive"};
-      const operation_t colorTypes[n] = {DIFFUSE, AMBIENT, SPECULAR, EMISSIVE};
-      for (int c = 0; c < n; ++c)
-        {
-          const XMLElement *const color_comp = color->FirstChildElement (colorNames[c]);
-          if (color_comp != nullptr)
-            {
-              const float RGB_MAX = 255.0f;
-              operations.push_back (colorTypes[c]);
-              float R;
-              if (color_comp->QueryFloatAttribute ("R", &R))
-                {
-                  cerr << "[parsing] failed parsing R component" << endl;
-                  exit (EXIT_FAILURE);
-                }
-              float G;
-              if (color_comp->QueryFloatAttribute ("G", &G))
-                {
-                  cerr << "[parsing] failed parsing G component" << endl;
-                  exit (EXIT_FAILURE);
-                }
-              float B;
-              if (color_comp->QueryFloatAttribute ("B", &B))
-                {
-                  cerr << "[parsing] failed parsing B component" << endl;
-                  exit (EXIT_FAILURE);
-                }
-              operations.insert (operations.end (),
-                                 {R / RGB_MAX, G / RGB_MAX, B / RGB_MAX});
-            }
-        }
-      const XMLElement *const shininess = color->FirstChildElement ("shininess");
-      if (shininess != nullptr)
-        {
-          operations.push_back (SHININESS);
-          float value;
-          if (shininess->QueryFloatAttribute ("value", &value))
-            {
-              cerr << "[parsing] failed parsing value attribute of shininess" << endl;
-              exit (EXIT_FAILURE);
-            }
-          operations.push_back (value);
-        }
+      // read up to there, for its errors before to come first
+      subtree.end = xml_stream_offset (state.stream);
+      subtree.cut = true;
+      state.subtrees->push_back (std::move (subtree));
+      parsing_fail_stream (state);
     }
+  subtree.end = xml_stream_offset (state.stream);
+  state.subtrees->push_back (std::move (subtree));
+}
 
-  operations.push_back (END_MODEL);
+//! A transform, models or group of the group on top of the stack.
+void operations_group_child (struct parsing_state &state)
+{
+  const string &name = state.stream.name;
+  if ("transform" == name && parsing_first (state, SEEN_TRANSFORM))
+    parsing_begin_header (state, CONTEXT_TRANSFORM);
+  else if ("models" == name && parsing_first (state, SEEN_MODELS))
+    parsing_begin_header (state, CONTEXT_MODELS);
+  else if ("group" == name && state.stack.back ().split)
+    operations_split_group (state);
+  else if ("group" == name)
+    operations_begin_group (state);
+  else
+    parsing_skip (state);
 }
+//! @} end of group Groups
 
-void operations_push_models (const XMLElement *const models, vector<float> &operations)
+void operations_push_light (struct parsing_state &state)
 {
-  const XMLElement *model = models->FirstChildElement ("model");
-  do
-    operations_push_model (model, operations);
-  while ((model = model->NextSiblingElement ("model")));
+  vector<float> &operations = state.operations;
+  const char *const lightType = getStringAttribute (state, "type");
+  if (!strcmp (lightType, "point"))
+    {
+      operations.push_back (POINT);
+      for (const char *const attribute_name: {"posX", "posY", "posZ"})
+        operations.push_back (getFloatAttribute (state, attribute_name));
+      // optional, lights with a range are only shaded where they reach
+      float range = 0;
+      queryFloatAttribute (state, "range", range);
+      operations.push_back (range);
+    }
+  else if (!strcmp (lightType, "directional"))
+    {
+      operations.push_back (DIRECTIONAL);
+      for (const char *const attribute_name: {"dirX", "dirY", "dirZ"})
+        operations.push_back (getFloatAttribute (state, attribute_name));
+    }
+  else if (!strcmp (lightType, "spotlight"))
+    {
+      operations.push_back (SPOTLIGHT);
+      for (const char *const attribute_name: {"posX", "posY", "posZ", "dirX", "dirY", "dirZ", "cutoff"})
+        operations.push_back (getFloatAttribute (state, attribute_name));
+      float range = 0;
+      queryFloatAttribute (state, "range", range);
+      operations.push_back (range);
+    }
+  else
+    parsing_fail (state, string ("Unkown light type: ") + lightType);
+  parsing_skip (state);
 }
-//! @} end of group Models
 
-/*! @addtogroup Groups
- * @{*/
-void operations_push_groups (const XMLElement &group, vector<float> &operations)
+//! Sets the generator models are generated with, which must come before them.
+void operations_set_generator (struct parsing_state &state)
 {
-  operations.push_back (BEGIN_GROUP);
+  if (state.stack.back ().seen & SEEN_GROUP)
+    parsing_fail (state, "the generator must come before the group");
+  const char *const generator_executable = getStringAttribute (state, "dir");
+  if (access (generator_executable, F_OK))
+    parsing_fail (state, string ("generator ") + generator_executable + " not found");
+  cerr << "[parsing] using generator " << generator_executable << endl;
+  strncpy (globalGeneratorExecutable, generator_executable, BUFSIZ - 1);
+  globalUsingGenerator = true;
+}
 
-  // Inside "transform" tag there can be multiple transformations.
-  const XMLElement *const transforms = group.FirstChildElement ("transform");
-  const XMLElement *const models = group.FirstChildElement ("models");
+//! A camera, lights, generator or group of the world.
+void operations_world_child (struct parsing_state &state)
+{
+  const string &name = state.stream.name;
+  if ("camera" == name && parsing_first (state, SEEN_CAMERA))
+    {
+      state.stack.push_back ({CONTEXT_CAMERA});
+      return;
+    }
+  if ("lights" == name && parsing_first (state, SEEN_LIGHTS))
+    {
+      parsing_begin_header (state, CONTEXT_LIGHTS);
+      return;
+    }
+  if ("generator" == name && parsing_first (state, SEEN_GENERATOR))
+    operations_set_generator (state);
+  else if ("group" == name && parsing_first (state, SEEN_GROUP))
+    {
+      // models are generated one after another, as they are read
+      operations_begin_group (state, state.subtrees && !globalUsingGenerator);
+      return;
+    }
+  parsing_skip (state);
+}
 
-  if (transforms)
-    operations_push_transforms (transforms, operations);
-  if (models)
-    operations_push_models (models, operations);
+//! A position, lookAt, up or projection of the camera, in place of the defaults set when the world began.
+void operations_camera_child (struct parsing_state &state)
+{
+  float *const camera = state.operations.data () + state.camera;
+  const string &name = state.stream.name;
+  const char *const vectors[] = {"position", "lookAt", "up"};
+  const unsigned int seen[] = {SEEN_POSITION, SEEN_LOOK_AT, SEEN_UP};
+  const char *const components[] = {"x", "y", "z"};
+  for (int v = 0; v < 3; ++v)
+    if (vectors[v] == name && parsing_first (state, seen[v]))
+      for (int c = 0; c < 3; ++c)
+        camera[3 * v + c] = getFloatAttribute (state, components[c]);
+  if ("projection" == name && parsing_first (state, SEEN_PROJECTION))
+    {
+      camera[9] = getFloatAttribute (state, "fov");
+      camera[10] = getFloatAttribute (state, "near");
+      camera[11] = getFloatAttribute (state, "far");
+    }
+  parsing_skip (state);
+}
 
-  const XMLElement *childGroup = group.FirstChildElement ("group");
-  if (childGroup)
-    do
-      operations_push_groups (*childGroup, operations);
-    while ((childGroup = childGroup->NextSiblingElement ("group")));
+void operations_begin_world (struct parsing_state &state)
+{
+  state.camera = state.operations.size ();
+  // position and lookAt are required, up and the projection have defaults
+  state.operations.insert (state.operations.end (), {0, 0, 0, 0, 0, 0, 0, 1, 0, 60, 1, 1000});
+  struct parsing_frame world = {CONTEXT_WORLD};
+  world.header_end = state.operations.size ();
+  state.stack.push_back (world);
+}
 
-  operations.push_back (END_GROUP);
+//! Turns the element just started into operations, or has it skipped.
+void parsing_start (struct parsing_state &state)
+{
+  switch (state.stack.back ().context)
+    {
+      case CONTEXT_DOCUMENT:
+        if ("world" == state.stream.name && parsing_first (state, SEEN_WORLD))
+          operations_begin_world (state);
+        else
+          parsing_skip (state);
+      break;
+      case CONTEXT_WORLD:
+        operations_world_child (state);
+      break;
+      case CONTEXT_CAMERA:
+        operations_camera_child (state);
+      break;
+      case CONTEXT_LIGHTS:
+        // whatever its name, every element of the lights is one
+        operations_push_light (state);
+      break;
+      case CONTEXT_GROUP:
+        operations_group_child (state);
+      break;
+      case CONTEXT_TRANSFORM:
+        operations_push_transformation (state);
+      break;
+      case CONTEXT_POINTS:
+        if ("point" == state.stream.name)
+          operations_push_point (state);
+        else
+          parsing_skip (state);
+      break;
+      case CONTEXT_MODELS:
+        if ("model" == state.stream.name)
+          operations_begin_model (state);
+        else
+          parsing_skip (state);
+      break;
+      case CONTEXT_MODEL:
+        operations_model_child (state);
+      break;
+      case CONTEXT_COLOR:
+        operations_color_child (state);
+      break;
+      case CONTEXT_SKIPPED:
+        parsing_skip (state);
+      break;
+    }
 }
-//! @} end of group Groups
 
-/*! @addtogroup xml
- *@{*/
+//! Completes the operations of the element just ended.
+void parsing_end (struct parsing_state &state)
+{
+  const struct parsing_frame frame = state.stack.back ();
+  state.stack.pop_back ();
+  switch (frame.context)
+    {
+      case CONTEXT_WORLD:
+        if (!(frame.seen & SEEN_CAMERA))
+          parsing_fail (state, "the world has no camera");
+        if (!(frame.seen & SEEN_GROUP))
+          parsing_fail (state, "the world has no group");
+      break;
+      case CONTEXT_CAMERA:
+        if (!(frame.seen & SEEN_POSITION) || !(frame.seen & SEEN_LOOK_AT))
+          parsing_fail (state, "the camera needs a position and a lookAt");
+      break;
+      case CONTEXT_LIGHTS:
+      case CONTEXT_TRANSFORM:
+      case CONTEXT_MODELS:
+        parsing_end_header (state, frame);
+      break;
+      case CONTEXT_GROUP:
+        state.operations.push_back (END_GROUP);
+      break;
+      case CONTEXT_MODEL:
+        operations_push_model (state);
+      break;
+      default:
+        break;
+    }
+}
 
+/*!
+ * Checks for every model and texture file at once, each only once however many
+ * models refer to it, telling all that are missing.
+ * @return whether none is.
+ */
+bool operations_check_files (const struct parsing_state &state)
+{
+  vector<string> missing;
+  for (const string &file: state.files)
+    if (access (file.c_str (), F_OK))
+      missing.push_back (file);
+  if (missing.empty ())
+    return true;
+  std::sort (missing.begin (), missing.end ());
+  for (const string &file: missing)
+    cerr << "[parsing] file " << file << " not found" << endl;
+  return false;
+}
 
-void operations_push_lights (const XMLElement *const lights, vector<float> &operations)
+//! Reads the events of the stream into operations up to its end.
+void parsing_run (struct parsing_state &state)
 {
-  const XMLElement *light = lights->FirstChildElement ();
-  do
+  for (;;)
     {
-      const char *lightType[2];
-      if (light->QueryStringAttribute ("type", lightType))
-        {
-          cerr << "failed parsing type attribute of light" << endl;
-          exit (EXIT_FAILURE);
-        }
-      if (!strcmp (*lightType, "point"))
-        {
-          operations.push_back (POINT);
-          float posX, posY, posZ;
-          if (light->QueryFloatAttribute ("posX", &posX)
-              | light->QueryFloatAttribute ("posY", &posY)
-              | light->QueryFloatAttribute ("posZ", &posZ))
-            {
-              cerr << "[parsing] Failed parsing POINT posX or posY or posZ" << endl;
-              exit (EXIT_FAILURE);
-            }
-          operations.insert (operations.end (), {posX, posY, posZ});
-
-        }
-      else if (!strcmp (*lightType, "directional"))
-        {
-          operations.push_back (DIRECTIONAL);
-          float dirX, dirY, dirZ;
-          if (light->QueryFloatAttribute ("dirX", &dirX)
-              | light->QueryFloatAttribute ("dirY", &dirY)
-              | light->QueryFloatAttribute ("dirZ", &dirZ))
-            {
-              cerr << "[parsing] Failed parsing DIRECTIONAL dirX or dirY or dirZ" << endl;
-              exit (EXIT_FAILURE);
-            }
-          operations.insert (operations.end (), {dirX, dirY, dirZ});
-        }
-      else if (!strcmp (*lightType, "spotlight"))
-        {
-          operations.push_back (SPOTLIGHT);
-          float posX, posY, posZ;
-          if (light->QueryFloatAttribute ("posX", &posX)
-              | light->QueryFloatAttribute ("posY", &posY)
-              | light->QueryFloatAttribute ("posZ", &posZ))
-            {
-              cerr << "[parsing] Failed parsing SPOTLIGHT posX or posY or posZ" << endl;
-              exit (EXIT_FAILURE);
-            }
-
-          float dirX, dirY, dirZ;
-          if (light->QueryFloatAttribute ("dirX", &dirX)
-              | light->QueryFloatAttribute ("dirY", &dirY)
-              | light->QueryFloatAttribute ("dirZ", &dirZ))
-            {
-              cerr << "[parsing] Failed parsing SPOTLIGHT dirX or dirY or dirZ" << endl;
-              exit (EXIT_FAILURE);
-            }
-          float cutoff;
-          if (light->QueryFloatAttribute ("cutoff", &cutoff))
-            {
-              cerr << "[parsing] Failed parsing SPOTLIGHT cutoff" << endl;
-              exit (EXIT_FAILURE);
-            }
-          operations.insert (operations.end (), {
-              posX, posY, posZ,
-              dirX, dirY, dirZ,
-              cutoff
-          });
-        }
+      const enum xml_event event = xml_stream_next (state.stream);
+      if (event == XML_START)
+        parsing_start (state);
+      else if (event == XML_END)
+        parsing_end (state);
+      else if (event == XML_EOF)
+        return;
       else
-        {
-          fprintf (stderr, "[parsing] Unkown light type: %s\n", lightType);
-          exit (EXIT_FAILURE);
-        }
+        parsing_fail_stream (state);
     }
-  while ((light = light->NextSiblingElement ()));
 }
 
-void operations_load_xml (const string &filename, vector<float> &operations)
+/*!
+ * Reads a group split off, but for its own groups when it is to be split in turn,
+ * keeping the error it fails with, if any, for parsing_read_subtrees to report.
+ */
+void parsing_subtree_read (const string &filename, struct xml_stream &stream, struct parsing_subtree &subtree)
 {
-  XMLDocument doc;
-
-  if (doc.LoadFile (filename.c_str ()))
+  struct parsing_state state = {filename, subtree.operations, stream};
+  state.deferred = true;
+  try
+    {
+      if (!xml_stream_open_range (stream, filename, subtree.begin, subtree.end - subtree.begin, subtree.line,
+                                  "group"))
+        parsing_fail_stream (state);
+      if (subtree.split)
+        state.subtrees = &subtree.children;
+      state.stack.push_back ({CONTEXT_SKIPPED});
+      operations_begin_group (state, subtree.split);
+      parsing_run (state);
+    }
+  catch (struct parsing_error &error)
     {
-      if (doc.ErrorID () == tinyxml2::XML_ERROR_FILE_NOT_FOUND)
-        cerr << "[parsing] Failed loading file: '" << filename << "'" << endl;
-      fprintf (stderr, "%s", doc.ErrorName ());
-      exit (EXIT_FAILURE);
+      // groups cut short fail at their end, where the error of the file that cut them is
+      if (!subtree.cut || error.offset < subtree.end)
+        subtree.error = std::move (error);
     }
+  subtree.files.swap (state.files);
+  subtree.file_order.swap (state.file_order);
+  subtree.groups = state.groups;
+  subtree.models = state.models;
+}
 
-  cerr << "[parsing] Loaded file: '" << filename << "'" << endl;
-  const XMLElement *const world = doc.FirstChildElement ("world");
-  cerr << "[parsing] Loaded element: '" << world->Value () << "'" << endl;
+//! Groups split off, to read apart, in the order of the file.
+struct parsing_subtrees {
+  const string &filename;
+  vector<struct parsing_subtree *> leaves{};
+};
 
-  /*camera*/
-  const XMLElement &camera = *world->FirstChildElement ("camera");
+void parsing_job_read (void *const data, const unsigned int begin, const unsigned int end)
+{
+  struct parsing_subtrees &subtrees = *(struct parsing_subtrees *) data;
+  struct xml_stream stream;
+  for (unsigned int s = begin; s < end; ++s)
+    parsing_subtree_read (subtrees.filename, stream, *subtrees.leaves[s]);
+  xml_stream_close (stream);
+}
 
-  const XMLElement &position = *camera.FirstChildElement ("position");
-  operations_push_transform_attributes (position, operations);
+/*!
+ * Splits in turn the groups split off larger than a share of the file, reading them
+ * apart from their own groups, and lists those left to read.
+ */
+void parsing_subtrees_split (const string &filename, struct xml_stream &stream, vector<struct parsing_subtree> &split,
+                             const size_t share, vector<struct parsing_subtree *> &leaves)
+{
+  for (struct parsing_subtree &subtree: split)
+    if (subtree.end - subtree.begin > share)
+      {
+        subtree.split = true;
+        parsing_subtree_read (filename, stream, subtree);
+        parsing_subtrees_split (filename, stream, subtree.children, share, leaves);
+      }
+    else
+      leaves.push_back (&subtree);
+}
 
-  const XMLElement *const lookAt = camera.FirstChildElement ("lookAt");
-  operations_push_transform_attributes (*lookAt, operations);
+//! Appends operations with the groups split off from them spliced in place, and adds up what they refer to.
+void parsing_splice (struct parsing_state &state, vector<float> &spliced, const vector<float> &operations,
+                     vector<struct parsing_subtree> &subtrees)
+{
+  size_t copied = 0;
+  for (struct parsing_subtree &subtree: subtrees)
+    {
+      spliced.insert (spliced.end (), operations.begin () + (long) copied, operations.begin () + (long) subtree.position);
+      copied = subtree.position;
+      parsing_splice (state, spliced, subtree.operations, subtree.children);
+      for (string &file: subtree.file_order)
+        if (state.files.insert (file).second)
+          state.file_order.push_back (std::move (file));
+      state.groups += subtree.groups;
+      state.models += subtree.models;
+      vector<float> ().swap (subtree.operations);
+    }
+  spliced.insert (spliced.end (), operations.begin () + (long) copied, operations.end ());
+}
 
-  const XMLElement *const up = camera.FirstChildElement ("up");
-  if (up)
-    operations_push_transform_attributes (*up, operations);
-  else
-    operations.insert (operations.end (), {0, 1, 0});
+size_t parsing_spliced_size (const vector<float> &operations, const vector<struct parsing_subtree> &subtrees)
+{
+  size_t size = operations.size ();
+  for (const struct parsing_subtree &subtree: subtrees)
+    size += parsing_spliced_size (subtree.operations, subtree.children);
+  return size;
+}
 
-  const XMLElement *const projection = camera.FirstChildElement ("projection");
-  if (projection)
+//! Keeps the error of the groups, or of those split off from them, that comes first in the file, before the one given.
+void parsing_first_error (const vector<struct parsing_subtree> &subtrees, struct parsing_error &first)
+{
+  for (const struct parsing_subtree &subtree: subtrees)
     {
-      float fov;
-      if (projection->QueryFloatAttribute ("fov", &fov))
-        {
-          cerr << "[parsing] Failed parsing fov" << endl;
-          exit (EXIT_FAILURE);
-        }
-      float near;
-      if (projection->QueryFloatAttribute ("near", &near))
-        {
-          cerr << "[parsing] Failed parsing near" << endl;
-          exit (EXIT_FAILURE);
-        }
-      float far;
-      if (projection->QueryFloatAttribute ("far", &far))
-        {
-          cerr << "[parsing] Failed parsing far" << endl;
-          exit (EXIT_FAILURE);
-        }
-      operations.insert (operations.end (), {fov, near, far});
+      if (subtree.error.offset < first.offset)
+        first = subtree.error;
+      parsing_first_error (subtree.children, first);
     }
-  else
-    operations.insert (operations.end (), {60, 1, 1000});
-  /*end of camera*/
+}
 
-  // lights
-  const XMLElement *const lights = world->FirstChildElement ("lights");
-  if (lights != nullptr)
-    operations_push_lights (lights, operations);
+/*!
+ * Reads the groups split off from the world's group, in parallel, and splices them
+ * in place. Errors are reported once every group is read, the first in the file,
+ * whichever thread met it, so as a single thread reading the file would.
+ * @param[in] error met reading the rest of the file, after the groups split off so far.
+ */
+bool parsing_read_subtrees (struct parsing_state &state, vector<struct parsing_subtree> &subtrees,
+                            struct job_system &jobs, const size_t file_size, struct parsing_error error)
+{
+  // few more groups than threads, so threads done early have some left to take
+  const size_t SUBTREES_PER_THREAD = 8;
+  struct parsing_subtrees leaves = {state.filename};
+  parsing_subtrees_split (state.filename, state.stream, subtrees,
+                          file_size / (SUBTREES_PER_THREAD * jobs.queues.size ()), leaves.leaves);
+  xml_stream_close (state.stream);
+
+  struct frame_arena arena;
+  job_parallel_for (jobs, arena, "parse", parsing_job_read, &leaves, (unsigned int) leaves.leaves.size ());
+  parsing_first_error (subtrees, error);
+  if (!error.message.empty ())
+    {
+      cerr << error.message << endl;
+      return false;
+    }
 
+  vector<float> spliced;
+  spliced.reserve (parsing_spliced_size (state.operations, subtrees));
+  parsing_splice (state, spliced, state.operations, subtrees);
+  state.operations.swap (spliced);
+  return true;
+}
 
-  // find generator if it exists
-  const XMLElement *const generator = world->FirstChildElement ("generator");
-  if (generator != nullptr)
+/*!
+ * Appends the operations of a world file. They are presized from the size of the
+ * file, which they are about an eighth of in floats, and the file is not logged
+ * element by element, so a world of millions of groups loads in time linear in
+ * its size.
+ *
+ * Unlike operations_load_xml, errors are told without exiting, so a scene reloaded
+ * while running can keep the world it had; the operations are then left partial.
+ * @param[in] jobs to read large files in parallel with, if any.
+ * @param[out] files the models and textures it refers to, in about the order they are, if wanted.
+ * @return whether the file was read without errors.
+ */
+bool operations_read_xml (const string &filename, vector<float> &operations, struct job_system *const jobs,
+                          vector<string> *const files)
+{
+  const size_t XML_BYTES_PER_OPERATION = 8;
+  // files read apart at least
+  const size_t XML_SPLIT_BYTES = 1 << 20;
+  struct xml_stream stream;
+  struct parsing_state state = {filename, operations, stream};
+  if (!xml_stream_open (stream, filename))
     {
-      const char *generator_executable[BUFSIZ];
-      if (generator->QueryStringAttribute ("dir", generator_executable))
-        {
-          cerr << "[parsing] failed parsing attribute dir of generator" << endl;
-          exit (EXIT_FAILURE);
-        }
-      if (access (*generator_executable, F_OK))
-        {
-          cerr << "[parsing] generator " << *generator_executable << " not found" << endl;
-          exit (EXIT_FAILURE);
-        }
-      cerr << "[parsing] using generator " << *generator_executable << endl;
-      strncpy (globalGeneratorExecutable, *generator_executable, BUFSIZ);
-      globalUsingGenerator = true;
+      cerr << "[parsing] Failed loading file: '" << filename << "'" << endl;
+      return false;
+    }
+  struct stat file_stat;
+  size_t file_size = 0;
+  if (!fstat (fileno (stream.fp), &file_stat))
+    file_size = (size_t) file_stat.st_size;
+  operations.reserve (operations.size () + file_size / XML_BYTES_PER_OPERATION);
+
+  vector<struct parsing_subtree> subtrees;
+  if (jobs && !jobs->workers.empty () && file_size >= XML_SPLIT_BYTES)
+    state.subtrees = &subtrees;
+  state.deferred = true;
+  state.stack.push_back ({CONTEXT_DOCUMENT});
+  struct parsing_error error;
+  try
+    {
+      parsing_run (state);
+      if (!(state.stack.back ().seen & SEEN_WORLD))
+        parsing_fail (state, "no world element");
+    }
+  catch (struct parsing_error &failed)
+    {
+      // the groups split off before it may fail first
+      error = std::move (failed);
+    }
+  bool read = true;
+  if (!subtrees.empty ())
+    read = parsing_read_subtrees (state, subtrees, *jobs, file_size, std::move (error));
+  else if (!error.message.empty ())
+    {
+      cerr << error.message << endl;
+      read = false;
     }
+  xml_stream_close (stream);
+
+  if (!read || !operations_check_files (state))
+    return false;
+  cerr << "[parsing] Loaded file: '" << filename << "', " << state.groups << " groups, " << state.models
+       << " models, " << state.files.size () << " files" << endl;
+  if (files)
+    files->swap (state.file_order);
+  return true;
+}
+
+//! Appends the operations of a world file as operations_read_xml does, exiting on errors.
+void operations_load_xml (const string &filename, vector<float> &operations, struct job_system *const jobs,
+                          vector<string> *const files)
+{
+  if (!operations_read_xml (filename, operations, jobs, files))
+    exit (EXIT_FAILURE);
+}
 
-  // groups
-  const XMLElement *const group = world->FirstChildElement ("group");
-  operations_push_groups (*group, operations);
+/*!
+ * Whether the file is well-formed XML, reporting where it is not without exiting,
+ * so that a scene being edited can be checked before it is reloaded.
+ */
+bool operations_xml_well_formed (const string &filename)
+{
+  struct xml_stream stream;
+  enum xml_event event = XML_ERROR;
+  if (xml_stream_open (stream, filename))
+    while ((event = xml_stream_next (stream)) != XML_EOF && event != XML_ERROR);
+  xml_stream_close (stream);
+  if (event == XML_EOF)
+    return true;
+  cerr << "[parsing] '" << filename << "': " << stream.error << endl;
+  return false;
 }
 
 //! @} end of group xml
 
-//! @} end of group Operations
\ No newline at end of file
+//! @} end of group Operations
@@ -1,9 +1,16 @@
 #ifndef PROJ_PARSING_H
 #define PROJ_PARSING_H
 
+#include <string>
 #include <vector>
 
-void operations_load_xml (const std::string &filename, std::vector<float> &operations);
+struct job_system;
+
+void operations_load_xml (const std::string &filename, std::vector<float> &operations,
+                          struct job_system *jobs = nullptr, std::vector<std::string> *files = nullptr);
+bool operations_read_xml (const std::string &filename, std::vector<float> &operations,
+                          struct job_system *jobs = nullptr, std::vector<std::string> *files = nullptr);
+bool operations_xml_well_formed (const std::string &filename);
 
 enum {
   TRANSLATE = 1,
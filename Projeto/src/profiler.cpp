@@ -0,0 +1,224 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "profiler.h"
+
+using std::cerr, std::endl, std::vector, std::string;
+
+/*! @addtogroup profiler
+ * @{
+ * Frame profiler, exporting to the Chrome trace format (chrome://tracing, ui.perfetto.dev).
+ *
+ * CPU spans are timed by profiler_scope objects around the phases of a frame.
+ * The ones issuing GL commands can also be timed on the GPU, with a pair of
+ * GL_TIMESTAMP queries; unlike GL_TIME_ELAPSED ones those may nest. Their
+ * results are only read once available, some frames later, so timing never
+ * stalls the pipeline. GPU timestamps are moved onto the CPU timeline with an
+ * offset measured at initialization.
+ *
+ * Events go to a ring buffer, so a long session keeps its latest frames.
+ * CPU spans may come from any thread: each one named by profiler_thread gets a track
+ * of its own, the others go to the main CPU track. GPU spans are timed from the GL
+ * thread only.
+ */
+
+const int TRACK_CPU = 1;
+const int TRACK_GPU = 2;
+
+//! GPU span waiting for its queries.
+struct profiler_pending {
+  const char *name;
+  uint64_t frame;
+  GLuint queries[2];
+};
+
+static struct {
+  vector<struct profiler_event> events = vector<struct profiler_event> (PROFILER_CAPACITY);
+  size_t next = 0;  // where the next event goes
+  size_t count = 0; // events held, at most PROFILER_CAPACITY
+  std::atomic<uint64_t> frame{0};
+  std::mutex mutex;           // guards the ring buffer and the track names
+  vector<string> tracks;      // names of the thread tracks, from TRACK_GPU + 1
+
+  bool gpu = false;
+  double gpu_offset = 0; // CPU microseconds at GPU timestamp 0
+  vector<struct profiler_pending> pending;
+  vector<GLuint> free_queries;
+} globalProfiler;
+
+static thread_local int globalProfilerTrack = TRACK_CPU;
+
+//! Monotonic time, in microseconds since an unspecified point.
+double profiler_now ()
+{
+  using namespace std::chrono;
+  return duration<double, std::micro> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+static GLuint profiler_query ()
+{
+  GLuint query;
+  if (globalProfiler.free_queries.empty ())
+    glGenQueries (1, &query);
+  else
+    {
+      query = globalProfiler.free_queries.back ();
+      globalProfiler.free_queries.pop_back ();
+    }
+  return query;
+}
+
+/*!
+ * Needs the GL context to be current.
+ * @param[in] gpu whether to time the GPU too, possible when timer queries (GL 3.3) are available.
+ */
+void profiler_init (const bool gpu)
+{
+  globalProfiler.gpu = gpu && glQueryCounter && glGetInteger64v;
+  if (gpu && !globalProfiler.gpu)
+    cerr << "[profiler] timer queries unsupported, GPU timing disabled" << endl;
+  if (!globalProfiler.gpu)
+    return;
+
+  GLint64 gpu_now;
+  glGetInteger64v (GL_TIMESTAMP, &gpu_now);
+  globalProfiler.gpu_offset = profiler_now () - gpu_now / 1000.0;
+}
+
+//! Has the spans of the calling thread go to a track of their own.
+void profiler_thread (const char *const name)
+{
+  const std::lock_guard<std::mutex> lock (globalProfiler.mutex);
+  globalProfiler.tracks.emplace_back (name);
+  globalProfilerTrack = TRACK_GPU + (int) globalProfiler.tracks.size ();
+}
+
+static void profiler_push (const struct profiler_event &event)
+{
+  globalProfiler.events[globalProfiler.next] = event;
+  globalProfiler.next = (globalProfiler.next + 1) % PROFILER_CAPACITY;
+  if (globalProfiler.count < PROFILER_CAPACITY)
+    ++globalProfiler.count;
+}
+
+//! Records a span already timed by the caller, e.g. added up over several calls.
+void profiler_add (const char *const name, const double begin, const double duration)
+{
+  const std::lock_guard<std::mutex> lock (globalProfiler.mutex);
+  profiler_push ({name, globalProfiler.frame, begin, duration, globalProfilerTrack});
+}
+
+static void profiler_collect (const bool wait)
+{
+  size_t done = 0;
+  for (const auto &pending : globalProfiler.pending)
+    {
+      // queries complete in order, so the first unavailable one ends the collection
+      GLint available = GL_TRUE;
+      if (!wait)
+        glGetQueryObjectiv (pending.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available)
+        break;
+
+      GLuint64 begin, end;
+      glGetQueryObjectui64v (pending.queries[0], GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v (pending.queries[1], GL_QUERY_RESULT, &end);
+      {
+        const std::lock_guard<std::mutex> lock (globalProfiler.mutex);
+        profiler_push ({pending.name, pending.frame, globalProfiler.gpu_offset + begin / 1000.0,
+                        (end - begin) / 1000.0, TRACK_GPU});
+      }
+
+      globalProfiler.free_queries.push_back (pending.queries[0]);
+      globalProfiler.free_queries.push_back (pending.queries[1]);
+      ++done;
+    }
+  globalProfiler.pending.erase (globalProfiler.pending.begin (), globalProfiler.pending.begin () + done);
+}
+
+//! Starts a new frame, collecting the GPU spans of previous ones that are ready.
+void profiler_frame_begin ()
+{
+  ++globalProfiler.frame;
+  if (globalProfiler.gpu)
+    profiler_collect (false);
+}
+
+//! Waits for every pending GPU span, to be called before the context goes away.
+void profiler_flush ()
+{
+  if (globalProfiler.gpu)
+    profiler_collect (true);
+}
+
+profiler_scope::profiler_scope (const char *const name, const bool gpu)
+    : name (name), begin (profiler_now ()), gpu_query (-1)
+{
+  if (gpu && globalProfiler.gpu)
+    {
+      const GLuint query = profiler_query ();
+      glQueryCounter (query, GL_TIMESTAMP);
+      gpu_query = (int) globalProfiler.pending.size ();
+      globalProfiler.pending.push_back ({name, globalProfiler.frame, {query, 0}});
+    }
+}
+
+profiler_scope::~profiler_scope ()
+{
+  if (gpu_query >= 0)
+    {
+      const GLuint query = profiler_query ();
+      glQueryCounter (query, GL_TIMESTAMP);
+      globalProfiler.pending[gpu_query].queries[1] = query;
+    }
+  profiler_add (name, begin, profiler_now () - begin);
+}
+
+/*!
+ * Writes the buffered events as a Chrome trace: CPU spans on one track, GPU spans on another,
+ * then a track per named thread.
+ * Does not touch GL, so it can run at exit, after the context is gone.
+ * @return whether the file could be written.
+ */
+bool profiler_export_chrome (const char *const path)
+{
+  FILE *const file = fopen (path, "w");
+  if (!file)
+    {
+      cerr << "[profiler] could not open '" << path << "' for writing" << endl;
+      return false;
+    }
+
+  fprintf (file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf (file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"engine\"}},\n");
+  fprintf (file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+  fprintf (file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+  const std::lock_guard<std::mutex> lock (globalProfiler.mutex);
+  for (size_t i = 0; i < globalProfiler.tracks.size (); ++i)
+    fprintf (file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+             TRACK_GPU + 1 + (int) i, globalProfiler.tracks[i].c_str ());
+  const size_t first = (globalProfiler.next + PROFILER_CAPACITY - globalProfiler.count) % PROFILER_CAPACITY;
+  for (size_t i = 0; i < globalProfiler.count; ++i)
+    {
+      const auto &event = globalProfiler.events[(first + i) % PROFILER_CAPACITY];
+      fprintf (file,
+               ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+               "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+               event.name, event.track == TRACK_GPU ? "gpu" : "cpu", event.track,
+               event.begin, event.duration, (unsigned long long) event.frame);
+    }
+  fprintf (file, "\n]}\n");
+
+  const bool written = !ferror (file);
+  fclose (file);
+  if (written)
+    cerr << "[profiler] " << globalProfiler.count << " events written to '" << path << "'" << endl;
+  return written;
+}
+
+//!@} end of group profiler
@@ -0,0 +1,40 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+#include <cstdint>
+
+const unsigned int PROFILER_CAPACITY = 1 << 16; // events kept, the oldest being overwritten
+
+//! Timed span of one frame, in microseconds of the CPU timeline.
+struct profiler_event {
+  const char *name = nullptr; // static string
+  uint64_t frame = 0;
+  double begin = 0;
+  double duration = 0;
+  int track = 1; // trace thread id: 1 for the CPU, 2 for the GPU, from 3 for named threads
+};
+
+/*!
+ * Times the enclosing scope on the CPU and, when asked, the GL commands issued
+ * within it on the GPU.
+ */
+struct profiler_scope {
+  explicit profiler_scope (const char *name, bool gpu = false);
+  ~profiler_scope ();
+
+  profiler_scope (const profiler_scope &) = delete;
+  profiler_scope &operator= (const profiler_scope &) = delete;
+
+ private:
+  const char *name;
+  double begin;
+  int gpu_query; // index of the pending GPU span, -1 when not timed on the GPU
+};
+
+void profiler_init (bool gpu);
+void profiler_frame_begin ();
+void profiler_flush ();
+double profiler_now ();
+void profiler_thread (const char *name);
+void profiler_add (const char *name, double begin, double duration);
+bool profiler_export_chrome (const char *path);
+#endif //_PROFILER_H_
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cmath>
+#include "render_queue.h"
+
+using std::vector;
+
+/*! @addtogroup renderQueue
+ * @{
+ * # Sort key
+ *
+ * @code{.unparsed}
+ *               63-62  61-56    55-40    39-24     23-0
+ * opaque:       pass   program  texture  material  depth
+ *               63-62  61-38    37-32    31-16     15-0
+ * transparent:  pass   ~depth   program  texture   material
+ * @endcode
+ *
+ * Opaque draws are grouped by state, most expensive change first, and front to
+ * back within the same state so early depth testing rejects hidden fragments.
+ * Transparent draws must be blended back to front, so depth comes first and is
+ * inverted; state only breaks ties.
+ */
+
+static const unsigned int DEPTH_BITS = 24;
+static const uint64_t DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+
+/*!
+ * @param[in] pass PASS_OPAQUE or PASS_TRANSPARENT.
+ * @param[in] program shader program, 6 bits.
+ * @param[in] texture texture object, 16 bits.
+ * @param[in] material material index, 16 bits.
+ * @param[in] depth distance to the camera normalized to [0, 1] (near to far).
+ */
+uint64_t render_key (const unsigned int pass,
+                     const unsigned int program,
+                     const unsigned int texture,
+                     const unsigned int material,
+                     const float depth)
+{
+  const auto quantized_depth = (uint64_t) (std::clamp (depth, 0.0f, 1.0f) * (float) DEPTH_MAX);
+  const uint64_t p = pass & 0x3u;
+  if (p == PASS_OPAQUE)
+    return p << 62
+           | (uint64_t) (program & 0x3fu) << 56
+           | (uint64_t) (texture & 0xffffu) << 40
+           | (uint64_t) (material & 0xffffu) << 24
+           | quantized_depth;
+  return p << 62
+         | (DEPTH_MAX - quantized_depth) << 38
+         | (uint64_t) (program & 0x3fu) << 32
+         | (uint64_t) (texture & 0xffffu) << 16
+         | (uint64_t) (material & 0xffffu);
+}
+
+unsigned int render_key_pass (const uint64_t key)
+{
+  return (unsigned int) (key >> 62);
+}
+
+void render_queue_sort (vector<struct draw_packet> &queue)
+{
+  std::sort (queue.begin (), queue.end (),
+             [] (const struct draw_packet &a, const struct draw_packet &b)
+             { return a.key < b.key; });
+}
+
+//!@} end of group renderQueue
@@ -0,0 +1,21 @@
+#ifndef _RENDER_QUEUE_H_
+#define _RENDER_QUEUE_H_
+#include <cstdint>
+#include <vector>
+
+enum {
+  PASS_OPAQUE = 0,
+  PASS_TRANSPARENT
+};
+
+//! One draw collected during the traversal, submitted after the queue is sorted.
+struct draw_packet {
+  uint64_t key;
+  unsigned int model; // index of the model to draw
+};
+
+uint64_t render_key (unsigned int pass, unsigned int program, unsigned int texture, unsigned int material,
+                     float depth);
+unsigned int render_key_pass (uint64_t key);
+void render_queue_sort (std::vector<struct draw_packet> &queue);
+#endif //_RENDER_QUEUE_H_
@@ -0,0 +1,179 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "models.h"
+#include "scene_synth.h"
+
+using std::string, std::to_string, std::cerr, std::endl;
+
+/*! @addtogroup scene_synth
+ * @{
+ * Synthetic scenes of any size, to see how the engine scales with the number of groups.
+ *
+ * Every group orbits its parent at a quarter of its size, at a static angle or, for the
+ * animated fraction of the groups, with time: half of those rotating, half following a
+ * Catmull-Rom curve. Groups draw the models model_⟨n⟩.3d (spheres, boxes and cones) and
+ * textures texture_⟨n⟩.ppm in turn, so the unique resources stay few however many groups
+ * there are. The same seed always writes the same scene.
+ *
+ * Paths in the scene are relative to its directory, which the engine must be run from.
+ */
+
+const float CHILD_SCALE = 0.25f;
+
+//! Uniform in [0, 1).
+static float random_unit (std::mt19937 &random)
+{
+  return (float) (random () >> 8) * 0x1p-24f;
+}
+
+static FILE *scene_synth_open (const string &path)
+{
+  FILE *fp = fopen (path.c_str (), "w");
+  if (!fp)
+    {
+      cerr << "[scene_synth] failed to open '" << path << "'" << endl;
+      exit (EXIT_FAILURE);
+    }
+  return fp;
+}
+
+//! A checkerboard of a random colour and white.
+static void scene_synth_texture (const string &path, std::mt19937 &random)
+{
+  const int SIZE = 64, SQUARE = 8;
+  const unsigned char color[3] = {(unsigned char) (random () % 256), (unsigned char) (random () % 256),
+                                  (unsigned char) (random () % 256)};
+  FILE *fp = scene_synth_open (path);
+  fprintf (fp, "P6\n%d %d\n255\n", SIZE, SIZE);
+  for (int y = 0; y < SIZE; ++y)
+    for (int x = 0; x < SIZE; ++x)
+      {
+        const bool white = (x / SQUARE + y / SQUARE) % 2;
+        for (int c = 0; c < 3; ++c)
+          fputc (white ? 255 : color[c], fp);
+      }
+  fclose (fp);
+}
+
+static void scene_synth_model (const string &path, const unsigned int n, const unsigned int resolution)
+{
+  // every model a little finer than the previous, so no two are the same
+  const unsigned int r = resolution + n / 3;
+  switch (n % 3)
+    {
+      case 0:
+        model_sphere_write (path.c_str (), 1, r, r);
+      break;
+      case 1:
+        model_cube_write (path.c_str (), 1.5f, r / 4 + 1);
+      break;
+      default:
+        model_cone_write (path.c_str (), 1, 2, r, r);
+    }
+}
+
+struct scene_synth_state {
+  FILE *fp;
+  const struct scene_synth_options &options;
+  std::mt19937 random;
+  uint64_t groups = 0;
+};
+
+static void scene_synth_group (struct scene_synth_state &state, const unsigned int level, const unsigned int index)
+{
+  const struct scene_synth_options &options = state.options;
+  const uint64_t n = state.groups++;
+  FILE *const fp = state.fp;
+
+  fprintf (fp, "<group>");
+  if (level > 0)
+    {
+      const float radius = 2 + 4 * (float) (index + 1) / (float) options.fanout;
+      const float period = 5 + 20 * random_unit (state.random);
+      fprintf (fp, "<transform><rotate angle=\"%g\" x=\"0\" y=\"1\" z=\"0\"/>", 360.0f * (float) index / (float) options.fanout);
+      if (random_unit (state.random) >= options.animated)
+        fprintf (fp, "<translate x=\"%g\" y=\"0\" z=\"0\"/>", radius);
+      else if (n % 2)
+        fprintf (fp, "<rotate time=\"%g\" x=\"0\" y=\"1\" z=\"0\"/><translate x=\"%g\" y=\"0\" z=\"0\"/>", period, radius);
+      else
+        {
+          fprintf (fp, "<translate time=\"%g\" align=\"false\">", period);
+          for (int p = 0; p < 4; ++p)
+            fprintf (fp, "<point x=\"%g\" y=\"%g\" z=\"%g\"/>", radius * cosf ((float) M_PI_2 * (float) p),
+                     0.2f * radius * (float) (p % 2), radius * sinf ((float) M_PI_2 * (float) p));
+          fprintf (fp, "</translate>");
+        }
+      fprintf (fp, "<scale x=\"%g\" y=\"%g\" z=\"%g\"/></transform>", CHILD_SCALE, CHILD_SCALE, CHILD_SCALE);
+    }
+
+  fprintf (fp, "<models><model file=\"model_%u.3d\">", (unsigned int) (n % options.models));
+  if (options.textures)
+    fprintf (fp, "<texture file=\"texture_%u.ppm\"/>", (unsigned int) (n % options.textures));
+  fprintf (fp, "<color><diffuse R=\"%u\" G=\"%u\" B=\"%u\"/></color></model></models>\n",
+           (unsigned int) (state.random () % 256), (unsigned int) (state.random () % 256),
+           (unsigned int) (state.random () % 256));
+
+  if (level < options.depth)
+    for (unsigned int child = 0; child < options.fanout; ++child)
+      scene_synth_group (state, level + 1, child);
+  fprintf (fp, "</group>");
+}
+
+//! Number of groups of a scene, the root included.
+uint64_t scene_synth_groups (const struct scene_synth_options &options)
+{
+  uint64_t groups = 0, level = 1;
+  for (unsigned int d = 0; d <= options.depth; ++d, level *= options.fanout)
+    groups += level;
+  return groups;
+}
+
+/*!
+ * Writes a scene, its models and its textures.
+ * @param[in] directory where all the files are written, which must exist.
+ * @param[in] scene file name of the scene.
+ * @return the number of groups written.
+ */
+uint64_t scene_synth_write (const string &directory, const string &scene, const struct scene_synth_options &options)
+{
+  if (options.models == 0)
+    {
+      cerr << "[scene_synth] a scene needs at least one model" << endl;
+      exit (EXIT_FAILURE);
+    }
+  struct scene_synth_state state = {scene_synth_open (directory + "/" + scene), options, std::mt19937 (options.seed)};
+
+  for (unsigned int m = 0; m < options.models; ++m)
+    scene_synth_model (directory + "/model_" + to_string (m) + ".3d", m, options.resolution);
+  for (unsigned int t = 0; t < options.textures; ++t)
+    scene_synth_texture (directory + "/texture_" + to_string (t) + ".ppm", state.random);
+
+  FILE *const fp = state.fp;
+  fprintf (fp, "<world>\n"
+               "<camera>\n"
+               "<position x=\"0\" y=\"12\" z=\"16\"/>\n"
+               "<lookAt x=\"0\" y=\"0\" z=\"0\"/>\n"
+               "<up x=\"0\" y=\"1\" z=\"0\"/>\n"
+               "<projection fov=\"60\" near=\"0.1\" far=\"1000\"/>\n"
+               "</camera>\n");
+  if (options.lights)
+    {
+      fprintf (fp, "<lights>\n");
+      for (unsigned int l = 0; l < options.lights; ++l)
+        fprintf (fp, "<light type=\"point\" posX=\"%g\" posY=\"%g\" posZ=\"%g\" range=\"8\"/>\n",
+                 16 * random_unit (state.random) - 8, 4 * random_unit (state.random),
+                 16 * random_unit (state.random) - 8);
+      fprintf (fp, "</lights>\n");
+    }
+  scene_synth_group (state, 0, 0);
+  fprintf (fp, "\n</world>\n");
+  fclose (fp);
+  return state.groups;
+}
+
+//!@} end of group scene_synth
@@ -0,0 +1,21 @@
+#ifndef _SCENE_SYNTH_H_
+#define _SCENE_SYNTH_H_
+#include <cstdint>
+#include <string>
+
+//! Shape of a synthetic scene: a tree of groups, every group orbiting its parent (moons of moons).
+struct scene_synth_options {
+  unsigned int depth = 3;       // levels of groups below the root
+  unsigned int fanout = 10;     // children of every group
+  float animated = 0.5f;        // fraction of the groups that orbit with time, half of them along curves
+  unsigned int models = 4;      // unique models, the groups repeat them in turn
+  unsigned int resolution = 16; // slices and stacks of the models
+  unsigned int textures = 0;    // textures, the groups repeat them in turn
+  unsigned int lights = 1;      // point lights, scattered over the scene
+  uint32_t seed = 1;
+};
+
+uint64_t scene_synth_groups (const struct scene_synth_options &options);
+uint64_t scene_synth_write (const std::string &directory, const std::string &scene,
+                            const struct scene_synth_options &options);
+#endif //_SCENE_SYNTH_H_
@@ -0,0 +1,80 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+#include "scene_synth.h"
+
+/*! @addtogroup scenegen
+ * @{
+ * Writes a synthetic scene for scale testing (see scene_synth), its models and
+ * textures alongside, and prints the number of groups it has.
+ * regress/scaling.sh renders them at growing sizes to plot how the engine scales.
+ */
+
+void usage ()
+{
+  fprintf (stderr, "usage: scenegen [-d depth] [-f fanout] [-a animated] [-m models] [-r resolution]\n"
+                   "                [-t textures] [-l lights] [-s seed] <scene.xml>\n"
+                   "  -d  levels of groups below the root (default 3)\n"
+                   "  -f  children of every group (default 10)\n"
+                   "  -a  fraction of groups animated (default 0.5)\n"
+                   "  -m  unique models (default 4)\n"
+                   "  -r  slices and stacks of the models (default 16)\n"
+                   "  -t  unique textures (default 0)\n"
+                   "  -l  point lights (default 1)\n"
+                   "  -s  random seed (default 1)\n"
+                   "The engine must be run from the directory of the scene.\n");
+  exit (EXIT_FAILURE);
+}
+
+/*!
+ * ⟨command⟩ ::= [-d ⟨depth⟩] [-f ⟨fanout⟩] [-a ⟨animated⟩] [-m ⟨models⟩] [-r ⟨resolution⟩]
+ *               [-t ⟨textures⟩] [-l ⟨lights⟩] [-s ⟨seed⟩] ⟨scene⟩
+ */
+int main (int argc, char **argv)
+{
+  struct scene_synth_options options;
+  int option;
+  while ((option = getopt (argc, argv, "d:f:a:m:r:t:l:s:")) != -1)
+    switch (option)
+      {
+        case 'd':
+          options.depth = strtoul (optarg, nullptr, 10);
+        break;
+        case 'f':
+          options.fanout = strtoul (optarg, nullptr, 10);
+        break;
+        case 'a':
+          options.animated = strtof (optarg, nullptr);
+        break;
+        case 'm':
+          options.models = strtoul (optarg, nullptr, 10);
+        break;
+        case 'r':
+          options.resolution = strtoul (optarg, nullptr, 10);
+        break;
+        case 't':
+          options.textures = strtoul (optarg, nullptr, 10);
+        break;
+        case 'l':
+          options.lights = strtoul (optarg, nullptr, 10);
+        break;
+        case 's':
+          options.seed = strtoul (optarg, nullptr, 10);
+        break;
+        default:
+          usage ();
+      }
+  if (argc - optind != 1 || options.models == 0 || options.resolution == 0)
+    usage ();
+
+  const std::filesystem::path scene = argv[optind];
+  const std::filesystem::path directory = scene.has_parent_path () ? scene.parent_path () : ".";
+  const uint64_t groups = scene_synth_write (directory.string (), scene.filename ().string (), options);
+  printf ("%llu\n", (unsigned long long) groups);
+  return EXIT_SUCCESS;
+}
+
+//!@} end of group scenegen
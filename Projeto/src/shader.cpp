@@ -0,0 +1,303 @@
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
+#include "shader.h"
+
+using glm::mat3, glm::mat4, glm::vec4, glm::vec3, glm::value_ptr;
+using std::cerr, std::endl, std::string, std::vector;
+
+/*! @addtogroup shader
+ * @{
+ * Programmable pipeline backend of the engine.
+ *
+ * The Blinn-Phong program reproduces what the fixed-function pipeline
+ * computes for the engine's models, only per pixel instead of per vertex:
+ * a global ambient light of 1 (GL_LIGHT_MODEL_AMBIENT), lights with a
+ * white diffuse and specular and a black ambient component, an infinite
+ * viewer, spotlights without exponent or attenuation, the lit color clamped
+ * and then modulated by the texture (GL_MODULATE).
+ *
+ * Lights without a range are applied to every fragment. Lights with a range
+ * fade out smoothly, (1 - (d/range)⁴)², reaching zero at it, so they are
+ * culled per cluster (see clusters): a fragment only loops over the lights
+ * of the cluster it falls in. Every light is read from texture buffers:
+ *
+ * @code{.unparsed}
+ * LIGHT_DATA      RGBA32F  3 texels per light, global lights first:
+ *                          eye space position (w = 0 for directional lights)
+ *                          eye space spot direction, cosine of the cutoff (-1 if not a spotlight)
+ *                          range, 0, 0, 0
+ * CLUSTER_RANGES  RG32UI   per cluster, offset into LIGHT_INDICES and count
+ * LIGHT_INDICES   R32UI    light of each cluster entry
+ * @endcode
+ */
+
+static const char *const PHONG_VERTEX_SOURCE = R"(
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal; // octahedral in xy when quantized
+layout (location = 2) in vec2 texcoord;
+
+uniform mat4 projection;
+uniform mat4 modelview;
+uniform mat3 normal_matrix;
+// quantized positions are normalized over the bounds of the model, 0 and 1 for floats
+uniform bool quantized;
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
+out vec3 eye_position;
+out vec3 eye_normal;
+out vec2 uv;
+
+vec3 octahedral_decode (vec2 e)
+{
+  vec3 n = vec3 (e, 1.0 - abs (e.x) - abs (e.y));
+  float t = max (-n.z, 0.0);
+  n.xy += vec2 (n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize (n);
+}
+
+void main ()
+{
+  vec4 p = modelview * vec4 (position_offset + position_scale * position, 1.0);
+  eye_position = p.xyz;
+  eye_normal = normal_matrix * (quantized ? octahedral_decode (normal.xy) : normal);
+  uv = texcoord;
+  gl_Position = projection * p;
+}
+)";
+
+static const char *const PHONG_FRAGMENT_SOURCE = R"(
+uniform vec4 diffuse;
+uniform vec4 ambient;
+uniform vec4 specular;
+uniform vec4 emissive;
+uniform float shininess;
+
+uniform bool lighting; // when disabled the diffuse color is drawn as is
+uniform bool textured;
+uniform sampler2D texture_unit;
+
+uniform samplerBuffer light_data;
+uniform usamplerBuffer cluster_ranges;
+uniform usamplerBuffer light_indices;
+uniform int global_light_count;
+uniform vec2 cluster_tile_size; // in pixels
+uniform float cluster_near;
+uniform float cluster_scale;    // depth slices per unit of log (depth / near)
+
+in vec3 eye_position;
+in vec3 eye_normal;
+in vec2 uv;
+
+out vec4 color;
+
+vec3 shade (int l, vec3 n)
+{
+  vec4 position = texelFetch (light_data, 3 * l);
+  vec4 spot = texelFetch (light_data, 3 * l + 1);
+  float range = texelFetch (light_data, 3 * l + 2).x;
+
+  vec3 to_light = position.xyz - eye_position * position.w;
+  float distance = length (to_light);
+  to_light /= distance;
+  if (dot (-to_light, spot.xyz) < spot.w)
+    return vec3 (0.0);
+  float n_dot_l = dot (n, to_light);
+  if (n_dot_l <= 0.0)
+    return vec3 (0.0);
+
+  float attenuation = 1.0;
+  if (range > 0.0)
+    {
+      float x = distance / range;
+      attenuation = clamp (1.0 - x * x * x * x, 0.0, 1.0);
+      attenuation *= attenuation;
+    }
+  vec3 h = normalize (to_light + vec3 (0.0, 0.0, 1.0));
+  float n_dot_h = max (dot (n, h), 0.0);
+  return attenuation * (n_dot_l * diffuse.rgb + (shininess == 0.0 ? 1.0 : pow (n_dot_h, shininess)) * specular.rgb);
+}
+
+void main ()
+{
+  vec4 lit = diffuse;
+  if (lighting)
+    {
+      vec3 n = normalize (eye_normal);
+      vec3 sum = emissive.rgb + ambient.rgb;
+      for (int l = 0; l < global_light_count; ++l)
+        sum += shade (l, n);
+
+      ivec3 cluster = ivec3 (vec3 (gl_FragCoord.xy / cluster_tile_size,
+                                   log (-eye_position.z / cluster_near) * cluster_scale));
+      cluster = clamp (cluster, ivec3 (0), ivec3 (CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z) - 1);
+      uvec2 range = texelFetch (cluster_ranges, (cluster.z * CLUSTERS_Y + cluster.y) * CLUSTERS_X + cluster.x).xy;
+      for (uint i = 0u; i < range.y; ++i)
+        sum += shade (int (texelFetch (light_indices, int (range.x + i)).x), n);
+
+      lit = vec4 (clamp (sum, 0.0, 1.0), diffuse.a);
+    }
+  color = textured ? lit * texture (texture_unit, uv) : lit;
+}
+)";
+
+static GLuint shader_compile (const GLenum type, const string &source)
+{
+  const GLuint shader = glCreateShader (type);
+  const char *const text = source.c_str ();
+  glShaderSource (shader, 1, &text, nullptr);
+  glCompileShader (shader);
+
+  GLint compiled;
+  glGetShaderiv (shader, GL_COMPILE_STATUS, &compiled);
+  if (!compiled)
+    {
+      char log[1024];
+      glGetShaderInfoLog (shader, sizeof (log), nullptr, log);
+      cerr << "[shader] failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
+           << " shader:\n" << log << endl;
+      exit (EXIT_FAILURE);
+    }
+  return shader;
+}
+
+/*!
+ * Compiles and links a program, exiting on errors.
+ * @param[in] vertex_source,fragment_source GLSL sources, without the #version line.
+ */
+GLuint shader_program (const char *const vertex_source, const char *const fragment_source)
+{
+  const string header = "#version 330 core\n"
+                        "#define CLUSTERS_X " + std::to_string (CLUSTERS_X) + "\n"
+                        "#define CLUSTERS_Y " + std::to_string (CLUSTERS_Y) + "\n"
+                        "#define CLUSTERS_Z " + std::to_string (CLUSTERS_Z) + "\n";
+  const GLuint vertex = shader_compile (GL_VERTEX_SHADER, header + vertex_source);
+  const GLuint fragment = shader_compile (GL_FRAGMENT_SHADER, header + fragment_source);
+
+  const GLuint program = glCreateProgram ();
+  glAttachShader (program, vertex);
+  glAttachShader (program, fragment);
+  glLinkProgram (program);
+  glDeleteShader (vertex);
+  glDeleteShader (fragment);
+
+  GLint linked;
+  glGetProgramiv (program, GL_LINK_STATUS, &linked);
+  if (!linked)
+    {
+      char log[1024];
+      glGetProgramInfoLog (program, sizeof (log), nullptr, log);
+      cerr << "[shader] failed to link program:\n" << log << endl;
+      exit (EXIT_FAILURE);
+    }
+  return program;
+}
+
+struct phong_program phong_program_create ()
+{
+  struct phong_program phong;
+  phong.program = shader_program (PHONG_VERTEX_SOURCE, PHONG_FRAGMENT_SOURCE);
+  phong.projection = glGetUniformLocation (phong.program, "projection");
+  phong.modelview = glGetUniformLocation (phong.program, "modelview");
+  phong.normal_matrix = glGetUniformLocation (phong.program, "normal_matrix");
+  phong.quantized = glGetUniformLocation (phong.program, "quantized");
+  phong.position_offset = glGetUniformLocation (phong.program, "position_offset");
+  phong.position_scale = glGetUniformLocation (phong.program, "position_scale");
+  phong.diffuse = glGetUniformLocation (phong.program, "diffuse");
+  phong.ambient = glGetUniformLocation (phong.program, "ambient");
+  phong.specular = glGetUniformLocation (phong.program, "specular");
+  phong.emissive = glGetUniformLocation (phong.program, "emissive");
+  phong.shininess = glGetUniformLocation (phong.program, "shininess");
+  phong.lighting = glGetUniformLocation (phong.program, "lighting");
+  phong.textured = glGetUniformLocation (phong.program, "textured");
+  phong.global_light_count = glGetUniformLocation (phong.program, "global_light_count");
+  phong.cluster_tile_size = glGetUniformLocation (phong.program, "cluster_tile_size");
+  phong.cluster_near = glGetUniformLocation (phong.program, "cluster_near");
+  phong.cluster_scale = glGetUniformLocation (phong.program, "cluster_scale");
+
+  glUseProgram (phong.program);
+  glUniform1i (glGetUniformLocation (phong.program, "texture_unit"), 0);
+  glUniform1i (glGetUniformLocation (phong.program, "light_data"), 1 + LIGHT_DATA);
+  glUniform1i (glGetUniformLocation (phong.program, "cluster_ranges"), 1 + CLUSTER_RANGES);
+  glUniform1i (glGetUniformLocation (phong.program, "light_indices"), 1 + LIGHT_INDICES);
+  glUniform1i (phong.lighting, GL_TRUE);
+  glUniform3f (phong.position_scale, 1, 1, 1);
+  glUseProgram (0);
+
+  const GLenum formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R32UI};
+  glGenBuffers (3, phong.buffers);
+  glGenTextures (3, phong.textures);
+  for (int b = 0; b < 3; ++b)
+    {
+      glBindBuffer (GL_TEXTURE_BUFFER, phong.buffers[b]);
+      glBufferData (GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+      glBindTexture (GL_TEXTURE_BUFFER, phong.textures[b]);
+      glTexBuffer (GL_TEXTURE_BUFFER, formats[b], phong.buffers[b]);
+    }
+  glBindTexture (GL_TEXTURE_BUFFER, 0);
+  glBindBuffer (GL_TEXTURE_BUFFER, 0);
+  return phong;
+}
+
+static void phong_upload (const GLuint buffer, const void *const data, const size_t size)
+{
+  glBindBuffer (GL_TEXTURE_BUFFER, buffer);
+  // orphan the previous frame's storage instead of waiting for draws still reading it
+  glBufferData (GL_TEXTURE_BUFFER, (GLsizeiptr) std::max<size_t> (size, 16), nullptr, GL_STREAM_DRAW);
+  if (size)
+    glBufferSubData (GL_TEXTURE_BUFFER, 0, (GLsizeiptr) size, data);
+}
+
+/*!
+ * Transforms the lights to eye space, assigns the ranged ones to clusters and
+ * uploads everything to the (bound) program.
+ * @param[in,out] grid built for the current projection, assigned the lights.
+ * @param[in] width,height of the viewport.
+ */
+void phong_set_lights (const struct phong_program &phong, const vector<struct light> &lights, const mat4 &view,
+                       struct cluster_grid &grid, const int width, const int height)
+{
+  static vector<vec4> data;
+  static vector<struct cluster_light> ranged;
+  data.clear ();
+  ranged.clear ();
+
+  // global lights first, then the ones culled per cluster
+  for (const bool is_ranged: {false, true})
+    for (const struct light &light: lights)
+      {
+        if ((light.type != LIGHT_DIRECTIONAL && light.range > 0) != is_ranged)
+          continue;
+        const vec4 position = view * light.position;
+        const float cos_cutoff = light.type == LIGHT_SPOT && light.cutoff < 180
+                                 ? cosf (glm::radians (light.cutoff))
+                                 : -1.0f;
+        data.push_back (position);
+        data.emplace_back (glm::normalize (mat3 (view) * light.direction), cos_cutoff);
+        data.emplace_back (is_ranged ? light.range : 0, 0, 0, 0);
+        if (is_ranged)
+          ranged.push_back ({vec3 (position), light.range});
+      }
+  const auto global_count = (GLint) (lights.size () - ranged.size ());
+  clusters_assign (grid, ranged, global_count);
+
+  phong_upload (phong.buffers[LIGHT_DATA], data.data (), data.size () * sizeof (vec4));
+  phong_upload (phong.buffers[CLUSTER_RANGES], grid.ranges.data (), grid.ranges.size () * sizeof (uint32_t));
+  phong_upload (phong.buffers[LIGHT_INDICES], grid.indices.data (), grid.indices.size () * sizeof (uint32_t));
+  glBindBuffer (GL_TEXTURE_BUFFER, 0);
+  for (int b = 0; b < 3; ++b)
+    {
+      glActiveTexture (GL_TEXTURE1 + b);
+      glBindTexture (GL_TEXTURE_BUFFER, phong.textures[b]);
+    }
+  glActiveTexture (GL_TEXTURE0);
+
+  glUniform1i (phong.global_light_count, global_count);
+  glUniform2f (phong.cluster_tile_size, (float) width / CLUSTERS_X, (float) height / CLUSTERS_Y);
+  glUniform1f (phong.cluster_near, grid.near);
+  glUniform1f (phong.cluster_scale, CLUSTERS_Z / logf (grid.far / grid.near));
+}
+
+//!@} end of group shader
@@ -0,0 +1,59 @@
+#ifndef _SHADER_H_
+#define _SHADER_H_
+#include <vector>
+#ifdef __APPLE__
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+#include <glm/glm.hpp>
+#include "clusters.h"
+
+enum {
+  LIGHT_POINT = 0,
+  LIGHT_DIRECTIONAL,
+  LIGHT_SPOT
+};
+
+//! Light source as given in the scene file, in world space.
+struct light {
+  int type = LIGHT_POINT;
+  glm::vec4 position{0, 0, 0, 1}; // w = 0 for directional lights, xyz then being the direction towards the light
+  glm::vec3 direction{0, 0, -1};  // spotlights only
+  float cutoff = 180;             // spotlights only, in degrees
+  float range = 0;                // point and spotlights, 0 meaning unattenuated and reaching everything
+};
+
+//! Vertex attribute locations shared by every program.
+enum {
+  ATTRIBUTE_POSITION = 0,
+  ATTRIBUTE_NORMAL,
+  ATTRIBUTE_TEXCOORD
+};
+
+//! Texture buffers the lights are read from, in texture units 1 to 3.
+enum {
+  LIGHT_DATA = 0,
+  CLUSTER_RANGES,
+  LIGHT_INDICES
+};
+
+//! Per-pixel Blinn-Phong program and its uniform locations.
+struct phong_program {
+  GLuint program = 0;
+  GLint projection = -1, modelview = -1, normal_matrix = -1;
+  GLint quantized = -1, position_offset = -1, position_scale = -1;
+  GLint diffuse = -1, ambient = -1, specular = -1, emissive = -1, shininess = -1;
+  GLint lighting = -1, textured = -1;
+  GLint global_light_count = -1, cluster_tile_size = -1, cluster_near = -1, cluster_scale = -1;
+
+  // indexed by LIGHT_DATA, CLUSTER_RANGES and LIGHT_INDICES
+  GLuint buffers[3] = {};
+  GLuint textures[3] = {};
+};
+
+GLuint shader_program (const char *vertex_source, const char *fragment_source);
+struct phong_program phong_program_create ();
+void phong_set_lights (const struct phong_program &phong, const std::vector<struct light> &lights,
+                       const glm::mat4 &view, struct cluster_grid &grid, int width, int height);
+#endif //_SHADER_H_
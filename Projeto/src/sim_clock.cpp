@@ -0,0 +1,55 @@
+#include <chrono>
+#include <cmath>
+#include "sim_clock.h"
+
+/*! @addtogroup simClock
+ * @{
+ * Every animation of a frame reads the same timestamp, taken once when the
+ * frame starts, instead of asking GLUT for the time at each animated node.
+ * Time is kept in double precision seconds, which stays exact to the
+ * microsecond for over a century of uptime, unlike milliseconds in a float.
+ *
+ * With a fixed step the simulation no longer depends on how long frames
+ * take, so a given frame number always shows the same scene: what
+ * benchmarks and image comparisons need.
+ */
+
+//! Monotonic real time, in seconds since an unspecified point.
+double sim_clock_real_seconds ()
+{
+  using namespace std::chrono;
+  return duration<double> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+//! Advances the clock to a new frame, to be called once at the start of each one.
+void sim_clock_tick (struct sim_clock &clock, const double real_seconds)
+{
+  const bool first = clock.last_real < 0;
+  const double real_delta = first ? 0 : real_seconds - clock.last_real;
+  clock.last_real = real_seconds;
+  ++clock.frame;
+
+  // the first frame shows the time the clock starts at
+  if (clock.paused || first)
+    clock.delta = 0;
+  else
+    clock.delta = (clock.fixed_step > 0 ? clock.fixed_step : real_delta) * clock.scale;
+  clock.time += clock.delta;
+}
+
+//! Jumps to a simulation time, clamped at 0.
+void sim_clock_seek (struct sim_clock &clock, const double time)
+{
+  clock.time = fmax (time, 0);
+  clock.delta = 0;
+}
+
+//! @return how far into a period of that many seconds the clock is, in [0, 1).
+double sim_clock_phase (const struct sim_clock &clock, const double period)
+{
+  if (period <= 0)
+    return 0;
+  return fmod (clock.time, period) / period;
+}
+
+//!@} end of group simClock
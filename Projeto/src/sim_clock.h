@@ -0,0 +1,21 @@
+#ifndef _SIM_CLOCK_H_
+#define _SIM_CLOCK_H_
+#include <cstdint>
+
+//! Simulation time of the engine, advanced once per frame.
+struct sim_clock {
+  double time = 0;       // simulation seconds at the current frame
+  double delta = 0;      // simulation seconds since the previous frame
+  double scale = 1;      // simulation seconds per real second
+  double fixed_step = 0; // when positive, every frame advances this many seconds (times scale) regardless of real time
+  bool paused = false;
+  uint64_t frame = 0;    // number of ticks so far
+
+  double last_real = -1; // real seconds at the previous tick
+};
+
+double sim_clock_real_seconds ();
+void sim_clock_tick (struct sim_clock &clock, double real_seconds);
+void sim_clock_seek (struct sim_clock &clock, double time);
+double sim_clock_phase (const struct sim_clock &clock, double period);
+#endif //_SIM_CLOCK_H_
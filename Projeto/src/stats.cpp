@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cinttypes>
+#include "stats.h"
+
+using std::vector;
+
+/*! @addtogroup stats
+ * @{
+ * Per-frame counters of the engine, and the distribution of its frame times.
+ *
+ * An average frame rate hides stutter: a frame in a hundred taking three times
+ * longer barely moves it, but shows in the 99th percentile.
+ */
+
+void frame_history_push (struct frame_history &history, const double ms)
+{
+  if (history.ms.size () < FRAME_HISTORY)
+    history.ms.push_back (ms);
+  else
+    history.ms[history.next] = ms;
+  history.next = (history.next + 1) % FRAME_HISTORY;
+}
+
+//! Nearest-rank percentile of sorted values, p in [0, 1].
+static double percentile (const vector<double> &sorted, const double p)
+{
+  const size_t rank = (size_t) (p * (double) (sorted.size () - 1) + 0.5);
+  return sorted[rank];
+}
+
+struct frame_time_summary frame_history_summary (const struct frame_history &history)
+{
+  struct frame_time_summary summary;
+  if (history.ms.empty ())
+    return summary;
+
+  vector<double> sorted = history.ms;
+  std::sort (sorted.begin (), sorted.end ());
+  double total = 0;
+  for (const double ms: sorted)
+    total += ms;
+  summary.min = sorted.front ();
+  summary.avg = total / (double) sorted.size ();
+  summary.p95 = percentile (sorted, 0.95);
+  summary.p99 = percentile (sorted, 0.99);
+  return summary;
+}
+
+void stats_csv_header (FILE *const file)
+{
+  fprintf (file, "frame,frame_ms,draw_calls,triangles,state_changes,visible,culled,texture_bytes,buffer_bytes,interval_ms\n");
+}
+
+void stats_csv_row (FILE *const file, const struct frame_counters &counters)
+{
+  fprintf (file, "%" PRIu64 ",%.3f,%u,%u,%u,%u,%u,%" PRIu64 ",%" PRIu64 ",%.3f\n",
+           counters.frame, counters.frame_ms, counters.draw_calls, counters.triangles, counters.state_changes,
+           counters.visible, counters.culled, counters.texture_bytes, counters.buffer_bytes, counters.interval_ms);
+}
+
+//!@} end of group stats
@@ -0,0 +1,40 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+const unsigned int FRAME_HISTORY = 240; // frames the percentiles are taken over
+
+//! Counters of one frame, as shown by the overlay and written to CSV.
+struct frame_counters {
+  uint64_t frame = 0;
+  double frame_ms = 0;    // real time from the beginning of the frame to its swap
+  double interval_ms = 0; // real time since the previous frame, 0 when it waited for input
+  unsigned int draw_calls = 0;
+  unsigned int triangles = 0;
+  unsigned int state_changes = 0; // texture binds and material changes
+  unsigned int visible = 0;       // models drawn
+  unsigned int culled = 0;        // models outside the view frustum
+  uint64_t texture_bytes = 0;
+  uint64_t buffer_bytes = 0;
+};
+
+//! Times of the last FRAME_HISTORY frames, in milliseconds.
+struct frame_history {
+  std::vector<double> ms;
+  unsigned int next = 0;
+};
+
+struct frame_time_summary {
+  double min = 0;
+  double avg = 0;
+  double p95 = 0;
+  double p99 = 0;
+};
+
+void frame_history_push (struct frame_history &history, double ms);
+struct frame_time_summary frame_history_summary (const struct frame_history &history);
+void stats_csv_header (FILE *file);
+void stats_csv_row (FILE *file, const struct frame_counters &counters);
+#endif //_STATS_H_
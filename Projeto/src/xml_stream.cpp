@@ -0,0 +1,503 @@
+#include <algorithm>
+#include <cstring>
+
+#include "xml_stream.h"
+
+using std::string;
+
+/*! @addtogroup xmlStream
+ * @{
+ * Reads XML as a stream of element start and end events, so that files much larger
+ * than memory can be walked in a single pass.
+ *
+ * Only what the scene files need is kept: elements, with their attributes, and the
+ * nesting they must respect. Text, comments, CDATA sections, processing instructions
+ * and the document type declaration are skipped over. The file is read a buffer at a
+ * time, and the name, attribute and open element strings keep their storage from an
+ * event to the next, so the memory used is bounded by the largest tag and the depth
+ * of the document, never by its size.
+ *
+ * Names, attribute values and text are scanned for where they end a buffer at a
+ * time rather than a character at a time, and lines are only counted a buffer at a
+ * time, or up to where an error is found, as they are of no use otherwise.
+ *
+ * Errors tell the line they were found at, and leave the stream at XML_ERROR.
+ */
+
+const size_t XML_STREAM_BUFFER = 64 << 10;
+
+static bool xml_stream_fill (struct xml_stream &stream)
+{
+  const char *const buffer = stream.buffer.get ();
+  stream.lines += (unsigned int) std::count (buffer, buffer + stream.end, '\n');
+  stream.offset += stream.end;
+  stream.begin = stream.line_begin = 0;
+  stream.line_newlines = 0;
+  stream.end = fread (stream.buffer.get (), 1, std::min (XML_STREAM_BUFFER, stream.remaining), stream.fp);
+  stream.remaining -= stream.end;
+  if (!stream.end && ferror (stream.fp) && stream.error.empty ())
+    stream.error = "read error at line " + std::to_string (xml_stream_line (stream));
+  return stream.end > 0;
+}
+
+//! The next character, or EOF.
+static int xml_stream_peek (struct xml_stream &stream)
+{
+  if (stream.begin == stream.end && !xml_stream_fill (stream))
+    return EOF;
+  return (unsigned char) stream.buffer[stream.begin];
+}
+
+static int xml_stream_get (struct xml_stream &stream)
+{
+  const int c = xml_stream_peek (stream);
+  if (c != EOF)
+    ++stream.begin;
+  return c;
+}
+
+/*!
+ * Reads up to the first character that stop is true for, or the end of the file,
+ * appending what it read to a string if given one.
+ */
+template<typename Stop>
+static void xml_stream_take (struct xml_stream &stream, string *const taken, const Stop stop)
+{
+  while (stream.begin < stream.end || xml_stream_fill (stream))
+    {
+      const char *const first = stream.buffer.get () + stream.begin;
+      const char *const last = stream.buffer.get () + stream.end;
+      const char *const found = std::find_if (first, last, [stop] (const char c)
+      { return stop ((unsigned char) c); });
+      if (taken)
+        taken->append (first, found);
+      stream.begin += found - first;
+      if (found != last)
+        return;
+    }
+}
+
+//! Keeps the first error, a read error over what it caused.
+static enum xml_event xml_stream_fail (struct xml_stream &stream, const string &message)
+{
+  if (stream.error.empty ())
+    stream.error = "line " + std::to_string (xml_stream_line (stream)) + ": " + message;
+  return XML_ERROR;
+}
+
+static bool xml_stream_space (const int c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static void xml_stream_skip_space (struct xml_stream &stream)
+{
+  xml_stream_take (stream, nullptr, [] (const int c)
+  { return !xml_stream_space (c); });
+}
+
+static bool xml_stream_name_char (const int c)
+{
+  return c != EOF && !xml_stream_space (c) && c != '/' && c != '>' && c != '=' && c != '<' && c != '"' && c != '\'';
+}
+
+static void xml_stream_read_name (struct xml_stream &stream, string &name)
+{
+  name.clear ();
+  xml_stream_take (stream, &name, [] (const int c)
+  { return !xml_stream_name_char (c); });
+}
+
+//! Reads up to and including a terminator of at most 3 characters, false at the end of the file.
+static bool xml_stream_skip_past (struct xml_stream &stream, const char *const terminator)
+{
+  const size_t length = strlen (terminator);
+  char last[4] = {};
+  for (int c; (c = xml_stream_get (stream)) != EOF;)
+    {
+      memmove (last, last + 1, 2);
+      last[2] = (char) c;
+      if (!memcmp (last + 3 - length, terminator, length))
+        return true;
+    }
+  return false;
+}
+
+//! Skips a document type declaration, up to the '>' closing it, past any internal subset.
+static bool xml_stream_skip_declaration (struct xml_stream &stream)
+{
+  int brackets = 0;
+  for (int c; (c = xml_stream_get (stream)) != EOF;)
+    if (c == '[')
+      ++brackets;
+    else if (c == ']')
+      --brackets;
+    else if (c == '>' && brackets <= 0)
+      return true;
+  return false;
+}
+
+static void xml_stream_append_utf8 (string &value, const unsigned long code)
+{
+  if (code < 0x80)
+    value.push_back ((char) code);
+  else if (code < 0x800)
+    {
+      value.push_back ((char) (0xc0 | code >> 6));
+      value.push_back ((char) (0x80 | (code & 0x3f)));
+    }
+  else if (code < 0x10000)
+    {
+      value.push_back ((char) (0xe0 | code >> 12));
+      value.push_back ((char) (0x80 | (code >> 6 & 0x3f)));
+      value.push_back ((char) (0x80 | (code & 0x3f)));
+    }
+  else
+    {
+      value.push_back ((char) (0xf0 | code >> 18));
+      value.push_back ((char) (0x80 | (code >> 12 & 0x3f)));
+      value.push_back ((char) (0x80 | (code >> 6 & 0x3f)));
+      value.push_back ((char) (0x80 | (code & 0x3f)));
+    }
+}
+
+//! Appends what the entity after an '&' stands for, or the entity itself when it is not known.
+static void xml_stream_read_entity (struct xml_stream &stream, string &value)
+{
+  const size_t ENTITY_MAX = 10;
+  char entity[ENTITY_MAX + 1];
+  size_t length = 0;
+  int c;
+  while (length < ENTITY_MAX && (c = xml_stream_peek (stream)) != EOF && c != ';' && c != '"' && c != '\''
+         && c != '&')
+    entity[length++] = (char) xml_stream_get (stream);
+  entity[length] = '\0';
+  const bool terminated = xml_stream_peek (stream) == ';';
+  if (terminated)
+    {
+      xml_stream_get (stream);
+      const char *const names[] = {"lt", "gt", "amp", "quot", "apos"};
+      const char characters[] = {'<', '>', '&', '"', '\''};
+      for (size_t e = 0; e < 5; ++e)
+        if (!strcmp (entity, names[e]))
+          {
+            value.push_back (characters[e]);
+            return;
+          }
+      if (entity[0] == '#')
+        {
+          const bool hexadecimal = entity[1] == 'x';
+          char *end;
+          const unsigned long code = strtoul (entity + 1 + hexadecimal, &end, hexadecimal ? 16 : 10);
+          if (end != entity + 1 + hexadecimal && !*end && code <= 0x10ffff)
+            {
+              xml_stream_append_utf8 (value, code);
+              return;
+            }
+        }
+    }
+  value.push_back ('&');
+  value.append (entity, length);
+  if (terminated)
+    value.push_back (';');
+}
+
+//! Skips a comment, CDATA section, declaration or processing instruction, from right after its '<'.
+static bool xml_stream_skip_markup (struct xml_stream &stream)
+{
+  bool closed;
+  if (xml_stream_get (stream) == '?')
+    closed = xml_stream_skip_past (stream, "?>");
+  else if (xml_stream_peek (stream) == '-')
+    {
+      xml_stream_get (stream);
+      if (xml_stream_get (stream) != '-')
+        {
+          xml_stream_fail (stream, "malformed comment");
+          return false;
+        }
+      closed = xml_stream_skip_past (stream, "-->");
+    }
+  else if (xml_stream_peek (stream) == '[')
+    closed = xml_stream_skip_past (stream, "]]>");
+  else
+    closed = xml_stream_skip_declaration (stream);
+  if (!closed)
+    xml_stream_fail (stream, "unexpected end of file in a comment, declaration or processing instruction");
+  return closed;
+}
+
+/*!
+ * Skips the rest of a start tag, from right after its name, attributes being of no
+ * interest; '>' may well be in their values.
+ * @param[out] empty whether the element is, so has no end tag.
+ */
+static bool xml_stream_skip_tag (struct xml_stream &stream, bool &empty)
+{
+  char quote = 0, last = 0;
+  while (stream.begin < stream.end || xml_stream_fill (stream))
+    {
+      const char *const buffer = stream.buffer.get ();
+      for (size_t i = stream.begin; i < stream.end; ++i)
+        {
+          const char c = buffer[i];
+          if (quote)
+            quote = c == quote ? 0 : quote;
+          else if (c == '"' || c == '\'')
+            quote = c;
+          else if (c == '>')
+            {
+              empty = last == '/';
+              stream.begin = i + 1;
+              return true;
+            }
+          last = c;
+        }
+      stream.begin = stream.end;
+    }
+  xml_stream_fail (stream, "unexpected end of file in a start tag");
+  return false;
+}
+
+static enum xml_event xml_stream_read_attribute (struct xml_stream &stream)
+{
+  if (stream.attribute_count == stream.attributes.size ())
+    stream.attributes.emplace_back ();
+  struct xml_attribute &attribute = stream.attributes[stream.attribute_count++];
+  xml_stream_read_name (stream, attribute.name);
+  if (attribute.name.empty ())
+    return xml_stream_fail (stream, "unexpected character in <" + stream.name + ">");
+  xml_stream_skip_space (stream);
+  if (xml_stream_get (stream) != '=')
+    return xml_stream_fail (stream, "attribute " + attribute.name + " of <" + stream.name + "> has no value");
+  xml_stream_skip_space (stream);
+  const int quote = xml_stream_get (stream);
+  if (quote != '"' && quote != '\'')
+    return xml_stream_fail (stream, "value of attribute " + attribute.name + " of <" + stream.name + "> is not quoted");
+  attribute.value.clear ();
+  for (;;)
+    {
+      xml_stream_take (stream, &attribute.value, [quote] (const int c)
+      { return c == quote || c == '&'; });
+      const int c = xml_stream_get (stream);
+      if (c == quote)
+        return XML_START;
+      if (c == EOF)
+        return xml_stream_fail (stream, "unexpected end of file in <" + stream.name + ">");
+      xml_stream_read_entity (stream, attribute.value);
+    }
+}
+
+static enum xml_event xml_stream_read_start (struct xml_stream &stream)
+{
+  xml_stream_read_name (stream, stream.name);
+  if (stream.name.empty ())
+    return xml_stream_fail (stream, "expected an element name after '<'");
+  stream.attribute_count = 0;
+  for (;;)
+    {
+      xml_stream_skip_space (stream);
+      const int c = xml_stream_peek (stream);
+      if (c == '>' || c == '/')
+        {
+          xml_stream_get (stream);
+          if (c == '/' && xml_stream_get (stream) != '>')
+            return xml_stream_fail (stream, "expected '>' after '/' in <" + stream.name + ">");
+          stream.root = true;
+          stream.closing = c == '/';
+          if (!stream.closing)
+            {
+              if (stream.depth == stream.open.size ())
+                stream.open.emplace_back ();
+              stream.open[stream.depth++] = stream.name;
+            }
+          return XML_START;
+        }
+      if (c == EOF)
+        return xml_stream_fail (stream, "unexpected end of file in <" + stream.name + ">");
+      if (xml_stream_read_attribute (stream) == XML_ERROR)
+        return XML_ERROR;
+    }
+}
+
+static enum xml_event xml_stream_read_end (struct xml_stream &stream)
+{
+  xml_stream_read_name (stream, stream.name);
+  xml_stream_skip_space (stream);
+  if (xml_stream_get (stream) != '>')
+    return xml_stream_fail (stream, "expected '>' after </" + stream.name);
+  if (!stream.depth)
+    return xml_stream_fail (stream, "</" + stream.name + "> closes no element");
+  if (stream.open[stream.depth - 1] != stream.name)
+    return xml_stream_fail (stream, "</" + stream.name + "> does not close <" + stream.open[stream.depth - 1] + ">");
+  --stream.depth;
+  stream.attribute_count = 0;
+  return XML_END;
+}
+
+//! @return whether the file could be opened, the error in the stream otherwise.
+bool xml_stream_open (struct xml_stream &stream, const string &filename)
+{
+  xml_stream_close (stream);
+  stream = xml_stream ();
+  stream.fp = fopen (filename.c_str (), "rb");
+  if (!stream.fp)
+    {
+      stream.error = "failed opening '" + filename + "'";
+      return false;
+    }
+  stream.buffer = std::make_unique<char[]> (XML_STREAM_BUFFER);
+  return true;
+}
+
+/*!
+ * Opens a stream over the content of an element, as split off by xml_stream_skip:
+ * from right after its start tag up to and including its end tag. The stream may
+ * be one already open on the same file.
+ * @param[in] line of the offset, for errors.
+ * @param[in] inside name of the element, taken as open.
+ */
+bool xml_stream_open_range (struct xml_stream &stream, const string &filename, const size_t offset,
+                            const size_t length, const unsigned int line, const string &inside)
+{
+  // a stream already open on the file is moved rather than opened again, keeping its storage
+  if (!stream.fp && !xml_stream_open (stream, filename))
+    return false;
+  if (fseek (stream.fp, (long) offset, SEEK_SET))
+    {
+      stream.error = "failed seeking in '" + filename + "'";
+      return false;
+    }
+  stream.begin = stream.end = stream.line_begin = 0;
+  stream.offset = offset;
+  stream.remaining = length;
+  stream.lines = line - 1;
+  stream.line_newlines = 0;
+  stream.attribute_count = 0;
+  if (stream.open.empty ())
+    stream.open.emplace_back ();
+  stream.open[0] = inside;
+  stream.depth = 1;
+  stream.closing = false;
+  stream.root = true;
+  stream.error.clear ();
+  return true;
+}
+
+/*!
+ * Reads up to the next element event. An empty element gives an XML_END right after
+ * its XML_START, keeping its name.
+ */
+enum xml_event xml_stream_next (struct xml_stream &stream)
+{
+  if (!stream.error.empty ())
+    return XML_ERROR;
+  if (stream.closing)
+    {
+      stream.closing = false;
+      stream.attribute_count = 0;
+      return XML_END;
+    }
+  for (;;)
+    {
+      // text is of no use
+      xml_stream_take (stream, nullptr, [] (const int c)
+      { return c == '<'; });
+      if (xml_stream_get (stream) == EOF)
+        {
+          if (!stream.error.empty ())
+            return XML_ERROR;
+          if (stream.depth)
+            return xml_stream_fail (stream, "unexpected end of file, <" + stream.open[stream.depth - 1]
+                                            + "> is not closed");
+          if (!stream.root)
+            return xml_stream_fail (stream, "no element found");
+          return XML_EOF;
+        }
+
+      const int c = xml_stream_peek (stream);
+      if (c == '/')
+        {
+          xml_stream_get (stream);
+          return xml_stream_read_end (stream);
+        }
+      if (c != '?' && c != '!')
+        return xml_stream_read_start (stream);
+      if (!xml_stream_skip_markup (stream))
+        return XML_ERROR;
+    }
+}
+
+/*!
+ * Skips what is left of the element just started, up to and including its end tag,
+ * without a look at the elements inside but for their nesting; much faster than
+ * reading them.
+ * @return false when the file ends first, the error in the stream.
+ */
+bool xml_stream_skip (struct xml_stream &stream)
+{
+  if (stream.closing)
+    {
+      stream.closing = false;
+      return true;
+    }
+  for (unsigned int depth = 1; depth;)
+    {
+      xml_stream_take (stream, nullptr, [] (const int c)
+      { return c == '<'; });
+      if (xml_stream_get (stream) == EOF)
+        {
+          xml_stream_fail (stream, "unexpected end of file, <" + stream.open[stream.depth - 1] + "> is not closed");
+          return false;
+        }
+      const int c = xml_stream_peek (stream);
+      bool empty = false;
+      if (c == '?' || c == '!')
+        {
+          if (!xml_stream_skip_markup (stream))
+            return false;
+        }
+      else if (!xml_stream_skip_tag (stream, empty))
+        return false;
+      else if (c == '/')
+        --depth;
+      else if (!empty)
+        ++depth;
+    }
+  --stream.depth;
+  stream.attribute_count = 0;
+  return true;
+}
+
+//! Offset in the file of what is read next.
+size_t xml_stream_offset (const struct xml_stream &stream)
+{
+  return stream.offset + stream.begin;
+}
+
+//! Line of what is read next, from 1, counting from where it was last asked for.
+unsigned int xml_stream_line (const struct xml_stream &stream)
+{
+  const char *const buffer = stream.buffer.get ();
+  stream.line_newlines += (unsigned int) std::count (buffer + stream.line_begin, buffer + stream.begin, '\n');
+  stream.line_begin = stream.begin;
+  return stream.lines + 1 + stream.line_newlines;
+}
+
+//! Value of an attribute of the element just started, nullptr when it has none such.
+const char *xml_stream_attribute (const struct xml_stream &stream, const char *const name)
+{
+  for (unsigned int a = 0; a < stream.attribute_count; ++a)
+    if (stream.attributes[a].name == name)
+      return stream.attributes[a].value.c_str ();
+  return nullptr;
+}
+
+void xml_stream_close (struct xml_stream &stream)
+{
+  if (stream.fp)
+    fclose (stream.fp);
+  stream.fp = nullptr;
+}
+
+//!@} end of group xmlStream
@@ -0,0 +1,51 @@
+#ifndef _XML_STREAM_H_
+#define _XML_STREAM_H_
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+//! What xml_stream_next read.
+enum xml_event {
+  XML_START, // an element was opened, its name and attributes in the stream; empty elements are then closed
+  XML_END,   // an element was closed, its name in the stream
+  XML_EOF,
+  XML_ERROR  // the file is not well-formed XML, or could not be read, as told in the stream
+};
+
+struct xml_attribute {
+  std::string name;
+  std::string value; // entities replaced
+};
+
+//! Pull parser reading an XML file a buffer at a time, one element event after another.
+struct xml_stream {
+  FILE *fp = nullptr;
+  std::unique_ptr<char[]> buffer;
+  size_t begin = 0, end = 0;                      // of what is left to read in the buffer
+  size_t offset = 0;                              // in the file, of the buffer
+  size_t remaining = SIZE_MAX;                    // bytes to read after the buffer, for streams over part of a file
+  unsigned int lines = 0;                         // before the buffer
+  mutable size_t line_begin = 0;                  // of the buffer, where lines were last counted up to
+  mutable unsigned int line_newlines = 0;         // in the buffer, up to line_begin
+  std::string name;                               // of the element of the last event
+  std::vector<struct xml_attribute> attributes;   // kept allocated, only the first attribute_count in use
+  unsigned int attribute_count = 0;
+  std::vector<std::string> open;                  // elements not closed yet, kept allocated, only the first depth in use
+  unsigned int depth = 0;
+  bool closing = false;                           // the element last started was empty, its end event comes next
+  bool root = false;                              // an element was read
+  std::string error;
+};
+
+bool xml_stream_open (struct xml_stream &stream, const std::string &filename);
+bool xml_stream_open_range (struct xml_stream &stream, const std::string &filename, size_t offset, size_t length,
+                            unsigned int line, const std::string &inside);
+enum xml_event xml_stream_next (struct xml_stream &stream);
+bool xml_stream_skip (struct xml_stream &stream);
+size_t xml_stream_offset (const struct xml_stream &stream);
+unsigned int xml_stream_line (const struct xml_stream &stream);
+const char *xml_stream_attribute (const struct xml_stream &stream, const char *name);
+void xml_stream_close (struct xml_stream &stream);
+#endif //_XML_STREAM_H_
@@ -0,0 +1,154 @@
+#include <cstring>
+
+#include "xxh64.h"
+
+/*! @addtogroup xxh64
+ * @{
+ * XXH64, the 64 bit hash of xxHash, as its specification describes it, to check
+ * files are whole at gigabytes per second. Written here rather than linked, as
+ * files must hash the same whichever build wrote or reads them.
+ *
+ * Input is consumed in stripes of 32 bytes, 8 into each of four lanes; what is
+ * left of the last stripe, and the number of bytes, are mixed in at the end.
+ */
+
+const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ull;
+const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ull;
+const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t xxh64_rotl (const uint64_t x, const int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+//! Little endian, as the specification reads input.
+static inline uint64_t xxh64_read64 (const uint8_t *const p)
+{
+  uint64_t value;
+  memcpy (&value, p, sizeof (value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64 (value);
+#endif
+  return value;
+}
+
+static inline uint32_t xxh64_read32 (const uint8_t *const p)
+{
+  uint32_t value;
+  memcpy (&value, p, sizeof (value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap32 (value);
+#endif
+  return value;
+}
+
+static inline uint64_t xxh64_round (uint64_t lane, const uint64_t input)
+{
+  lane += input * XXH_PRIME64_2;
+  lane = xxh64_rotl (lane, 31);
+  return lane * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh64_merge_round (uint64_t hash, const uint64_t lane)
+{
+  hash ^= xxh64_round (0, lane);
+  return hash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+//! Consumes whole stripes, returning past them.
+static const uint8_t *xxh64_stripes (uint64_t lanes[4], const uint8_t *p, const uint8_t *const end)
+{
+  for (; p + 32 <= end; p += 32)
+    for (int l = 0; l < 4; ++l)
+      lanes[l] = xxh64_round (lanes[l], xxh64_read64 (p + 8 * l));
+  return p;
+}
+
+void xxh64_reset (struct xxh64_state &state, const uint64_t seed)
+{
+  state = {};
+  state.seed = seed;
+  state.lanes[0] = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+  state.lanes[1] = seed + XXH_PRIME64_2;
+  state.lanes[2] = seed;
+  state.lanes[3] = seed - XXH_PRIME64_1;
+}
+
+void xxh64_update (struct xxh64_state &state, const void *const data, const size_t size)
+{
+  const uint8_t *p = (const uint8_t *) data;
+  const uint8_t *const end = p + size;
+  state.total += size;
+  if (state.buffered + size < 32)
+    {
+      memcpy (state.stripe + state.buffered, p, size);
+      state.buffered += size;
+      return;
+    }
+  if (state.buffered)
+    {
+      const size_t fill = 32 - state.buffered;
+      memcpy (state.stripe + state.buffered, p, fill);
+      xxh64_stripes (state.lanes, state.stripe, state.stripe + 32);
+      p += fill;
+      state.buffered = 0;
+    }
+  p = xxh64_stripes (state.lanes, p, end);
+  memcpy (state.stripe, p, (size_t) (end - p));
+  state.buffered = (size_t) (end - p);
+}
+
+uint64_t xxh64_digest (const struct xxh64_state &state)
+{
+  uint64_t hash;
+  if (state.total >= 32)
+    {
+      const uint64_t *const lanes = state.lanes;
+      hash = xxh64_rotl (lanes[0], 1) + xxh64_rotl (lanes[1], 7) + xxh64_rotl (lanes[2], 12)
+             + xxh64_rotl (lanes[3], 18);
+      for (int l = 0; l < 4; ++l)
+        hash = xxh64_merge_round (hash, lanes[l]);
+    }
+  else
+    hash = state.seed + XXH_PRIME64_5;
+  hash += state.total;
+
+  const uint8_t *p = state.stripe;
+  const uint8_t *const end = p + state.buffered;
+  for (; p + 8 <= end; p += 8)
+    {
+      hash ^= xxh64_round (0, xxh64_read64 (p));
+      hash = xxh64_rotl (hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+  if (p + 4 <= end)
+    {
+      hash ^= (uint64_t) xxh64_read32 (p) * XXH_PRIME64_1;
+      hash = xxh64_rotl (hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+      p += 4;
+    }
+  for (; p < end; ++p)
+    {
+      hash ^= *p * XXH_PRIME64_5;
+      hash = xxh64_rotl (hash, 11) * XXH_PRIME64_1;
+    }
+
+  // avalanche
+  hash ^= hash >> 33;
+  hash *= XXH_PRIME64_2;
+  hash ^= hash >> 29;
+  hash *= XXH_PRIME64_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+uint64_t xxh64 (const void *const data, const size_t size, const uint64_t seed)
+{
+  struct xxh64_state state;
+  xxh64_reset (state, seed);
+  xxh64_update (state, data, size);
+  return xxh64_digest (state);
+}
+
+//! @} end of group xxh64
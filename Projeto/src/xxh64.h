@@ -0,0 +1,19 @@
+#ifndef _XXH64_H_
+#define _XXH64_H_
+#include <cstddef>
+#include <cstdint>
+
+//! XXH64 of data given a piece at a time, as it is read.
+struct xxh64_state {
+  uint64_t seed = 0;
+  uint64_t total = 0; // bytes given so far
+  uint64_t lanes[4] = {};
+  uint8_t stripe[32] = {}; // bytes given but not yet consumed, of a stripe of 32
+  size_t buffered = 0;
+};
+
+void xxh64_reset (struct xxh64_state &state, uint64_t seed = 0);
+void xxh64_update (struct xxh64_state &state, const void *data, size_t size);
+uint64_t xxh64_digest (const struct xxh64_state &state);
+uint64_t xxh64 (const void *data, size_t size, uint64_t seed = 0);
+#endif //_XXH64_H_